@@ -0,0 +1,80 @@
+#! /usr/bin/env python
+"""Compares two mbmore_bench results files (written with
+--benchmark_out=file.json --benchmark_out_format=json) and exits with status 1
+if any benchmark got slower than the threshold allows.
+
+    python bench_compare.py baseline.json contender.json [-t 0.1]
+
+When the benchmarks were repeated (--benchmark_repetitions), the median of
+each benchmark is compared.
+"""
+from __future__ import print_function
+import json
+import sys
+
+try:
+    import argparse as ap
+except ImportError:
+    import pyne._argparse as ap
+
+
+def load_times(path, metric):
+    with open(path) as f:
+        results = json.load(f)
+    times = {}
+    medians = {}
+    for bench in results['benchmarks']:
+        if bench.get('error_occurred'):
+            continue
+        if bench.get('run_type') == 'aggregate':
+            if bench.get('aggregate_name') == 'median':
+                medians[bench['run_name']] = bench[metric]
+            continue
+        # one entry per repetition, keep the first
+        name = bench.get('run_name', bench['name'])
+        times.setdefault(name, bench[metric])
+    times.update(medians)
+    return times
+
+
+def main():
+    description = 'Compare two mbmore_bench JSON results files.'
+    parser = ap.ArgumentParser(description=description)
+    parser.add_argument('baseline', help='results of the reference build')
+    parser.add_argument('contender', help='results of the build to check')
+    parser.add_argument('-t', '--threshold', type=float, default=0.1,
+                        help='largest allowed relative slowdown (0.1 = 10%%)')
+    parser.add_argument('-m', '--metric', default='cpu_time',
+                        choices=['cpu_time', 'real_time'],
+                        help='time to compare')
+    args = parser.parse_args()
+
+    baseline = load_times(args.baseline, args.metric)
+    contender = load_times(args.contender, args.metric)
+
+    regressions = []
+    width = max([len(name) for name in baseline] + [9])
+    print('{0:<{1}} {2:>14} {3:>14} {4:>9}'.format(
+        'Benchmark', width, 'Baseline', 'Contender', 'Change'))
+    for name in sorted(baseline):
+        if name not in contender:
+            print('{0:<{1}} {2:>14.4g} {3:>14} {4:>9}'.format(
+                name, width, baseline[name], '-', 'missing'))
+            continue
+        change = contender[name] / baseline[name] - 1
+        flag = ''
+        if change > args.threshold:
+            regressions.append(name)
+            flag = '  REGRESSION'
+        print('{0:<{1}} {2:>14.4g} {3:>14.4g} {4:>+8.1%}{5}'.format(
+            name, width, baseline[name], contender[name], change, flag))
+
+    if regressions:
+        print('\n{0} benchmark(s) slower than the {1:.0%} threshold'.format(
+            len(regressions), args.threshold))
+        return 1
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
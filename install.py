@@ -57,6 +57,10 @@ def install(args):
             cmake_cmd += ['-DBOOST_ROOT=' + absexpanduser(args.boost_root)]
         if args.build_type:
             cmake_cmd += ['-DCMAKE_BUILD_TYPE=' + args.build_type]
+        if args.timings:
+            cmake_cmd += ['-DMBMORE_TIMINGS=ON']
+        if args.tracing:
+            cmake_cmd += ['-DMBMORE_TRACING=ON']
         check_windows_cmake(cmake_cmd)
         rtn = subprocess.check_call(cmake_cmd, cwd=args.build_dir,
                                     shell=(os.name == 'nt'))
@@ -127,6 +131,12 @@ def main():
     build_type = "the CMAKE_BUILD_TYPE"
     parser.add_argument('--build_type', help=build_type)
 
+    timings = "record per-agent hot path timings in the AgentTimings table"
+    parser.add_argument('--timings', action='store_true', help=timings)
+
+    tracing = "write a Chrome trace of the mbmore agent activity"
+    parser.add_argument('--tracing', action='store_true', help=tracing)
+
     args = parser.parse_args()
     if args.uninstall:
         uninstall(args)
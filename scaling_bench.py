@@ -0,0 +1,132 @@
+#! /usr/bin/env python
+"""Scaling benchmark: runs cyclus on synthetic scenarios (see scenario_gen.py)
+of growing size and reports the wall time per timestep and the peak memory of
+each run.
+
+    python scaling_bench.py -n 10 100 1000 -m 10 100 -k 100 1000 \\
+        -d 120 -o scaling.csv
+
+Every combination of the numbers of states (-n), enrichers (-m) and sinks
+(-k) is run once. The time of each timestep is taken from the "Current time"
+lines that cyclus logs at verbosity LEV_INFO2 (or, if there are none, the
+total time divided by the duration). Startup is the time spent loading the
+input file before the first timestep. Peak RSS is the resident set size of
+the cyclus process. Growth of the step time faster than the number of agents
+points to a quadratic (or worse) path.
+"""
+from __future__ import print_function
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+
+try:
+    import argparse as ap
+except ImportError:
+    import pyne._argparse as ap
+
+import scenario_gen
+
+
+def run_cyclus(cyclus, input_file, output_file):
+    """Runs cyclus and returns (wall time, start of each timestep, peak RSS in
+    MB, exit status)."""
+    cmd = [cyclus, '-v', 'LEV_INFO2', '-o', output_file, input_file]
+    stdbuf = shutil.which('stdbuf') if hasattr(shutil, 'which') else None
+    if stdbuf is not None:
+        # line buffered, so that each line is read as it is logged
+        cmd = [stdbuf, '-oL', '-eL'] + cmd
+    start = time.time()
+    proc = subprocess.Popen(cmd, stdout=subprocess.PIPE,
+                            stderr=subprocess.STDOUT,
+                            universal_newlines=True)
+    steps = []
+    for line in proc.stdout:
+        if 'Current time' in line:
+            steps.append(time.time() - start)
+    # wait4 gives the resource usage of this child only
+    _, status, usage = os.wait4(proc.pid, 0)
+    wall = time.time() - start
+    proc.returncode = os.WEXITSTATUS(status)
+    # ru_maxrss is in kB on Linux and bytes on macOS
+    scale = 1024.0 * 1024.0 if sys.platform == 'darwin' else 1024.0
+    return wall, steps, usage.ru_maxrss / scale, proc.returncode
+
+
+def step_times(wall, steps, duration):
+    """Returns (startup, mean step time, max step time)."""
+    if len(steps) < 2:
+        return 0.0, wall / duration, wall / duration
+    ends = steps[1:] + [wall]
+    times = [end - begin for begin, end in zip(steps, ends)]
+    return steps[0], sum(times) / len(times), max(times)
+
+
+def main():
+    description = 'Time cyclus on synthetic mbmore scenarios of growing size.'
+    parser = ap.ArgumentParser(description=description)
+    parser.add_argument('-n', '--states', type=int, nargs='+', default=[10],
+                        help='numbers of StateInst institutions')
+    parser.add_argument('-m', '--enrichers', type=int, nargs='+',
+                        default=[10], help='numbers of RandomEnrich')
+    parser.add_argument('-k', '--sinks', type=int, nargs='+', default=[20],
+                        help='numbers of RandomSink')
+    parser.add_argument('-d', '--duration', type=int, default=120,
+                        help='number of timesteps')
+    parser.add_argument('-p', '--partners', type=int, default=None,
+                        help='conflict relations per state (default all)')
+    parser.add_argument('-s', '--seed', type=int, default=0,
+                        help='seed of the scenarios')
+    parser.add_argument('-c', '--cyclus', default='cyclus',
+                        help='cyclus executable')
+    parser.add_argument('-o', '--output', default='scaling.csv',
+                        help='results file')
+    parser.add_argument('--keep', default=None,
+                        help='directory to keep the inputs and databases in')
+    args = parser.parse_args()
+
+    work_dir = args.keep or tempfile.mkdtemp(prefix='mbmore_scaling_')
+    if not os.path.exists(work_dir):
+        os.makedirs(work_dir)
+
+    header = ('States,Enrichers,Sinks,Duration,Status,WallTime,Startup,'
+              'MeanStepTime,MaxStepTime,PeakRSS_MB')
+    print('{0:>7} {1:>9} {2:>7} {3:>10} {4:>10} {5:>10} {6:>10}'.format(
+        'States', 'Enrichers', 'Sinks', 'Wall (s)', 'Step (ms)',
+        'Max (ms)', 'RSS (MB)'))
+    with open(args.output, 'w') as out:
+        out.write(header + '\n')
+        for n in args.states:
+            for m in args.enrichers:
+                for k in args.sinks:
+                    name = 'scenario_{0}_{1}_{2}'.format(n, m, k)
+                    input_file = os.path.join(work_dir, name + '.xml')
+                    db_file = os.path.join(work_dir, name + '.sqlite')
+                    with open(input_file, 'w') as f:
+                        f.write(scenario_gen.generate(
+                            n, m, k, args.duration, args.seed,
+                            args.partners))
+                    if os.path.exists(db_file):
+                        os.remove(db_file)
+                    wall, steps, rss, status = run_cyclus(
+                        args.cyclus, input_file, db_file)
+                    startup, mean, worst = step_times(wall, steps,
+                                                      args.duration)
+                    out.write('{0},{1},{2},{3},{4},{5:.4f},{6:.4f},{7:.6f},'
+                              '{8:.6f},{9:.1f}\n'.format(
+                                  n, m, k, args.duration, status, wall,
+                                  startup, mean, worst, rss))
+                    out.flush()
+                    print('{0:>7} {1:>9} {2:>7} {3:>10.2f} {4:>10.2f} '
+                          '{5:>10.2f} {6:>10.1f}{7}'.format(
+                              n, m, k, wall, 1000 * mean, 1000 * worst, rss,
+                              '' if status == 0 else '  FAILED'))
+
+    if args.keep is None:
+        shutil.rmtree(work_dir)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,310 @@
+#! /usr/bin/env python
+"""Writes a synthetic cyclus input file for scaling tests: N StateInst
+institutions under one InteractRegion with random p_conflict_relations, and M
+RandomEnrich and K RandomSink facilities spread over the states.
+
+    python scenario_gen.py -n 50 -m 100 -k 400 -d 120 -o big.xml
+
+Every enrichment and sink facility is its own prototype with parameters drawn
+around those of src/multi_final_sample.xml (SWU capacity, tails assay,
+trading behavior, inspections, requested quantity). Each state also owns a
+natural uranium mine, and deploys a secret enrichment facility and sink when
+it decides to pursue a weapon. The same seed gives the same file.
+"""
+from __future__ import print_function
+import random
+import sys
+
+try:
+    import argparse as ap
+except ImportError:
+    import pyne._argparse as ap
+
+FACTORS = ['Auth', 'Enrich', 'Mil_Iso', 'Mil_Sp', 'Reactors', 'U_Reserve',
+           'Sci_Net', 'Conflict']
+WEIGHTS = [0.15, 0.16, 0.10, 0.15, 0.10, 0.09, 0.10, 0.15]
+
+
+def function_xml(name, params, indent):
+    pad = ' ' * indent
+    vals = ''.join('<val>{0}</val>'.format(p) for p in params)
+    return ('{0}<function><name>{1}</name><params>{2}</params>'
+            '</function>\n').format(pad, name, vals)
+
+
+def region_xml(states, relations, symmetric):
+    out = ['  <region>\n', '    <name>SuperRegion</name>\n',
+           '    <config>\n', '      <InteractRegion>\n',
+           '        <symmetric>{0}</symmetric>\n'.format(int(symmetric)),
+           '        <pursuit_weights>\n']
+    for factor, weight in zip(FACTORS, WEIGHTS):
+        out.append('          <item><factor>{0}</factor><weight>{1}</weight>'
+                   '</item>\n'.format(factor, weight))
+    out.append('        </pursuit_weights>\n')
+    out.append('        <likely_converter>\n')
+    out.append('          <item><phase>Pursuit</phase>\n')
+    out.append(function_xml('power', [4, 0.1], 12))
+    out.append('          </item>\n')
+    out.append('          <item><phase>Acquire</phase>\n')
+    out.append(function_xml('Linear', [5.0, 0.0], 12))
+    out.append('          </item>\n')
+    out.append('        </likely_converter>\n')
+    out.append('        <p_conflict_relations>\n')
+    for primary, other, relation in relations:
+        out.append('          <item><primary_state>{0}</primary_state>'
+                   '<pair_state><item><name>{1}</name><relation>{2}'
+                   '</relation></item></pair_state></item>\n'.format(
+                       states[primary], states[other], relation))
+    out.append('        </p_conflict_relations>\n')
+    out.append('      </InteractRegion>\n')
+    out.append('    </config>\n')
+    return out
+
+
+def state_xml(name, facilities, status, seed, rng):
+    out = ['    <institution>\n',
+           '      <name>{0}</name>\n'.format(name),
+           '      <initialfacilitylist>\n']
+    for proto in ['Mine'] + facilities:
+        out.append('        <entry><prototype>{0}</prototype><number>1'
+                   '</number></entry>\n'.format(proto))
+    out.append('      </initialfacilitylist>\n')
+    out.append('      <config>\n')
+    out.append('        <StateInst>\n')
+    out.append('          <declared_protos>\n')
+    for proto in ['Mine'] + facilities:
+        out.append('            <val>{0}</val>\n'.format(proto))
+    out.append('          </declared_protos>\n')
+    out.append('          <secret_protos><val>Secret_Enrich</val>'
+               '<val>Secret_Sink</val></secret_protos>\n')
+    out.append('          <weapon_status>{0}</weapon_status>\n'.format(status))
+    if seed is not None:
+        out.append('          <rng_seed>{0}</rng_seed>\n'.format(seed))
+    out.append('          <pursuit_factors>\n')
+    for factor in FACTORS[:-1]:
+        out.append('            <item><factor>{0}</factor>\n'.format(factor))
+        kind = rng.random()
+        if kind < 0.5:
+            func = function_xml('Constant', [round(rng.uniform(0, 10), 2)],
+                                14)
+        elif kind < 0.8:
+            start = round(rng.uniform(0, 5), 2)
+            func = function_xml('Linear', [start, round(rng.uniform(0, 0.05),
+                                                        4)], 14)
+        else:
+            func = function_xml('Step', [round(rng.uniform(0, 5), 2),
+                                         round(rng.uniform(5, 10), 2),
+                                         rng.randint(1, 100)], 14)
+        out.append(func)
+        out.append('            </item>\n')
+    out.append('          </pursuit_factors>\n')
+    out.append('        </StateInst>\n')
+    out.append('      </config>\n')
+    out.append('    </institution>\n')
+    return out
+
+
+def behavior_xml(rng, indent):
+    pad = ' ' * indent
+    behav = rng.choice(['None', 'None', 'Every', 'Random'])
+    out = [pad + '<social_behav>{0}</social_behav>\n'.format(behav)]
+    if behav != 'None':
+        out.append(pad + '<behav_interval>{0}</behav_interval>\n'.format(
+            rng.randint(2, 12)))
+    return out
+
+
+def enrich_xml(name, rng):
+    out = ['  <facility>\n', '    <name>{0}</name>\n'.format(name),
+           '    <config>\n', '      <RandomEnrich>\n',
+           '        <feed_commod>nat_uranium</feed_commod>\n',
+           '        <feed_recipe>nat_u_recipe</feed_recipe>\n',
+           '        <product_commod>enriched</product_commod>\n',
+           '        <tails_commod>tails</tails_commod>\n',
+           '        <max_feed_inventory>1e10</max_feed_inventory>\n',
+           '        <tails_assay>{0}</tails_assay>\n'.format(
+               round(rng.uniform(0.002, 0.0035), 5)),
+           '        <swu_capacity>{0}</swu_capacity>\n'.format(
+               round(rng.uniform(100, 2000), 1)),
+           '        <heu_ship_qty>{0}</heu_ship_qty>\n'.format(
+               rng.choice([0, 0, 0.1])),
+           '        <inspect_freq>{0}</inspect_freq>\n'.format(
+               rng.choice([0, 2, 6, 12])),
+           '        <n_swipes>{0}</n_swipes>\n'.format(rng.randint(5, 20))]
+    out += behavior_xml(rng, 8)
+    out += ['      </RandomEnrich>\n', '    </config>\n', '  </facility>\n']
+    return out
+
+
+def sink_xml(name, rng):
+    out = ['  <facility>\n', '    <name>{0}</name>\n'.format(name),
+           '    <config>\n', '      <RandomSink>\n',
+           '        <in_commods><val>enriched</val></in_commods>\n',
+           '        <recipe_name>leu_recipe</recipe_name>\n',
+           '        <avg_qty>{0}</avg_qty>\n'.format(
+               round(rng.uniform(10, 60), 1)),
+           '        <sigma>{0}</sigma>\n'.format(round(rng.uniform(0, 2), 2)),
+           '        <user_pref>{0}</user_pref>\n'.format(rng.randint(1, 10))]
+    out += behavior_xml(rng, 8)
+    out += ['      </RandomSink>\n', '    </config>\n', '  </facility>\n']
+    return out
+
+
+FIXED_PROTOTYPES = """
+  <facility>
+    <name>Mine</name>
+    <config>
+      <Source>
+        <outcommod>nat_uranium</outcommod>
+        <outrecipe>nat_u_recipe</outrecipe>
+      </Source>
+    </config>
+  </facility>
+
+  <facility>
+    <name>Secret_Enrich</name>
+    <config>
+      <RandomEnrich>
+        <max_feed_inventory>1e10</max_feed_inventory>
+        <feed_commod>nat_uranium</feed_commod>
+        <feed_recipe>nat_u_recipe</feed_recipe>
+        <tails_commod>tails</tails_commod>
+        <tails_assay>0.003</tails_assay>
+        <product_commod>secret_heu</product_commod>
+      </RandomEnrich>
+    </config>
+  </facility>
+
+  <facility>
+    <name>Secret_Sink</name>
+    <config>
+      <RandomSink>
+        <in_commods><val>secret_heu</val></in_commods>
+        <recipe_name>heu_recipe</recipe_name>
+        <avg_qty>25</avg_qty>
+        <user_pref>10</user_pref>
+      </RandomSink>
+    </config>
+  </facility>
+
+  <recipe>
+    <name>nat_u_recipe</name>
+    <basis>atom</basis>
+    <nuclide> <id>922350000</id> <comp>0.0071</comp> </nuclide>
+    <nuclide> <id>922380000</id> <comp>0.993</comp> </nuclide>
+  </recipe>
+
+  <recipe>
+    <name>leu_recipe</name>
+    <basis>atom</basis>
+    <nuclide> <id>922350000</id> <comp>0.04</comp> </nuclide>
+    <nuclide> <id>922380000</id> <comp>0.96</comp> </nuclide>
+  </recipe>
+
+  <recipe>
+    <name>heu_recipe</name>
+    <basis>atom</basis>
+    <nuclide> <id>922350000</id> <comp>0.90</comp> </nuclide>
+    <nuclide> <id>922380000</id> <comp>0.10</comp> </nuclide>
+  </recipe>
+"""
+
+ARCHETYPES = """
+  <archetypes>
+    <spec> <lib>cycamore</lib><name>Source</name> </spec>
+    <spec> <lib>mbmore</lib><name>RandomSink</name> </spec>
+    <spec> <lib>mbmore</lib><name>RandomEnrich</name> </spec>
+    <spec> <lib>mbmore</lib><name>StateInst</name> </spec>
+    <spec> <lib>mbmore</lib><name>InteractRegion</name></spec>
+  </archetypes>
+"""
+
+
+def random_relations(n_states, n_partners, symmetric, rng):
+    """Returns (primary, other, relation) for n_partners random partners of
+    each state (all other states if n_partners is None). Relations are drawn
+    as 30% enemy, 40% neutral and 30% ally. With symmetric relations both
+    states of a pair hold the same relation."""
+    relations = {}
+    for primary in range(n_states):
+        others = [s for s in range(n_states) if s != primary]
+        if n_partners is not None and n_partners < len(others):
+            others = rng.sample(others, n_partners)
+        for other in others:
+            if (primary, other) in relations:
+                continue
+            relation = rng.choice([-1, -1, -1, 0, 0, 0, 0, 1, 1, 1])
+            relations[(primary, other)] = relation
+            if symmetric:
+                relations[(other, primary)] = relation
+    return [(p, o, r) for (p, o), r in sorted(relations.items())]
+
+
+def generate(n_states, n_enrich, n_sinks, duration=120, seed=0,
+             n_partners=None, symmetric=True):
+    """Returns the input file as a string."""
+    rng = random.Random(seed)
+    states = ['State{0}'.format(i) for i in range(n_states)]
+    enrichers = ['Enrich{0}'.format(i) for i in range(n_enrich)]
+    sinks = ['Sink{0}'.format(i) for i in range(n_sinks)]
+    owned = [[] for s in states]
+    for i, proto in enumerate(enrichers):
+        owned[i % n_states].append(proto)
+    for i, proto in enumerate(sinks):
+        owned[i % n_states].append(proto)
+
+    out = ['<simulation>\n', '  <control>\n',
+           '    <duration>{0}</duration>\n'.format(duration),
+           '    <startmonth>1</startmonth>\n',
+           '    <startyear>2000</startyear>\n', '  </control>\n',
+           ARCHETYPES, '\n']
+    relations = random_relations(n_states, n_partners, symmetric, rng)
+    out += region_xml(states, relations, symmetric)
+    for i, name in enumerate(states):
+        status = rng.choice([0] * 18 + [2, 3])
+        out += state_xml(name, owned[i], status, seed if i == 0 else None,
+                         rng)
+    out.append('  </region>\n')
+    for proto in enrichers:
+        out += ['\n'] + enrich_xml(proto, rng)
+    for proto in sinks:
+        out += ['\n'] + sink_xml(proto, rng)
+    out.append(FIXED_PROTOTYPES)
+    out.append('</simulation>\n')
+    return ''.join(out)
+
+
+def main():
+    description = 'Write a synthetic mbmore scenario for scaling tests.'
+    parser = ap.ArgumentParser(description=description)
+    parser.add_argument('-n', '--states', type=int, default=10,
+                        help='number of StateInst institutions')
+    parser.add_argument('-m', '--enrichers', type=int, default=10,
+                        help='number of RandomEnrich facilities')
+    parser.add_argument('-k', '--sinks', type=int, default=20,
+                        help='number of RandomSink facilities')
+    parser.add_argument('-d', '--duration', type=int, default=120,
+                        help='number of timesteps')
+    parser.add_argument('-p', '--partners', type=int, default=None,
+                        help='conflict relations per state (default all)')
+    parser.add_argument('-a', '--asymmetric', action='store_true',
+                        help='draw each direction of a relation separately')
+    parser.add_argument('-s', '--seed', type=int, default=0,
+                        help='seed of the generator and the simulation')
+    parser.add_argument('-o', '--output', default=None,
+                        help='input file to write (default stdout)')
+    args = parser.parse_args()
+    if args.states < 2:
+        parser.error('at least two states are needed for conflict relations')
+
+    xml = generate(args.states, args.enrichers, args.sinks, args.duration,
+                   args.seed, args.partners, not args.asymmetric)
+    if args.output is None:
+        sys.stdout.write(xml)
+    else:
+        with open(args.output, 'w') as f:
+            f.write(xml)
+
+
+if __name__ == '__main__':
+    main()
@@ -2,6 +2,7 @@
 #include "InteractRegion.h"
 #include "behavior_functions.h"
 
+#include <cstdlib>
 #include <iostream>
 #include <string>
 
@@ -13,7 +14,12 @@ namespace mbmore {
 
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 InteractRegion::InteractRegion(cyclus::Context* ctx)
-  : cyclus::Region(ctx) {
+  : cyclus::Region(ctx),
+    registry_built(false),
+    n_states(0),
+    likely_built(false),
+    relns_time(-1),
+    n_final_tocks(0) {
     //  kind_ = "InteractRegion";
   cyclus::Warn<cyclus::EXPERIMENTAL_WARNING>("the InteractRegion agent is experimental.");
 
@@ -31,36 +37,87 @@ std::map<std::string, double>
     return wts;
 }
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+const std::vector<double>&
+  InteractRegion::GetFactorWeights() {
+    return p_factor_wts;
+}
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 int InteractRegion::GetNStates() {
-  int n_states = 0;
-  for (std::set<Agent*>::const_iterator inst = children().begin();
-       inst != children().end();
-       inst++) {
-    if ((*inst)->spec() == ":mbmore:StateInst") {
-      n_states++; 
-    }
-  }
   return n_states;
 }
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Every state named in p_conflict_relations gets an index (in the order of
+// the map) so that pair states that are not yet built still have a status.
+void InteractRegion::BuildStateRegistry_() {
+  registry_built = true;
+  std::map<std::pair<std::string, std::string>,int>::iterator it;
+  for (it = p_conflict_map.begin(); it != p_conflict_map.end(); ++it) {
+    int this_state = StateIndex(it->first.first);
+    int other_state = StateIndex(it->first.second);
+    state_relations[this_state].push_back(std::make_pair(other_state,
+							 it->second));
+  }
+}
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+int InteractRegion::StateIndex(const std::string& name) {
+  if (!registry_built) {
+    BuildStateRegistry_();
+  }
+  std::map<std::string, int>::iterator it = state_ids.find(name);
+  if (it != state_ids.end()) {
+    return it->second;
+  }
+  int state = state_names.size();
+  state_ids[name] = state;
+  state_names.push_back(name);
+  state_status.push_back(0);
+  state_factors.push_back(std::vector<double>(GetMasterFactors().size(), 0));
+  state_relations.push_back(std::vector<std::pair<int, int> >());
+  return state;
+}
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+int InteractRegion::RegisterState(std::string proto) {
+  n_states++;
+  return StateIndex(proto);
+}
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void InteractRegion::UnregisterState(int state) {
+  n_states--;
+}
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+bool InteractRegion::RecordProgress(int time, bool changed) {
+  if ((progress_record != "Delta") || changed) {
+    return true;
+  }
+  return (progress_keyframe > 0) && (time % progress_keyframe == 0);
+}
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 void InteractRegion::Tick() {
+  MBMORE_TIME(kTick);
+  // relation changes made by the states in the previous Tock
+  FlushConflictRelns_();
 
   // Things to do only at beginning of Simulation
   if (context()->time() == 0){
     
     // Create conflict score map
     BuildScoreMatrix();
-    
-    // Define Master List of column names for the database only once.
-    std::string master_factors [] = { "Auth", "Conflict", "Enrich",
-				      "Mil_Iso","Mil_Sp","Reactors",
-				      "Sci_Net", "U_Reserve"};
-    int n_factors = sizeof(master_factors) / sizeof(master_factors[0]);
-    
-    if (column_names.size() == 0){
-      for(int f_it = 0; f_it < n_factors; f_it++) {
-	column_names.push_back(master_factors[f_it]);
-      }
+
+    if ((conflict_network != "None") && (conflict_network != "KHop") &&
+	(conflict_network != "Damped")) {
+      throw cyclus::ValueError("conflict_network must be None, KHop or "
+			       "Damped, not " + conflict_network);
+    }
+    if ((network_damping < 0) || (network_damping >= 1) ||
+	(network_hops < 0)) {
+      throw cyclus::ValueError("network_damping must be in [0, 1) and "
+			       "network_hops must not be negative");
+    }
+    conflict_net.Configure(conflict_network, network_hops, network_damping);
+
+    if ((progress_record != "Dense") && (progress_record != "Delta")) {
+      throw cyclus::ValueError("progress_record must be Dense or Delta, not "
+			       + progress_record);
     }
     
     // Determine which factors are used in the simulation based on the defined
@@ -81,10 +138,19 @@ void InteractRegion::Tick() {
 	wt_it->second = wt_it->second/tot_weight;
       }
     }
+
+    // Store the (normalized) weights by master factor index
+    std::vector<std::string>& master_factors = GetMasterFactors();
+    p_factor_wts.assign(master_factors.size(), 0.0);
+    for (int f = 0; f < master_factors.size(); f++) {
+      wt_it = wts.find(master_factors[f]);
+      if (wt_it != wts.end()) {
+	p_factor_wts[f] = wt_it->second;
+      }
+    }
     
     // If conflict is defined, record initial conflict relations in database
-    int n_states = GetNStates();
-    if ((p_present["Conflict"] == true) && n_states > 1){
+    if ((p_present[FactorIndex("Conflict")] == true) && n_states > 1){
       std::string eqn_type = "Pursuit";
       std::map<std::pair<std::string, std::string>,int>::iterator it;
       for (it = p_conflict_map.begin(); it != p_conflict_map.end(); ++it) {
@@ -95,61 +161,70 @@ void InteractRegion::Tick() {
   }
 }
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Writes the relations recorded since the Tick (and the timings of the
+// timestep if built with MBMORE_TIMINGS)
+void InteractRegion::Tock() {
+  MBMORE_TIME_TOCK();
+  FlushConflictRelns_();
+}
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 // Determines which factors are defined for this sim
-std::map<std::string, bool>
-  InteractRegion::DefinedFactors(std::string eqn_type) {
+std::vector<bool> InteractRegion::DefinedFactors(std::string eqn_type) {
 
-  std::map<std::string, bool> present;
-  std::map<std::string,double>::iterator factor_it;
-  int n_factors = column_names.size();
+  std::vector<std::string>& master_factors = GetMasterFactors();
+  int n_factors = master_factors.size();
+  std::vector<bool> present(n_factors, false);
   for(int i = 0; i < n_factors; i++) {
-    factor_it = wts.find(column_names[i]);
-    if (factor_it == wts.end()) {   // factor isn't defined in input file
-      present[column_names[i]]= false;
-    }
-    else {
-      present[column_names[i]]= true;
-    }
+    // false if factor isn't defined in input file
+    present[i] = (wts.find(master_factors[i]) != wts.end());
   }
   return present;
 }
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-// Returns a map of regularly used factors and bool to indicate whether they are
-// defined in this sim.
+const std::vector<bool>&
+  InteractRegion::GetDefinedFactors() {
+    return p_present;
+}
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Returns the master list of factors. The list is defined only once (for all
+// regions) so that references to the column names persist.
 std::vector<std::string>& InteractRegion::GetMasterFactors() {
+  if (column_names.size() == 0){
+    std::string master_factors [] = { "Auth", "Conflict", "Enrich",
+				      "Mil_Iso","Mil_Sp","Reactors",
+				      "Sci_Net", "U_Reserve"};
+    int n_factors = sizeof(master_factors) / sizeof(master_factors[0]);
+    for(int f_it = 0; f_it < n_factors; f_it++) {
+      column_names.push_back(master_factors[f_it]);
+    }
+  }
   return column_names;
 }
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+int InteractRegion::FactorIndex(const std::string& factor) {
+  std::vector<std::string>& master_factors = GetMasterFactors();
+  for (int f = 0; f < master_factors.size(); f++) {
+    if (master_factors[f] == factor) {
+      return f;
+    }
+  }
+  return -1;
+}
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 // Determine the likelihood value for the equation at the current time,
 // (where the current value of the equation is normalized to be between 0-1)
-double InteractRegion::GetLikely(std::string phase, double eqn_val) {
-
-  double hist_duration = 75; // historical data covers 70 years
+double InteractRegion::GetLikely(const std::string& phase, double eqn_val) {
 
-  std::pair<std::string, std::vector<double> > likely_pair =
-    likely_rescale[phase];
-  std::string function = likely_pair.first;
-  std::vector<double> constants = likely_pair.second;
+  if (!likely_built) {
+    BuildLikelyConverters_();
+  }
 
   double phase_likely;
   if (phase == "Pursuit"){
-    double integ_likely;
-    // historical data defines the likelihood integrated over 70yrs
-    if ((function == "Power") || (function == "power")){
-      integ_likely = CalcYVal(function, constants, eqn_val/10.0);
-    }
-    else {
-      integ_likely = CalcYVal(function, constants, eqn_val);
-    }
-    phase_likely = ProbPerTime(integ_likely, hist_duration);
+    phase_likely = p_likely.Likely(eqn_val);
   }
   else {
-    // for acquire, determine the avg time (N_years) to weapon based on score,
-    // then convert to a likelihood per timestep 1/(N_years)
-    // TODO: CHANGE HARDCODING TO CHECK FOR ARBITRARY TIMESTEP DURATION
-    //       (currently assumes timestep is one year)
-    double avg_time = CalcYVal(function, constants, eqn_val);
-    phase_likely = 1.0/avg_time;
+    phase_likely = a_likely.Likely(eqn_val);
   }
 
   if ((phase_likely < 0) || (phase_likely > 1)){
@@ -162,49 +237,46 @@ double InteractRegion::GetLikely(std::string phase, double eqn_val) {
   
 }
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Compiles the Pursuit and Acquire likely_converter equations into
+// interpolation tables (tables that cannot meet likely_table_tol fall back
+// to the exact equation)
+void InteractRegion::BuildLikelyConverters_() {
+  double hist_duration = 75; // historical data covers 70 years
+
+  // likelihoods are defined per year, convert them to the timestep duration
+  double step_duration = static_cast<double>(context()->dt()) /
+    (12.0 * cyclus::kDefaultTimeStepDur);
+
+  std::pair<std::string, std::vector<double> >& p_pair =
+    likely_rescale["Pursuit"];
+  p_likely.Init("Pursuit", p_pair.first, p_pair.second, hist_duration,
+		step_duration);
+  p_likely.BuildTable(likely_table_tol);
+
+  std::pair<std::string, std::vector<double> >& a_pair =
+    likely_rescale["Acquire"];
+  a_likely.Init("Acquire", a_pair.first, a_pair.second, hist_duration,
+		step_duration);
+  a_likely.BuildTable(likely_table_tol);
+
+  LOG(cyclus::LEV_INFO3, "InteractRegion")
+    << "Pursuit likelihood table: " << p_likely.n_points()
+    << " points (max error " << p_likely.error_bound() << "), "
+    << "Acquire likelihood table: " << a_likely.n_points()
+    << " points (max error " << a_likely.error_bound() << ")";
+  likely_built = true;
+}
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 // Determine the Conflict or Military Isolation actor for the state at each
 // timestep. Begin with the map of relations to all other states, sum these
 // values and normalize. Then convert result to a 0-10 scale (0 == alliance,
 // 5 == neutral, 10 == conflict)
   
-double InteractRegion::GetConflictScore(std::string eqn_type,
-					std::string prototype) {
-  int gross_score = 0;
-  int n_entries = 0;
-
-  std::map<std::pair<std::string, std::string>,int>::iterator map_it;
-  for (map_it = p_conflict_map.begin();
-       map_it != p_conflict_map.end(); ++map_it){
-    std::string curr_state = map_it->first.first;
-    if (curr_state == prototype){
-      n_entries+=1;
-      std::string other_state = map_it->first.second;
-
-      // allies, neutral, or enemies
-      int this_relation = map_it->second;
-      
-      // what is each state's NW status?
-      int my_weapon_status = sim_weapon_status[prototype];
-      int other_weapon_status = sim_weapon_status[other_state];
-      
-      std::string relation_string;
-      // order smallest number first (0_2 instead of 2_0)
-      if (my_weapon_status > other_weapon_status){
-	relation_string = BuildRelationString(other_weapon_status,
-					      my_weapon_status,
-					      this_relation);
-      }
-      else {
-	relation_string = BuildRelationString(my_weapon_status,
-					      other_weapon_status,
-					      this_relation);
-      }
-      gross_score += score_matrix[relation_string];
-    }
-  }
-  if (n_entries == 0){
+double InteractRegion::GetConflictScore(int state) {
+  MBMORE_TRACE("GetConflictScore");
+  if (state_relations[state].size() == 0){
     std::stringstream ss;
-    ss << "State " << prototype
+    ss << "State " << state_names[state]
        << " is not defined in the p_conflict_relations";
     throw cyclus::ValueError(ss.str());
   }
@@ -212,64 +284,41 @@ double InteractRegion::GetConflictScore(std::string eqn_type,
   // Take all conflict relationships for a single state and average them
   // together to get final conflict score
   // Example: if A-B = 2, A-C = 6, A-D = 10, then total conflict for A = 6
-  double avg_score = static_cast<double>(gross_score)/n_entries;
-  return avg_score;
+  // In the network modes the scores of allies are then mixed in. All scores
+  // are computed together and only when a relation or status has changed.
+  conflict_net.Update(state_relations, state_status, score_matrix);
+  return conflict_net.Score(state);
 }
 
-// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-// Make a string that contains the weapons status of states A and state B, as
-// well as their relationship as statusA_statusB_relationship
-// String is used as key for map of conflict scores
-// Status 0 - Non Weapon State, 2 - Pursuing, 3 - Acquired
-std::string InteractRegion::BuildRelationString(int statusA,
-						  int statusB,
-						  int relation){
-
-    std::string relation_string;
-    std::string full_string;
-    if (relation == 1){
-      relation_string = "ally_";
-    }
-    else if (relation == 0){
-      relation_string = "neut_";
-    }
-    else {
-      relation_string = "enemy_";
-    }
-
-    // Any weapons status that is not 0 (never pursued), 2 (pursue), 3 (acquire)
-    // is redefined as never pursued
-    if ((statusA != 0) && (statusA != 2) && (statusA !=3)){
-      statusA = 0;
-    }
-    if ((statusB != 0) && (statusB != 2) && (statusB !=3)){
-      statusB = 0;
-    }
-    
-    full_string.append(relation_string);
-    full_string.append(std::to_string(statusA));
-    full_string.append("_");
-    full_string.append(std::to_string(statusB));
-
-    return full_string;
-  }
-  
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 // Change the Conflict value for a state. If the simulation is symmetric,
 // then the change in conflict value is mutual between the two states. Otherwise
 // only the state whose change was initiated is affected, such that the two
 // states may have different perspectives on their relationship.
-void InteractRegion::ChangeConflictReln(std::string eqn_type,
-					  std::string this_state,
-					  std::string other_state, int new_val){
+void InteractRegion::ChangeConflictReln(std::string eqn_type, int this_state,
+					  int other_state, int new_val){
+  int n_changes = (symmetric == 1) ? 2 : 1;
+  for (int i = 0; i < n_changes; i++) {
+    int primary = (i == 0) ? this_state : other_state;
+    int secondary = (i == 0) ? other_state : this_state;
 
-  p_conflict_map[std::pair<std::string, std::string>
-		 (this_state, other_state)] = new_val;
-  RecordConflictReln(eqn_type, this_state, other_state, new_val);
-  if (symmetric == 1){
+    std::vector<std::pair<int, int> >& relations = state_relations[primary];
+    bool found = false;
+    for (int r = 0; r < relations.size(); r++) {
+      if (relations[r].first == secondary) {
+	relations[r].second = new_val;
+	found = true;
+      }
+    }
+    if (!found) {
+      relations.push_back(std::make_pair(secondary, new_val));
+    }
+    conflict_net.RelationsChanged();
+
+    // keep the input map consistent for the simulation snapshot
     p_conflict_map[std::pair<std::string, std::string>
-		   (other_state, this_state)] = new_val;
-    RecordConflictReln(eqn_type, other_state, this_state, new_val);
+		   (state_names[primary], state_names[secondary])] = new_val;
+    BufferConflictReln_(primary, secondary, new_val);
   }
 }
 
@@ -277,60 +326,93 @@ void InteractRegion::ChangeConflictReln(std::string eqn_type,
 // Change the weapon status for a state.
 // 0 = not pursuing, 2 = pursuing, 3 = acquired
 // (Reserved but not implemented: -1 = gave up weapons program, 1 = exploring)
-void InteractRegion::UpdateWeaponStatus(std::string proto,
-					int new_weapon_status){
-
-  // add new key value pair. If key already exists then just update value
-  std::pair<std::map<std::string, int>::iterator, bool> ret;
-  ret = sim_weapon_status.insert(std::pair<std::string, int>
-				 (proto, new_weapon_status));
-  if (ret.second ==false){
-    sim_weapon_status[proto] = new_weapon_status;
+void InteractRegion::UpdateWeaponStatus(int state, int new_weapon_status){
+  if (state_status[state] != new_weapon_status) {
+    state_status[state] = new_weapon_status;
+    conflict_net.StatusChanged();
   }
 }
 
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void InteractRegion::SetFactorValue(int state, int factor, double value) {
+  state_factors[state][factor] = value;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+double InteractRegion::GetFactorValue(int state, int factor) {
+  return state_factors[state][factor];
+}
+
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 // Record conflict factors for each pair at start of simulation and
 // whenever they are changed 
 void InteractRegion::RecordConflictReln(std::string eqn_type,
 					std::string this_state,
 					std::string other_state, int new_val){
-  using cyclus::Context;
-  using cyclus::Recorder;
-  
-  cyclus::Datum *d = context()->NewDatum("InteractRelations");
-  d->AddVal("Time", context()->time());
-  d->AddVal("PrimaryAgent", this_state);
-  d->AddVal("SecondaryAgent", other_state);
-  d->AddVal("Conflict", new_val);
-  d->Record();
+  BufferConflictReln_(StateIndex(this_state), StateIndex(other_state),
+		      new_val);
+}
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void InteractRegion::BufferConflictReln_(int primary, int secondary,
+					 int new_val) {
+  int time = context()->time();
+  if (time != relns_time) {
+    FlushConflictRelns_();
+    relns_time = time;
+  }
+  std::pair<int, int> pair(primary, secondary);
+  std::map<std::pair<int, int>, int>::iterator it =
+    pending_reln_index.find(pair);
+  if (it != pending_reln_index.end()) {
+    pending_relns[it->second].second = new_val;
+  }
+  else {
+    pending_reln_index[pair] = pending_relns.size();
+    pending_relns.push_back(std::make_pair(pair, new_val));
+  }
+}
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void InteractRegion::StateTocked() {
+  if (context()->time() != context()->sim_info().duration - 1) {
+    return;
+  }
+  n_final_tocks++;
+  if (n_final_tocks == n_states) {
+    FlushConflictRelns_();
+  }
+}
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void InteractRegion::FlushConflictRelns_() {
+  for (int r = 0; r < pending_relns.size(); r++) {
+    cyclus::Datum *d = context()->NewDatum("InteractRelations");
+    d->AddVal("Time", relns_time);
+    d->AddVal("PrimaryAgent", state_names[pending_relns[r].first.first]);
+    d->AddVal("SecondaryAgent", state_names[pending_relns[r].first.second]);
+    d->AddVal("Conflict", pending_relns[r].second);
+    d->Record();
+  }
+  pending_relns.clear();
+  pending_reln_index.clear();
 }
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 // Build Score Matrix
+// Starts from the compile-time default table, then applies any user-defined
+// overrides. Override keys have the form relation_statusA_statusB
+// (ie. enemy_2_3) where relation is ally, neut or enemy.
   void InteractRegion::BuildScoreMatrix(){
-    score_matrix.insert(std::pair<std::string, int>("ally_0_0", 2));
-    score_matrix.insert(std::pair<std::string, int>("neut_0_0", 2));
-    score_matrix.insert(std::pair<std::string, int>("enemy_0_0", 6));
-    
-    score_matrix.insert(std::pair<std::string, int>("ally_0_2", 3));
-    score_matrix.insert(std::pair<std::string, int>("neut_0_2", 4));
-    score_matrix.insert(std::pair<std::string, int>("enemy_0_2", 8));
-    
-    score_matrix.insert(std::pair<std::string, int>("ally_0_3", 1));
-    score_matrix.insert(std::pair<std::string, int>("neut_0_3", 4));
-    score_matrix.insert(std::pair<std::string, int>("enemy_0_3", 6));
-    
-    score_matrix.insert(std::pair<std::string, int>("ally_2_2", 3));
-    score_matrix.insert(std::pair<std::string, int>("neut_2_2", 4));
-    score_matrix.insert(std::pair<std::string, int>("enemy_2_2", 9));
-    
-    score_matrix.insert(std::pair<std::string, int>("ally_2_3", 3));
-    score_matrix.insert(std::pair<std::string, int>("neut_2_3", 5));
-    score_matrix.insert(std::pair<std::string, int>("enemy_2_3", 10));
-    
-    score_matrix.insert(std::pair<std::string, int>("ally_3_3", 1));
-    score_matrix.insert(std::pair<std::string, int>("neut_3_3", 3));
-    score_matrix.insert(std::pair<std::string, int>("enemy_3_3", 5));
+    score_matrix.Reset();
+
+    std::map<std::string, int>::iterator it;
+    for (it = score_overrides.begin(); it != score_overrides.end(); ++it) {
+      int relation, status_a, status_b;
+      if (!ParseScorePair(it->first, &relation, &status_a, &status_b)) {
+	throw cyclus::ValueError("conflict_scores pair " + it->first +
+				 " must have the form relation_statusA_statusB"
+				 " with relation ally, neut or enemy and "
+				 "statuses 0, 2 or 3");
+      }
+      score_matrix.Set(relation, status_a, status_b, it->second);
+    }
   }
   
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
@@ -2,6 +2,10 @@
 #define MBMORE_SRC_INTERACT_REGION_H_
 
 #include "cyclus.h"
+#include "agent_timings.h"
+#include "conflict_network.h"
+#include "conflict_scores.h"
+#include "likely_convert.h"
 
 namespace mbmore {
 
@@ -31,7 +35,7 @@ class InteractRegion
 
   virtual void Tick();
 
-  virtual void Tock() {}
+  virtual void Tock();
 
   // perform actions required when entering the simulation
   virtual void Build(cyclus::Agent* parent);
@@ -43,58 +47,105 @@ class InteractRegion
   // with the child institutions
   std::map<std::string, double> GetWeights(std::string eqn_type);
 
+  // Weight of each master factor in the pursuit equation (indexed as in
+  // GetMasterFactors), zero for any factor that is not defined in this sim
+  const std::vector<double>& GetFactorWeights();
+
+  // Gives a state a dense index into the region's per-state arrays, and
+  // counts it as an active state. Called by each StateInst when it is built.
+  int RegisterState(std::string proto);
+
+  // Removes a state from the count of active states (its index is kept)
+  void UnregisterState(int state);
+
+  // Returns the index of a named state, adding it to the registry if the
+  // name has not been seen yet (ie. a pair state that is not yet built)
+  int StateIndex(const std::string& name);
+
   // Determines # of states in the simulation. If only one state then
   // Interactive Factors (such as conflict) are not calculated.
   int GetNStates();
   
   // Uses the pursuit or acquire likelihood conversion equation to determine the
   // likeliness of pursuit and acquire on a 0-1 scale for the requested timestep
-  double GetLikely(std::string phase, double eqn_val);
+  // (uses the tables built from likely_converter when possible)
+  double GetLikely(const std::string& phase, double eqn_val);
 
 
-  // Determines which factors are defined for this sim
-  std::map<std::string, bool> DefinedFactors(std::string eqn_type);
+  // Determines which factors are defined for this sim (indexed as in
+  // GetMasterFactors)
+  std::vector<bool> DefinedFactors(std::string eqn_type);
 
-  // Returns a map of regularly used factors and bool to indicate whether
-  // the are defined in this sim.
-  std::map<std::string, bool> GetDefinedFactors(std::string eqn_type);
+  // Returns whether each of the master factors is defined in this sim
+  // (indexed as in GetMasterFactors).
+  const std::vector<bool>& GetDefinedFactors();
 
   // Returns the master list of all factors to be recorded in database
   std::vector<std::string>& GetMasterFactors();
 
+  // Index of a factor in the master list, -1 if it is not a master factor
+  int FactorIndex(const std::string& factor);
+
+  // Whether a state writes its WeaponProgress row at a timestep, given
+  // whether the row changed since the state's previous decision (always
+  // true unless progress_record is Delta)
+  bool RecordProgress(int time, bool changed);
+
   // Tracks weapons status of each state (0 = not pursuing, 2 = pursuing,
-  // 3 = acquired) by updating the sim_weapon_status map
-  virtual void UpdateWeaponStatus(std::string proto, int new_weapon_status);
+  // 3 = acquired) by updating the state_status array
+  virtual void UpdateWeaponStatus(int state, int new_weapon_status);
+
+  // Stores the current value of a (master) factor for a state
+  void SetFactorValue(int state, int factor, double value);
+
+  // Most recent value of a (master) factor for a state
+  double GetFactorValue(int state, int factor);
 
   // Determines Conflict score for each state based on its net
   // relationships with other states and both states' weapon status
-  double GetConflictScore(std::string eqn_type, std::string prototype);
-
-  // Builds a string to use as key for map that defines the conflict score
-  // for a pair states based on their ally/neutral/enemy relationship
-  std::string BuildRelationString(int statusA, int statusB, int relation);
+  double GetConflictScore(int state);
 
   // Changes conflict relationship from initial value to final value at the
   // specified time
-  virtual void ChangeConflictReln(std::string eqn_type,
-				    std::string this_state,
-				    std::string other_state, int new_val);
+  virtual void ChangeConflictReln(std::string eqn_type, int this_state,
+				    int other_state, int new_val);
 
   // Records conflict value at beginning of simulation and any time the conflict
-  // relation changes
+  // relation changes. Rows are buffered and written to the
+  // InteractRelations table in the next Tick or Tock of the region (or by
+  // StateTocked in the last timestep).
   virtual void RecordConflictReln(std::string eqn_type,
 				    std::string this_state,
 				    std::string other_state, int new_val);
 
 
-  // Initialize the map that defines how state relationships map to conflict
-  // score
+  // Called at the end of each StateInst's Tock. The last timestep has no
+  // later Tick of the region, so its relation rows are written once every
+  // state has made its decision.
+  void StateTocked();
+
+  // Initialize the table that defines how state relationships map to conflict
+  // score, applying any conflict_scores overrides from the input file
   virtual void BuildScoreMatrix();
 
   /// every agent should be able to print a verbose description
   virtual std::string str();
 
  private:
+  // Gives an index to every state named in p_conflict_relations and builds
+  // the per-state relation lists
+  void BuildStateRegistry_();
+
+  // Builds p_likely and a_likely from likely_rescale
+  void BuildLikelyConverters_();
+
+  // Adds a relation row to the buffer, replacing any earlier row of the
+  // same pair at the same time. Writes the buffer first if it holds rows of
+  // an earlier time.
+  void BufferConflictReln_(int primary, int secondary, int new_val);
+
+  // Writes the buffered relation rows to the InteractRelations table
+  void FlushConflictRelns_();
 
 #pragma cyclus var {				\
   "default": 0,						    \
@@ -133,6 +184,79 @@ bool symmetric;
     }
   std::map<std::pair<std::string,std::string>, int> p_conflict_map ;
 
+#pragma cyclus var {							\
+    "default": 1e-6,							\
+    "tooltip": "Max error of the likelihood conversion tables",	\
+    "doc": "The likely_converter equations are tabulated at the start of " \
+           "the simulation and interpolated for each decision. This is the " \
+           "largest allowed difference between the table and the exact " \
+           "equation. Equations that cannot be tabulated to this accuracy, " \
+           "or a value of 0, use the exact equation.",			\
+    }
+  double likely_table_tol ;
+
+#pragma cyclus var {							\
+    "default": {},							\
+    "alias": ["conflict_scores", "pair", "score"],			\
+    "doc": "Optional overrides of the default conflict score (0-10) for a " \
+           "pair of states. Each pair is named relation_statusA_statusB " \
+           "where relation is ally, neut or enemy and the statuses are " \
+           "0, 2 or 3 (ie. enemy_2_3). Order of the statuses does not " \
+           "matter. Pairs that are not listed keep their default score.", \
+    }
+  std::map<std::string, int> score_overrides ;
+
+#pragma cyclus var {							\
+    "default": "None",							\
+    "tooltip": "Propagate conflict through alliances",			\
+    "doc": "How Conflict scores are computed from the relations. None "	\
+           "averages each state's direct pairwise scores. KHop and Damped " \
+           "also mix in the scores of each state's allies (so an ally's " \
+           "enemy raises a state's conflict): KHop propagates network_hops " \
+           "steps along alliance chains, Damped propagates until the " \
+           "scores converge. Each step keeps (1 - network_damping) of the " \
+           "direct score.",						\
+    }
+  std::string conflict_network ;
+
+#pragma cyclus var {							\
+    "default": 1,							\
+    "tooltip": "Number of alliance steps for KHop conflict_network",	\
+    "doc": "Number of steps along alliance chains used when "		\
+           "conflict_network is KHop. 0 is the same as None.",		\
+    }
+  int network_hops ;
+
+#pragma cyclus var {							\
+    "default": 0.5,							\
+    "tooltip": "Weight of allies' conflict in network modes",		\
+    "doc": "Fraction (0 to <1) of a state's conflict score that comes " \
+           "from its allies' scores at each propagation step when "	\
+           "conflict_network is KHop or Damped. 0 is the same as None.", \
+    }
+  double network_damping ;
+
+#pragma cyclus var {							\
+    "default": "Dense",							\
+    "tooltip": "Which WeaponProgress rows are written",		\
+    "doc": "Dense writes a WeaponProgress row for every state at every " \
+           "timestep. Delta only writes a state's row when one of its "	\
+           "values (factors, EqnType, EqnVal, Likelihood, LRWeight or "	\
+           "Decision) differs from its previous decision, and at every " \
+           "progress_keyframe timesteps. The dense series is rebuilt by " \
+           "carrying each row forward to the next row of the state.",	\
+    }
+  std::string progress_record ;
+
+#pragma cyclus var {							\
+    "default": 0,							\
+    "tooltip": "Interval of full WeaponProgress rows in Delta mode",	\
+    "doc": "If positive and progress_record is Delta, every state also " \
+           "writes its row at the timesteps that are multiples of this " \
+           "interval, whether or not it changed.",			\
+    }
+  int progress_keyframe ;
+
 
 // Defines persistent column names in WeaponProgress table of database
 // Must be defined globally so that references to the column name 
@@ -140,15 +264,57 @@ bool symmetric;
 static std::vector<std::string> column_names;
 
 // Defines which of the master factor list are being used based on weights
-std::map<std::string, bool> p_present;
-std::map<std::string, bool> a_present;
+std::vector<bool> p_present;
+std::vector<bool> a_present;
+
+// Weight of each master factor, zero if undefined
+std::vector<double> p_factor_wts;
+
+// Registry of states. Each state is given a dense index, either when it is
+// built or when it is first named in p_conflict_relations, and all per-state
+// information is kept in arrays indexed by that number.
+bool registry_built;
+std::map<std::string, int> state_ids;
+std::vector<std::string> state_names;
+
+// Number of StateInst agents currently registered
+int n_states;
 
 // Tracks the weapons status of each state
-std::map<std::string, int> sim_weapon_status;
+std::vector<int> state_status;
+
+// Most recent value of each master factor for each state
+std::vector<std::vector<double> > state_factors;
+
+// Conflict relations of each state as (pair state index, relation) 
+std::vector<std::vector<std::pair<int, int> > > state_relations;
 
 // Defines conflict scores given weapon status of 2 states and their
 // relationship (ally, neut, enemy)
-std::map<std::string, int> score_matrix;
+ConflictScores score_matrix;
+
+// Conflict score of every state, recomputed only when relations or weapon
+// statuses change
+ConflictNetwork conflict_net;
+
+// Pursuit and Acquire likelihood conversions, built on first use
+bool likely_built;
+LikelyConverter p_likely;
+LikelyConverter a_likely;
+
+// Relation rows not yet written, as (primary, secondary, relation) state
+// indices, all of time relns_time, and the position of each pair's row
+int relns_time;
+std::vector<std::pair<std::pair<int, int>, int> > pending_relns;
+std::map<std::pair<int, int>, int> pending_reln_index;
+
+// Number of states that have made their decision in the last timestep
+int n_final_tocks;
+
+#ifdef MBMORE_TIMINGS
+// hot path timings of the current timestep (see agent_timings.h)
+AgentTimings timings_;
+#endif
 
   
  
@@ -1,16 +1,213 @@
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <sstream>
+
 #include "cyclus.h"
 
 
 #include "agent_tests.h"
 #include "context.h"
 #include "facility_tests.h"
+#include "sim_init.h"
+#include "sqlite_back.h"
+#include "xml_file_loader.h"
 
 namespace mbmore {
 
 
 namespace InteractRegionTests {
+
+// The tested InteractRegion needs its StateInsts as children, which MockSim
+// cannot build, so these tests load and run a whole input file.
+
+// pursuit_factors item of a state, with the constants y0 and (unless it is
+// negative) y1
+std::string Factor(const std::string& factor, const std::string& function,
+		   double y0, double y1 = -1) {
+  std::stringstream ss;
+  ss << "<item><factor>" << factor << "</factor><function><name>"
+     << function << "</name><params><val>" << y0 << "</val>";
+  if (y1 >= 0) {
+    ss << "<val>" << y1 << "</val>";
+  }
+  ss << "</params></function></item>";
+  return ss.str();
+}
+
+// Input file of an InteractRegion holding StateA and StateB, enemies of
+// each other, whose decisions weigh Auth and Conflict equally. Neither state
+// can pursue (the Pursuit likelihood is 0), so their rows only change with
+// their factors. region_vars are added to the region config.
+std::string TwoStates(const std::string& region_vars,
+		      const std::string& a_factors,
+		      const std::string& b_factors, int duration) {
+  std::string names[2] = {"StateA", "StateB"};
+  std::string factors[2] = {a_factors, b_factors};
+  std::stringstream ss;
+  ss << "<simulation>"
+     << "<control><duration>" << duration << "</duration>"
+     << "<startmonth>1</startmonth><startyear>2000</startyear></control>"
+     << "<archetypes>"
+     << "<spec><lib>mbmore</lib><name>InteractRegion</name></spec>"
+     << "<spec><lib>mbmore</lib><name>StateInst</name></spec>"
+     << "<spec><lib>mbmore</lib><name>RandomSink</name></spec>"
+     << "</archetypes>"
+     << "<facility><name>Sink</name><config><RandomSink>"
+     << "<in_commods><val>none</val></in_commods>"
+     << "</RandomSink></config></facility>"
+     << "<region><name>SuperRegion</name><config><InteractRegion>"
+     << "<pursuit_weights>"
+     << "<item><factor>Auth</factor><weight>0.5</weight></item>"
+     << "<item><factor>Conflict</factor><weight>0.5</weight></item>"
+     << "</pursuit_weights>"
+     << "<likely_converter>";
+  std::string phases[2] = {"Pursuit", "Acquire"};
+  for (int i = 0; i < 2; i++) {
+    ss << "<item><phase>" << phases[i] << "</phase><function>"
+       << "<name>Linear</name><params><val>0</val><val>0</val></params>"
+       << "</function></item>";
+  }
+  ss << "</likely_converter><p_conflict_relations>";
+  for (int i = 0; i < 2; i++) {
+    ss << "<item><primary_state>" << names[i] << "</primary_state>"
+       << "<pair_state><item><name>" << names[1 - i] << "</name>"
+       << "<relation>-1</relation></item></pair_state></item>";
+  }
+  ss << "</p_conflict_relations>" << region_vars
+     << "</InteractRegion></config>";
+  for (int i = 0; i < 2; i++) {
+    ss << "<institution><name>" << names[i] << "</name><config><StateInst>"
+       << "<declared_protos><val>Sink</val></declared_protos>"
+       << "<secret_protos><val>Sink</val></secret_protos>"
+       << "<pursuit_factors>" << factors[i] << "</pursuit_factors>"
+       << "</StateInst></config></institution>";
+  }
+  ss << "</region></simulation>";
+  return ss.str();
+}
+
+// Runs an input file and returns the rows of a table
+cyclus::QueryResult RunInput(const std::string& input,
+			     const std::string& table) {
+  static int n_runs = 0;
+  std::stringstream name;
+  name << "interact_region_test_" << n_runs++;
+  std::string in_file = name.str() + ".xml";
+  std::string db_file = name.str() + ".sqlite";
+  std::ofstream out(in_file.c_str());
+  out << input;
+  out.close();
+  std::remove(db_file.c_str());
+
+  cyclus::QueryResult qr;
+  {
+    cyclus::SqliteBack back(db_file);
+    cyclus::Recorder rec;
+    rec.RegisterBackend(&back);
+    cyclus::XMLFileLoader loader(&rec, &back, cyclus::Env::rng_schema(),
+				 in_file);
+    loader.LoadSim();
+    cyclus::SimInit si;
+    si.Init(&rec, &back);
+    si.timer()->RunSim();
+    rec.Flush();
+    qr = back.Query(table, NULL);
+    rec.Close();
+  }
+  std::remove(in_file.c_str());
+  std::remove(db_file.c_str());
+  return qr;
+}
+
+// WeaponProgress rows of each state (in the order the states were built) by
+// time, as the values compared between runs
+typedef std::map<int, std::vector<double> > ProgressRows;
+std::vector<ProgressRows> ProgressByState(cyclus::QueryResult& qr) {
+  std::map<int, ProgressRows> by_id;
+  for (int i = 0; i < qr.rows.size(); i++) {
+    std::vector<double> row;
+    row.push_back(qr.GetVal<double>("Auth", i));
+    row.push_back(qr.GetVal<double>("Conflict", i));
+    row.push_back(qr.GetVal<double>("EqnVal", i));
+    row.push_back(qr.GetVal<double>("Likelihood", i));
+    row.push_back(qr.GetVal<double>("LRWeight", i));
+    row.push_back(qr.GetVal<bool>("Decision", i));
+    by_id[qr.GetVal<int>("AgentId", i)][qr.GetVal<int>("Time", i)] = row;
+  }
+  std::vector<ProgressRows> states;
+  std::map<int, ProgressRows>::iterator it;
+  for (it = by_id.begin(); it != by_id.end(); ++it) {
+    states.push_back(it->second);
+  }
+  return states;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// With constant factors, Delta mode only writes the first row and the
+// keyframes of each state, and carrying each row forward gives the rows
+// written in Dense mode
+TEST(InteractRegionTests, DeltaProgress) {
+  std::string factors = Factor("Auth", "Constant", 5);
+  int simdur = 10;
+  cyclus::QueryResult dense_qr =
+    RunInput(TwoStates("", factors, factors, simdur), "WeaponProgress");
+  cyclus::QueryResult delta_qr =
+    RunInput(TwoStates("<progress_record>Delta</progress_record>"
+		       "<progress_keyframe>4</progress_keyframe>",
+		       factors, factors, simdur), "WeaponProgress");
+  std::vector<ProgressRows> dense = ProgressByState(dense_qr);
+  std::vector<ProgressRows> delta = ProgressByState(delta_qr);
+
+  ASSERT_EQ(2, dense.size());
+  ASSERT_EQ(2, delta.size());
+  EXPECT_EQ(2 * simdur, dense_qr.rows.size());
+  for (int s = 0; s < 2; s++) {
+    // t = 0, 4 and 8
+    EXPECT_EQ(3, delta[s].size());
+    ASSERT_EQ(simdur, dense[s].size());
+    for (int t = 0; t < simdur; t++) {
+      ProgressRows::iterator carried = delta[s].upper_bound(t);
+      ASSERT_TRUE(carried != delta[s].begin());
+      --carried;
+      EXPECT_EQ(dense[s][t], carried->second);
+    }
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Buffered relation rows are the rows that were written directly when each
+// relation was set: the initial relations at t=0 and each change at the time
+// it was made, including a change in the last timestep
+TEST(InteractRegionTests, RelationRows) {
+  std::string a_factors = Factor("Auth", "Constant", 5) +
+    Factor("Conflict", "StateB", 1, 2);
+  std::string b_factors = Factor("Auth", "Constant", 5) +
+    Factor("Conflict", "StateA", 0, 4);
+  cyclus::QueryResult qr = RunInput(TwoStates("", a_factors, b_factors, 5),
+				    "InteractRelations");
+
+  std::vector<std::string> rows;
+  for (int i = 0; i < qr.rows.size(); i++) {
+    std::stringstream row;
+    row << qr.GetVal<int>("Time", i) << " "
+	<< qr.GetVal<std::string>("PrimaryAgent", i) << " "
+	<< qr.GetVal<std::string>("SecondaryAgent", i) << " "
+	<< qr.GetVal<int>("Conflict", i);
+    rows.push_back(row.str());
+  }
+  std::sort(rows.begin(), rows.end());
+  std::vector<std::string> expected;
+  expected.push_back("0 StateA StateB -1");
+  expected.push_back("0 StateB StateA -1");
+  expected.push_back("2 StateA StateB 1");
+  expected.push_back("4 StateB StateA 0");
+  EXPECT_EQ(expected, rows);
+}
+
   /*
   TEST(InteractRegionTests, DeployProto) {
 
@@ -1,11 +1,15 @@
 // Implements the RandomEnrich class
 #include "RandomEnrich.h"
 #include "behavior_functions.h"
+#include "feed_blend.h"
 #include "sim_init.h"
+#include "tails_optimizer.h"
 
 #include <algorithm>
 #include <cmath>
+#include <functional>
 #include <limits>
+#include <map>
 #include <sstream>
 #include <vector>
 #include <boost/lexical_cast.hpp>
@@ -26,14 +30,30 @@ RandomEnrich::RandomEnrich(cyclus::Context* ctx)
       false_pos(0),
       false_neg(0),
       rng_seed(0),   
+      rng_streams(false),
       swu_capacity(0),
+      buffer_stats(0),
+      max_buffer_growth(0),
       max_enrich(1), 
+      batch_enrich(false),
+      feed_optimizer("None"),
+      feed_bin_width(1e-4),
+      feed_policy("FIFO"),
+      tails_policy("Normal"),
+      cache_bids(false),
       initial_feed(0),
       feed_commod(""),
       feed_recipe(""),
       product_commod(""),
       tails_commod(""),
-      order_prefs(true){}
+      order_prefs(true),
+      feed_indexed_(false),
+      tails_opt_ready_(false),
+      bid_cache_hits_(0),
+      bid_cache_lookups_(0),
+      constraint_feed_assay_(-1),
+      constraint_tails_assay_(-1),
+      constraint_inventory_(-1){}
 
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 RandomEnrich::~RandomEnrich() {}
@@ -68,8 +88,15 @@ void RandomEnrich::Build(cyclus::Agent* parent) {
   LOG(cyclus::LEV_DEBUG2, "EnrFac") << str();
 }
 
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void RandomEnrich::EnterNotify() {
+  cyclus::Facility::EnterNotify();
+  InitRngStreams_();
+}
+
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 void RandomEnrich::Tick() {
+  MBMORE_TIME(kTick);
 
   int cur_time = context()->time();
 
@@ -77,6 +104,27 @@ void RandomEnrich::Tick() {
   if (cur_time == 0) {
     net_heu = 0;
     HEU_present = 0;
+    if ((feed_policy != "FIFO") && (feed_policy != "HighAssay")) {
+      throw cyclus::ValueError(Agent::InformErrorMsg(
+        "feed_policy must be FIFO or HighAssay, not " + feed_policy));
+    }
+    if ((feed_policy == "HighAssay") && (feed_bin_width <= 0)) {
+      throw cyclus::ValueError(Agent::InformErrorMsg(
+        "the HighAssay feed_policy needs a positive feed_bin_width"));
+    }
+    if ((feed_optimizer != "None") && (feed_optimizer != "SWU") &&
+	(feed_optimizer != "NatU")) {
+      throw cyclus::ValueError(Agent::InformErrorMsg(
+        "feed_optimizer must be None, SWU or NatU, not " + feed_optimizer));
+    }
+    if ((tails_policy != "Normal") && (tails_policy != "Optimal")) {
+      throw cyclus::ValueError(Agent::InformErrorMsg(
+        "tails_policy must be Normal or Optimal, not " + tails_policy));
+    }
+    if ((tails_policy == "Optimal") && (tails_assay - sigma_tails <= 0)) {
+      throw cyclus::ValueError(Agent::InformErrorMsg(
+        "the Optimal tails_policy needs tails_assay > sigma_tails"));
+    }
   }
 
   // decide whether trading if trading only sometimes.
@@ -85,20 +133,28 @@ void RandomEnrich::Tick() {
     trade_timestep = (EveryXTimestep(cur_time, behav_interval));
   }
   else if (social_behav == "Random" && behav_interval > 0) {
-    trade_timestep = (EveryRandomXTimestep(behav_interval, rng_seed));
+    trade_timestep = rng_streams ?
+      EveryRandomXTimestep(behav_interval, trade_rng_) :
+      EveryRandomXTimestep(behav_interval, rng_seed);
   }
   else if (social_behav == "None") {
     trade_timestep = 1;
   }
   
-  // determine tails assay for the timestep if it is variable
-  curr_tails_assay = RNG_NormalDist(tails_assay, sigma_tails,
-				    rng_seed);
-  if (curr_tails_assay < (tails_assay - sigma_tails)) {
-    curr_tails_assay = tails_assay - sigma_tails;
-  }
-  if (curr_tails_assay > (tails_assay + sigma_tails)) {
-    curr_tails_assay = tails_assay + sigma_tails;
+  // determine tails assay for the timestep if it is variable (with the
+  // Optimal tails_policy it is chosen when bidding, see OptimalTails_)
+  if (tails_policy == "Optimal") {
+    curr_tails_assay = tails_assay;
+  } else {
+    curr_tails_assay = rng_streams ?
+      RNG_NormalDist(tails_assay, sigma_tails, tails_rng_) :
+      RNG_NormalDist(tails_assay, sigma_tails, rng_seed);
+    if (curr_tails_assay < (tails_assay - sigma_tails)) {
+      curr_tails_assay = tails_assay - sigma_tails;
+    }
+    if (curr_tails_assay > (tails_assay + sigma_tails)) {
+      curr_tails_assay = tails_assay + sigma_tails;
+    }
   }
 
   LOG(cyclus::LEV_INFO3, "EnrFac") << prototype() << " is ticking {";
@@ -108,21 +164,29 @@ void RandomEnrich::Tick() {
 
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 void RandomEnrich::Tock() {
+  MBMORE_TIME_TOCK();
   using cyclus::toolkit::RecordTimeSeries;
   RecordTimeSeries<cyclus::toolkit::ENRICH_SWU>(this, intra_timestep_swu_);
   RecordTimeSeries<cyclus::toolkit::ENRICH_FEED>(this, intra_timestep_feed_);
 
   // Add any inspections to the Inspection table
-  bool do_inspect = EveryRandomXTimestep(inspect_freq, rng_seed);
+  bool do_inspect = rng_streams ?
+    EveryRandomXTimestep(inspect_freq, inspect_rng_) :
+    EveryRandomXTimestep(inspect_freq, rng_seed);
   if (do_inspect == true){
     RecordInspection_();
   }
 
+  if ((buffer_stats > 0) && (context()->time() % buffer_stats == 0)) {
+    buf_stats_.Record(this, "inventory", inventory, max_buffer_growth);
+    buf_stats_.Record(this, "tails", tails, max_buffer_growth);
+  }
 }
 
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 std::set<cyclus::RequestPortfolio<cyclus::Material>::Ptr>
     RandomEnrich::GetMatlRequests() {
+  MBMORE_TIME(kGetMatlRequests);
   using cyclus::Material;
   using cyclus::RequestPortfolio;
   using cyclus::Request;
@@ -158,6 +222,7 @@ bool SortBids(
 //  U-235 content
 void RandomEnrich::AdjustMatlPrefs(
     cyclus::PrefMap<cyclus::Material>::type& prefs) {
+  MBMORE_TIME(kAdjustMatlPrefs);
 
   using cyclus::Bid;
   using cyclus::Material;
@@ -206,6 +271,7 @@ void RandomEnrich::AdjustMatlPrefs(
 void RandomEnrich::AcceptMatlTrades(
     const std::vector< std::pair<cyclus::Trade<cyclus::Material>,
     cyclus::Material::Ptr> >& responses) {
+  MBMORE_TIME(kAcceptMatlTrades);
   // see
   // http://stackoverflow.com/questions/5181183/boostshared-ptr-and-inheritance
   std::vector< std::pair<cyclus::Trade<cyclus::Material>,
@@ -218,6 +284,7 @@ void RandomEnrich::AcceptMatlTrades(
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 std::set<cyclus::BidPortfolio<cyclus::Material>::Ptr> RandomEnrich::GetMatlBids(
     cyclus::CommodMap<cyclus::Material>::type& out_requests){
+  MBMORE_TIME(kGetMatlBids);
   using cyclus::Bid;
   using cyclus::BidPortfolio;
   using cyclus::CapacityConstraint;
@@ -275,10 +342,54 @@ std::set<cyclus::BidPortfolio<cyclus::Material>::Ptr> RandomEnrich::GetMatlBids(
       }
     }
     */
-    Converter<Material>::Ptr sc(new SWUConverter(FeedAssay(), curr_tails_assay));
-    Converter<Material>::Ptr nc(new NatUConverter(FeedAssay(), curr_tails_assay));
-    CapacityConstraint<Material> swu(swu_capacity, sc);
-    CapacityConstraint<Material> natu(inventory.quantity(), nc);
+    // total and mean assay of the product bid
+    double product = 0;
+    double u235 = 0;
+    const std::set<Bid<Material>*>& bids = commod_port->bids();
+    std::set<Bid<Material>*>::const_iterator it;
+    for (it = bids.begin(); it != bids.end(); ++it) {
+      double qty = (*it)->offer()->quantity();
+      product += qty;
+      u235 += qty * cyclus::toolkit::UraniumAssay((*it)->offer());
+    }
+
+    // with the Optimal tails_policy, the tails assay of the timestep is
+    // chosen for the bids, before they are converted with it
+    if ((tails_policy == "Optimal") && (product > 0)) {
+      curr_tails_assay = OptimalTails_(u235 / product);
+    }
+
+    // with the HighAssay feed_policy or a feed_optimizer the bids are
+    // enriched from the richest feed, so they are converted at the assay of
+    // the feed drawn for all of them
+    double feed_assay = FeedAssay();
+    if (product > 0) {
+      FeedDraw draw = BidFeed_(u235 / product, product);
+      if (draw.assay > 0) {
+	feed_assay = draw.assay;
+      }
+    }
+    // with cache_bids, the last constraints are reused if they would be
+    // made the same
+    if (!cache_bids || bid_constraints_.empty() ||
+	(feed_assay != constraint_feed_assay_) ||
+	(curr_tails_assay != constraint_tails_assay_) ||
+	(inventory.quantity() != constraint_inventory_)) {
+      Converter<Material>::Ptr sc(new SWUConverter(feed_assay,
+						   curr_tails_assay));
+      Converter<Material>::Ptr nc(new NatUConverter(feed_assay,
+						    curr_tails_assay));
+      bid_constraints_.clear();
+      bid_constraints_.push_back(
+        CapacityConstraint<Material>(swu_capacity, sc));
+      bid_constraints_.push_back(
+        CapacityConstraint<Material>(inventory.quantity(), nc));
+      constraint_feed_assay_ = feed_assay;
+      constraint_tails_assay_ = curr_tails_assay;
+      constraint_inventory_ = inventory.quantity();
+    }
+    const CapacityConstraint<Material>& swu = bid_constraints_[0];
+    const CapacityConstraint<Material>& natu = bid_constraints_[1];
     commod_port->AddConstraint(swu);
     commod_port->AddConstraint(natu);
     
@@ -288,6 +399,11 @@ std::set<cyclus::BidPortfolio<cyclus::Material>::Ptr> RandomEnrich::GetMatlBids(
     LOG(cyclus::LEV_INFO5, "EnrFac") << prototype()
 				     << " adding a natu constraint of "
 				     << natu.capacity();
+    if (cache_bids) {
+      LOG(cyclus::LEV_INFO4, "EnrFac") << prototype()
+				       << " bid cache hit rate is "
+				       << BidCacheHitRate();
+    }
     ports.insert(commod_port);
   }
   return ports;
@@ -295,10 +411,23 @@ std::set<cyclus::BidPortfolio<cyclus::Material>::Ptr> RandomEnrich::GetMatlBids(
 
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 bool RandomEnrich::ValidReq(const cyclus::Material::Ptr mat) {
+  return ReqAssay_(mat) > BidTails_();
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+double RandomEnrich::BidTails_() const {
+  if (tails_policy == "Optimal") {
+    return tails_assay + sigma_tails;
+  }
+  return curr_tails_assay;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+double RandomEnrich::ReqAssay_(const cyclus::Material::Ptr mat) {
   cyclus::toolkit::MatQuery q(mat);
   double u235 = q.atom_frac(922350000);
   double u238 = q.atom_frac(922380000);
-  return (u238 > 0 && u235 / (u235 + u238) > curr_tails_assay);
+  return (u238 > 0) ? u235 / (u235 + u238) : 0;
 }
   
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
@@ -306,6 +435,7 @@ void RandomEnrich::GetMatlTrades(
     const std::vector< cyclus::Trade<cyclus::Material> >& trades,
     std::vector<std::pair<cyclus::Trade<cyclus::Material>,
     cyclus::Material::Ptr> >& responses) {
+  MBMORE_TIME(kGetMatlTrades);
 
   using cyclus::Material;
   using cyclus::Trade;
@@ -313,6 +443,11 @@ void RandomEnrich::GetMatlTrades(
   intra_timestep_swu_ = 0;
   intra_timestep_feed_ = 0;
 
+  // with batch_enrich or a feed_optimizer, product trades are enriched
+  // together after the loop
+  bool together = batch_enrich || (feed_optimizer != "None");
+  std::vector< Trade<Material> > product_trades;
+
   std::vector< Trade<Material> >::const_iterator it;
   for (it = trades.begin(); it != trades.end(); ++it) {
     double qty = it->amt;
@@ -332,11 +467,34 @@ void RandomEnrich::GetMatlTrades(
 				       << " just received an order"
 				       << " for " << it->amt
 				       << " of " << product_commod;
+      if (together) {
+	product_trades.push_back(*it);
+	continue;
+      }
       response = Enrich_(it->bid->offer(), qty);
     }
     responses.push_back(std::make_pair(*it, response));	
   }
 
+  if (!product_trades.empty()) {
+    std::vector<Material::Ptr> products;
+    if (feed_optimizer != "None") {
+      products = EnrichOptimized_(product_trades);
+    }
+    if (products.empty() && batch_enrich) {
+      products = EnrichBatch_(product_trades);
+    }
+    else if (products.empty()) {
+      for (int i = 0; i < product_trades.size(); i++) {
+	products.push_back(Enrich_(product_trades[i].bid->offer(),
+				   product_trades[i].amt));
+      }
+    }
+    for (int i = 0; i < product_trades.size(); i++) {
+      responses.push_back(std::make_pair(product_trades[i], products[i]));
+    }
+  }
+
   if (cyclus::IsNegative(tails.quantity())) {
     std::stringstream ss;
     ss << "is being asked to provide more than its current inventory.";
@@ -351,35 +509,40 @@ void RandomEnrich::GetMatlTrades(
 }
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 void RandomEnrich::AddMat_(cyclus::Material::Ptr mat) {
-  // Elements and isotopes other than U-235, U-238 are sent directly to tails
-  cyclus::CompMap cm = mat->comp()->atom();
-  bool extra_u = false;
-  bool other_elem = false;
-  for (cyclus::CompMap::const_iterator it = cm.begin(); it != cm.end(); ++it) {
-    if (pyne::nucname::znum(it->first) == 92) {
-      if (pyne::nucname::anum(it->first) != 235 &&
-          pyne::nucname::anum(it->first) != 238 && it->second > 0) {
-	extra_u = true;
+  // Elements and isotopes other than U-235, U-238 are sent directly to tails.
+  // Each composition is checked (and warned about) only the first time it
+  // is received.
+  if (checked_comps_.insert(mat->comp()->id()).second) {
+    cyclus::CompMap cm = mat->comp()->atom();
+    bool extra_u = false;
+    bool other_elem = false;
+    for (cyclus::CompMap::const_iterator it = cm.begin(); it != cm.end();
+	 ++it) {
+      if (pyne::nucname::znum(it->first) == 92) {
+	if (pyne::nucname::anum(it->first) != 235 &&
+	    pyne::nucname::anum(it->first) != 238 && it->second > 0) {
+	  extra_u = true;
+	}
+      }
+      else if (it->second > 0) {
+	other_elem = true ;
       }
     }
-    else if (it->second > 0) {
-      other_elem = true ;
+    if (extra_u) {
+      cyclus::Warn<cyclus::VALUE_WARNING> ("More than 2 isotopes of U.  "  \
+        "Istopes other than U-235, U-238 are sent directly to tails.");
+    }
+    if (other_elem) {
+      cyclus::Warn<cyclus::VALUE_WARNING> ("Non-uranium elements are "   \
+        "sent directly to tails.");
     }
-  }
-  if (extra_u) {
-    cyclus::Warn<cyclus::VALUE_WARNING> ("More than 2 isotopes of U.  "  \
-      "Istopes other than U-235, U-238 are sent directly to tails.");
-  }
-  if (other_elem) {
-    cyclus::Warn<cyclus::VALUE_WARNING> ("Non-uranium elements are "   \
-      "sent directly to tails.");
   }
 
   LOG(cyclus::LEV_INFO5, "EnrFac") << prototype() << " is initially holding "
 				   << inventory.quantity() << " total.";
   
   try {
-    inventory.Push(mat);
+    PushFeed_(mat);
   }
   catch (cyclus::Error& e) {
     e.msg(Agent::InformErrorMsg(e.msg()));
@@ -412,6 +575,7 @@ cyclus::Material::Ptr RandomEnrich::Offer_(cyclus::Material::Ptr mat) {
 cyclus::Material::Ptr RandomEnrich::Enrich_(
     cyclus::Material::Ptr mat,
     double qty) {
+  MBMORE_TRACE("Enrich_");
 
   using cyclus::Material;
   using cyclus::ResCast;
@@ -423,31 +587,15 @@ cyclus::Material::Ptr RandomEnrich::Enrich_(
 
   // get enrichment parameters
   double u_assay = UraniumAssay(mat);
-  Assays assays(FeedAssay(), u_assay, curr_tails_assay);
+  double feed_assay;
+  double feed_req = FeedRequired_(u_assay, qty, 0, &feed_assay);
+  Assays assays(feed_assay, u_assay, curr_tails_assay);
   double swu_req = SwuRequired(qty, assays);
-  double natu_req = FeedQty(qty, assays);
-
-  // Determine the composition of the natural uranium
-  // (ie. U-235+U-238/TotalMass)
-  Material::Ptr natu_matl=inventory.Pop(inventory.quantity());
-  inventory.Push(natu_matl);
-  
-  cyclus::toolkit::MatQuery mq(natu_matl);
-  std::set<cyclus::Nuc> nucs;
-  nucs.insert(922350000);
-  nucs.insert(922380000);
-  double natu_frac = mq.mass_frac(nucs);
-  double feed_req = natu_req/natu_frac;
 
   // pop amount from inventory and blob it into one material
   Material::Ptr r;
   try {
-    // required so popping doesn't take out too much
-    if (cyclus::AlmostEq(feed_req, inventory.quantity())) {
-      r = cyclus::toolkit::Squash(inventory.PopN(inventory.count()));
-    } else {
-      r = inventory.Pop(feed_req);
-    }
+    r = PopFeed_(feed_req);
   } catch (cyclus::Error& e) {
     NatUConverter nc(FeedAssay(), curr_tails_assay);
     std::stringstream ss;
@@ -498,6 +646,230 @@ cyclus::Material::Ptr RandomEnrich::Enrich_(
   return response;
 }
 
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Same enrichment as Enrich_ for each trade, with one pop of feed, one tails
+// material and one record for all of them
+std::vector<cyclus::Material::Ptr> RandomEnrich::EnrichBatch_(
+    const std::vector< cyclus::Trade<cyclus::Material> >& trades) {
+  MBMORE_TRACE("EnrichBatch_");
+
+  using cyclus::Material;
+  using cyclus::toolkit::Assays;
+  using cyclus::toolkit::UraniumAssay;
+  using cyclus::toolkit::SwuRequired;
+  using cyclus::toolkit::FeedQty;
+
+  // Determine the assay and the composition of the natural uranium
+  // (ie. U-235+U-238/TotalMass) once for all trades. With the HighAssay
+  // feed_policy each trade instead draws the richest feed left after the
+  // earlier trades.
+  bool high_assay = (feed_policy == "HighAssay");
+  double feed_assay = 0;
+  double natu_frac = 1;
+  if (!high_assay) {
+    feed_assay = FeedAssay();
+    Material::Ptr natu_matl=inventory.Pop(inventory.quantity());
+    inventory.Push(natu_matl);
+
+    cyclus::toolkit::MatQuery mq(natu_matl);
+    std::set<cyclus::Nuc> nucs;
+    nucs.insert(922350000);
+    nucs.insert(922380000);
+    natu_frac = mq.mass_frac(nucs);
+  }
+
+  // total the feed and SWU needed by all the trades
+  double heu_definition = 0.2;
+  double swu_tot = 0;
+  double feed_tot = 0;
+  double product_tot = 0;
+  for (int i = 0; i < trades.size(); i++) {
+    double qty = trades[i].amt;
+    double u_assay = UraniumAssay(trades[i].bid->offer());
+    double feed = 0;
+    if (high_assay) {
+      feed = FeedRequired_(u_assay, qty, feed_tot, &feed_assay);
+    } else {
+      feed = FeedQty(qty, Assays(feed_assay, u_assay, curr_tails_assay)) /
+	natu_frac;
+    }
+    Assays assays(feed_assay, u_assay, curr_tails_assay);
+    swu_tot += SwuRequired(qty, assays);
+    feed_tot += feed;
+    product_tot += qty;
+    // If enriched to HEU then record total HEU produced
+    if (u_assay > heu_definition){
+      net_heu += qty;
+    }
+  }
+
+  // pop the feed of all trades from inventory and blob it into one material
+  Material::Ptr r;
+  try {
+    r = PopFeed_(feed_tot);
+  } catch (cyclus::Error& e) {
+    std::stringstream ss;
+    ss << " tried to remove " << feed_tot
+       << " from its inventory of size " << inventory.quantity()
+       << " to enrich " << trades.size() << " trades";
+    throw cyclus::ValueError(Agent::InformErrorMsg(ss.str()));
+  }
+
+  // "enrich" it, pulling out the composition and quantity of each trade
+  // from the blob
+  std::vector<Material::Ptr> products;
+  products.reserve(trades.size());
+  for (int i = 0; i < trades.size(); i++) {
+    products.push_back(r->ExtractComp(trades[i].amt,
+				      trades[i].bid->offer()->comp()));
+  }
+  tails.Push(r);
+
+  current_swu_capacity -= swu_tot;
+
+  intra_timestep_swu_ += swu_tot;
+  intra_timestep_feed_ += feed_tot;
+  RecordRandomEnrich_(feed_tot, swu_tot);
+
+  LOG(cyclus::LEV_INFO5, "EnrFac") << prototype() << " has performed "
+				   << trades.size() << " enrichments: ";
+  LOG(cyclus::LEV_INFO5, "EnrFac") << "   * Feed Qty: " << feed_tot;
+  LOG(cyclus::LEV_INFO5, "EnrFac") << "   * Product Qty: " << product_tot;
+  LOG(cyclus::LEV_INFO5, "EnrFac") << "   * Tails Qty: " << r->quantity();
+  LOG(cyclus::LEV_INFO5, "EnrFac") << "   * SWU: " << swu_tot;
+  LOG(cyclus::LEV_INFO5, "EnrFac") << "   * Current SWU capacity: "
+				   << current_swu_capacity;
+
+  return products;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// The feed inventory is grouped into assay bins, and the FeedBlend linear
+// program chooses how much of each order to make from each bin
+std::vector<cyclus::Material::Ptr> RandomEnrich::EnrichOptimized_(
+    const std::vector< cyclus::Trade<cyclus::Material> >& trades) {
+  MBMORE_TRACE("EnrichOptimized_");
+
+  using cyclus::Material;
+  using cyclus::toolkit::UraniumAssay;
+
+  // merge the feed materials within each assay bin
+  std::vector<Material::Ptr> mats = inventory.PopN(inventory.count());
+  std::map<long, Material::Ptr> binned;
+  for (int m = 0; m < mats.size(); m++) {
+    long key = (feed_bin_width > 0) ?
+      static_cast<long>(std::floor(UraniumAssay(mats[m]) / feed_bin_width)) :
+      mats[m]->comp()->id();
+    std::map<long, Material::Ptr>::iterator it = binned.find(key);
+    if (it == binned.end()) {
+      binned[key] = mats[m];
+    }
+    else {
+      it->second->Absorb(mats[m]);
+    }
+  }
+
+  std::set<cyclus::Nuc> nucs;
+  nucs.insert(922350000);
+  nucs.insert(922380000);
+  std::vector<Material::Ptr> bin_mats;
+  std::vector<FeedBin> bins;
+  std::map<long, Material::Ptr>::iterator it;
+  for (it = binned.begin(); it != binned.end(); ++it) {
+    cyclus::toolkit::MatQuery mq(it->second);
+    FeedBin bin = {UraniumAssay(it->second), mq.mass_frac(nucs),
+		   it->second->quantity()};
+    bins.push_back(bin);
+    bin_mats.push_back(it->second);
+  }
+
+  std::vector<FeedOrder> orders;
+  for (int i = 0; i < trades.size(); i++) {
+    FeedOrder order = {UraniumAssay(trades[i].bid->offer()), trades[i].amt};
+    orders.push_back(order);
+  }
+
+  FeedBlend blend(feed_optimizer, curr_tails_assay);
+  if (!blend.Solve(bins, orders, current_swu_capacity)) {
+    inventory.Push(bin_mats);
+    LOG(cyclus::LEV_INFO4, "EnrFac") << prototype() << " could not "
+				     << "optimize its feed, enriching from "
+				     << "the merged inventory instead";
+    return std::vector<Material::Ptr>();
+  }
+
+  // "enrich" each order's share of each bin, pulling the product out of the
+  // feed taken from the bin and sending the rest to the tails
+  double heu_definition = 0.2;
+  std::vector<Material::Ptr> products;
+  Material::Ptr tails_mat;
+  for (int i = 0; i < trades.size(); i++) {
+    cyclus::Composition::Ptr comp = trades[i].bid->offer()->comp();
+    Material::Ptr product;
+    for (int b = 0; b < bin_mats.size(); b++) {
+      if (blend.product(i, b) <= 0) {
+	continue;
+      }
+      double feed_qty = std::min(blend.feed(i, b), bin_mats[b]->quantity());
+      Material::Ptr feed = bin_mats[b]->ExtractQty(feed_qty);
+      Material::Ptr part = feed->ExtractComp(blend.product(i, b), comp);
+      if (product == NULL) {
+	product = part;
+      } else {
+	product->Absorb(part);
+      }
+      if (tails_mat == NULL) {
+	tails_mat = feed;
+      } else {
+	tails_mat->Absorb(feed);
+      }
+    }
+    if (product == NULL) {
+      std::stringstream ss;
+      ss << " found no feed for a trade of " << trades[i].amt
+	 << " kg after optimizing its feed";
+      throw cyclus::ValueError(Agent::InformErrorMsg(ss.str()));
+    }
+    products.push_back(product);
+    if (orders[i].assay > heu_definition){
+      net_heu += orders[i].qty;
+    }
+  }
+  // what is left of each bin goes back, and is the whole feed pool
+  if (feed_policy == "HighAssay") {
+    feed_pool_.Clear();
+  }
+  for (int b = 0; b < bin_mats.size(); b++) {
+    if (bin_mats[b]->quantity() > 0) {
+      inventory.Push(bin_mats[b]);
+      if (feed_policy == "HighAssay") {
+	feed_pool_.Add(bins[b].assay, bins[b].u_frac,
+		       bin_mats[b]->quantity());
+      }
+    }
+  }
+  if (tails_mat != NULL) {
+    tails.Push(tails_mat);
+  }
+
+  double swu = blend.total_swu();
+  double feed = blend.total_feed();
+  current_swu_capacity -= swu;
+  intra_timestep_swu_ += swu;
+  intra_timestep_feed_ += feed;
+  RecordRandomEnrich_(feed, swu);
+
+  LOG(cyclus::LEV_INFO5, "EnrFac") << prototype() << " has performed "
+				   << trades.size() << " enrichments from "
+				   << bins.size() << " feed assays: ";
+  LOG(cyclus::LEV_INFO5, "EnrFac") << "   * Feed Qty: " << feed;
+  LOG(cyclus::LEV_INFO5, "EnrFac") << "   * SWU: " << swu;
+  LOG(cyclus::LEV_INFO5, "EnrFac") << "   * Current SWU capacity: "
+				   << current_swu_capacity;
+
+  return products;
+}
+
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 void RandomEnrich::RecordRandomEnrich_(double natural_u, double swu) {
   using cyclus::Context;
@@ -545,7 +917,9 @@ void RandomEnrich::RecordInspection_() {
     // shipping.
     std::cout << "Inspect Time: " << cur_time <<  "  Net HEU produced " << net_heu << std::endl;
     if ((net_heu >= heu_ship_qty) && (heu_ship_qty > 0.0)){
-      HEU_present = XLikely(cur_time/(double(simdur) - 1.0), rng_seed);
+      HEU_present = rng_streams ?
+	XLikely(cur_time/(double(simdur) - 1.0), swipe_rng_) :
+	XLikely(cur_time/(double(simdur) - 1.0), rng_seed);
       std::cout << "HEU Presence? " << HEU_present << std::endl;
       net_heu -= heu_ship_qty;
     }
@@ -553,7 +927,9 @@ void RandomEnrich::RecordInspection_() {
   else if ((net_heu > 0.0) && (HEU_present == false)){
     // HEU is made/shipped at specific intervals defined by behavior fns,
     // so test whether any has been made/shipped since last inspection
-    HEU_present = XLikely(cur_time/(double(simdur) - 1.0), rng_seed);
+    HEU_present = rng_streams ?
+	XLikely(cur_time/(double(simdur) - 1.0), swipe_rng_) :
+	XLikely(cur_time/(double(simdur) - 1.0), rng_seed);
   }
 
   // Each sample is N swipes, analyzed independently (with a high rate of
@@ -572,7 +948,8 @@ void RandomEnrich::RecordInspection_() {
     else {
       prob = false_pos;
     }
-    bool flip = XLikely(prob, rng_seed);
+    bool flip = rng_streams ? XLikely(prob, swipe_rng_) :
+      XLikely(prob, rng_seed);
     //    std::cout << "Flip? " << flip << std::endl;
 
     // record false positives, false negatives and net 'positive' swipe results
@@ -613,6 +990,21 @@ void RandomEnrich::RecordInspection_() {
   
 }
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Streams are keyed by the institution and facility names (not agent ids) so
+// that they are the same in two scenarios that differ elsewhere. Identically
+// named facilities are numbered in the order they are created.
+void RandomEnrich::InitRngStreams_() {
+  if (!rng_streams) {
+    return;
+  }
+  uint64_t seed = RngStream::BaseSeed(rng_seed);
+  std::string owner = RngStream::AgentOwner(this);
+  trade_rng_.Seed(seed, owner, "trade_timing");
+  tails_rng_.Seed(seed, owner, "tails");
+  inspect_rng_.Seed(seed, owner, "inspection");
+  swipe_rng_.Seed(seed, owner, "swipes");
+}
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 // Decide whether each individual bid will be responded to based on whether
 // the enrichment facility is trading
 cyclus::BidPortfolio<cyclus::Material>::Ptr RandomEnrich::ConsiderMatlRequests(
@@ -623,25 +1015,58 @@ cyclus::BidPortfolio<cyclus::Material>::Ptr RandomEnrich::ConsiderMatlRequests(
   using cyclus::Request;
 
   BidPortfolio<Material>::Ptr commod_port(new BidPortfolio<Material>());
-  
+
+  // if social behavior on and logic says no trade. The cache only holds the
+  // offers of the last timestep, so it is emptied as if no requests came.
+  if (!trade_timestep) {
+    bid_cache_.clear();
+    return commod_port;
+  }
+
+  // with cache_bids, offers to requests unchanged since the last timestep
+  // are reused; only their assay is checked against this timestep's tails
+  std::map<BidKey_, BidEntry_> next_cache;
+  double bid_tails = BidTails_();
+
   std::vector<Request<Material>*>& commod_requests =
     out_requests[product_commod];
   std::vector<Request<Material>*>::iterator it;
   for (it = commod_requests.begin(); it != commod_requests.end(); ++it) {
     Request<Material>* req = *it;
     Material::Ptr mat = req->target();
-    double request_enrich = cyclus::toolkit::UraniumAssay(mat) ;
-    int cur_time = context()->time();
-    // if social behavior on and logic says no trade
-    if (!trade_timestep) {
-	return commod_port ;
+    BidKey_ key;
+    bool cached = false;
+    BidEntry_ entry;
+    if (cache_bids) {
+      key = BidKey_(std::make_pair(req->requester()->manager()->id(),
+				   req->commodity()),
+		    std::make_pair(mat->quantity(), mat->comp()->id()));
+      bid_cache_lookups_++;
+      std::map<BidKey_, BidEntry_>::iterator found = bid_cache_.find(key);
+      if (found != bid_cache_.end()) {
+	entry = found->second;
+	cached = true;
+	bid_cache_hits_++;
+      }
+    }
+    if (!cached) {
+      double request_enrich = cyclus::toolkit::UraniumAssay(mat) ;
+      entry.first = ReqAssay_(mat);
+      if ((entry.first > 0) && (request_enrich <= max_enrich)) {
+	entry.second = Offer_(mat);
+      }
     }
-    if (ValidReq(req->target()) && request_enrich <= max_enrich) {
-      Material::Ptr offer = Offer_(req->target());
-      commod_port->AddBid(req, offer, this);
+    if (cache_bids) {
+      next_cache[key] = entry;
+    }
+    if ((entry.second != NULL) && (entry.first > bid_tails)) {
+      commod_port->AddBid(req, entry.second, this);
     }
   } //for each out commod
 
+  if (cache_bids) {
+    bid_cache_.swap(next_cache);
+  }
   return commod_port;
 }
 
@@ -652,11 +1077,233 @@ double RandomEnrich::FeedAssay() {
   if (inventory.empty()) {
     return 0;
   }
+  if (feed_policy == "HighAssay") {
+    if (!feed_indexed_) {
+      IndexFeed_();
+    }
+    return feed_pool_.assay();
+  }
+  // the feed optimizer needs the materials kept apart, so average their
+  // assays instead of merging them
+  if (feed_optimizer != "None") {
+    std::vector<Material::Ptr> mats = inventory.PopN(inventory.count());
+    inventory.Push(mats);
+    double u235 = 0;
+    double u = 0;
+    for (int i = 0; i < mats.size(); i++) {
+      cyclus::toolkit::MatQuery mq(mats[i]);
+      u235 += mq.mass(922350000);
+      u += mq.mass(922350000) + mq.mass(922380000);
+    }
+    return (u > 0) ? u235 / u : 0;
+  }
   cyclus::Material::Ptr fission_matl = inventory.Pop(inventory.quantity());
   inventory.Push(fission_matl);
   return cyclus::toolkit::UraniumAssay(fission_matl); 
 }
 
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// The feed optimizer's bins are drawn from a pool made of the lots below the
+// product assay; with feed_bin_width 0 each assay is its own bin.
+FeedDraw RandomEnrich::BidFeed_(double product_assay, double product_qty) {
+  using cyclus::Material;
+  using cyclus::toolkit::UraniumAssay;
+
+  if (feed_policy == "HighAssay") {
+    if (!feed_indexed_) {
+      IndexFeed_();
+    }
+    return feed_pool_.Draw(product_assay, product_qty, curr_tails_assay);
+  }
+  FeedDraw none = {0, 0, false};
+  if (feed_optimizer == "None") {
+    return none;
+  }
+
+  FeedPool pool((feed_bin_width > 0) ? feed_bin_width : 1e-12);
+  std::vector<Material::Ptr> mats = inventory.PopN(inventory.count());
+  inventory.Push(mats);
+  std::set<cyclus::Nuc> nucs;
+  nucs.insert(922350000);
+  nucs.insert(922380000);
+  for (int m = 0; m < mats.size(); m++) {
+    double assay = UraniumAssay(mats[m]);
+    if (assay < product_assay) {
+      cyclus::toolkit::MatQuery mq(mats[m]);
+      pool.Add(assay, mq.mass_frac(nucs), mats[m]->quantity());
+    }
+  }
+  return pool.Draw(product_assay, product_qty, curr_tails_assay);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+double RandomEnrich::FeedRequired_(double product_assay, double qty,
+				   double skip, double* feed_assay) {
+  using cyclus::Material;
+  using cyclus::toolkit::Assays;
+  using cyclus::toolkit::FeedQty;
+
+  if (feed_policy == "HighAssay") {
+    if (!feed_indexed_) {
+      IndexFeed_();
+    }
+    FeedDraw draw = feed_pool_.Draw(product_assay, qty, curr_tails_assay,
+				    skip);
+    if (!draw.enough) {
+      std::stringstream ss;
+      ss << " does not hold enough feed above the tails assay to enrich "
+	 << qty << " kg to " << product_assay;
+      throw cyclus::ValueError(Agent::InformErrorMsg(ss.str()));
+    }
+    *feed_assay = draw.assay;
+    return draw.qty;
+  }
+
+  *feed_assay = FeedAssay();
+  // Determine the composition of the natural uranium
+  // (ie. U-235+U-238/TotalMass)
+  Material::Ptr natu_matl=inventory.Pop(inventory.quantity());
+  inventory.Push(natu_matl);
+
+  cyclus::toolkit::MatQuery mq(natu_matl);
+  std::set<cyclus::Nuc> nucs;
+  nucs.insert(922350000);
+  nucs.insert(922380000);
+  double natu_frac = mq.mass_frac(nucs);
+  Assays assays(*feed_assay, product_assay, curr_tails_assay);
+  return FeedQty(qty, assays) / natu_frac;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// The inventory keeps the feed lots as they arrive; for the HighAssay
+// feed_policy only the bin of each new lot in the feed pool is updated.
+void RandomEnrich::PushFeed_(cyclus::Material::Ptr mat) {
+  if (feed_policy != "HighAssay") {
+    inventory.Push(mat);
+    return;
+  }
+  if (!feed_indexed_) {
+    IndexFeed_();
+  }
+  inventory.Push(mat);
+  cyclus::toolkit::MatQuery mq(mat);
+  std::set<cyclus::Nuc> nucs;
+  nucs.insert(922350000);
+  nucs.insert(922380000);
+  feed_pool_.Add(cyclus::toolkit::UraniumAssay(mat), mq.mass_frac(nucs),
+		 mat->quantity());
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// For the HighAssay feed_policy the lots are taken whole, bin by bin from
+// the richest (oldest first within a bin), and the last one in part. The
+// other lots go back in the order they were.
+cyclus::Material::Ptr RandomEnrich::PopFeed_(double qty) {
+  using cyclus::Material;
+
+  if (feed_policy != "HighAssay") {
+    // required so popping doesn't take out too much
+    if (cyclus::AlmostEq(qty, inventory.quantity())) {
+      return cyclus::toolkit::Squash(inventory.PopN(inventory.count()));
+    }
+    return inventory.Pop(qty);
+  }
+
+  if (!feed_indexed_) {
+    IndexFeed_();
+  }
+  if ((qty > inventory.quantity()) &&
+      !cyclus::AlmostEq(qty, inventory.quantity())) {
+    throw cyclus::ValueError("not enough feed in the inventory");
+  }
+  std::vector<Material::Ptr> mats = inventory.PopN(inventory.count());
+  std::multimap<long, int, std::greater<long> > by_bin;
+  for (int m = 0; m < mats.size(); m++) {
+    by_bin.insert(std::make_pair(
+      feed_pool_.Bin(cyclus::toolkit::UraniumAssay(mats[m])), m));
+  }
+
+  Material::Ptr r;
+  double left = qty;
+  std::multimap<long, int, std::greater<long> >::iterator it;
+  for (it = by_bin.begin(); (it != by_bin.end()) && (left > 0); ++it) {
+    Material::Ptr& lot = mats[it->second];
+    Material::Ptr part;
+    if ((lot->quantity() <= left) || cyclus::AlmostEq(lot->quantity(), left)) {
+      part = lot;
+      lot = Material::Ptr();
+    } else {
+      part = lot->ExtractQty(left);
+    }
+    left -= part->quantity();
+    if (r == NULL) {
+      r = part;
+    } else {
+      r->Absorb(part);
+    }
+  }
+  for (int m = 0; m < mats.size(); m++) {
+    if (mats[m] != NULL) {
+      inventory.Push(mats[m]);
+    }
+  }
+  feed_pool_.Take(r->quantity());
+  return r;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void RandomEnrich::IndexFeed_() {
+  using cyclus::Material;
+
+  feed_pool_ = FeedPool(feed_bin_width);
+  std::vector<Material::Ptr> mats = inventory.PopN(inventory.count());
+  inventory.Push(mats);
+
+  std::set<cyclus::Nuc> nucs;
+  nucs.insert(922350000);
+  nucs.insert(922380000);
+  for (int m = 0; m < mats.size(); m++) {
+    cyclus::toolkit::MatQuery mq(mats[m]);
+    feed_pool_.Add(cyclus::toolkit::UraniumAssay(mats[m]), mq.mass_frac(nucs),
+		   mats[m]->quantity());
+  }
+  feed_indexed_ = true;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+double RandomEnrich::OptimalTails_(double product_assay) {
+  using cyclus::Material;
+
+  if (!tails_opt_ready_) {
+    tails_opt_ = TailsOptimizer(tails_assay - sigma_tails,
+				tails_assay + sigma_tails);
+    tails_opt_ready_ = true;
+  }
+  double feed_assay = FeedAssay();
+  double feed_u;
+  if (feed_policy == "HighAssay") {
+    feed_u = feed_pool_.uranium();
+  } else {
+    // sum over the materials rather than merging them, so that the feed
+    // optimizer can still pick among them
+    std::vector<Material::Ptr> mats = inventory.PopN(inventory.count());
+    inventory.Push(mats);
+    feed_u = 0;
+    for (int i = 0; i < mats.size(); i++) {
+      cyclus::toolkit::MatQuery mq(mats[i]);
+      feed_u += mq.mass(922350000) + mq.mass(922380000);
+    }
+  }
+  double best = tails_opt_.Best(feed_assay, product_assay,
+				current_swu_capacity, feed_u);
+
+  LOG(cyclus::LEV_INFO4, "EnrFac") << prototype() << " chose a tails assay "
+				   << "of " << best << " for "
+				   << current_swu_capacity << " SWU and "
+				   << feed_u << " kg of uranium feed";
+  return best;
+}
+
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 extern "C" cyclus::Agent* ConstructRandomEnrich(cyclus::Context* ctx) {
   return new RandomEnrich(ctx);
@@ -1,9 +1,18 @@
 #ifndef MBMORE_SRC_ENRICHMENT_H_
 #define MBMORE_SRC_ENRICHMENT_H_
 
+#include <map>
+#include <set>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "cyclus.h"
+#include "agent_timings.h"
+#include "buffer_stats.h"
+#include "feed_pool.h"
+#include "tails_optimizer.h"
+#include "rng_stream.h"
 #include "sim_init.h"
 
 namespace mbmore {
@@ -82,6 +91,11 @@ class NatUConverter : public cyclus::Converter<cyclus::Material> {
   double feed_, tails_;
 };
 
+/// @brief orders bids by increasing U-235 mass fraction of their offers, used
+/// by RandomEnrich::AdjustMatlPrefs to prefer the richest feed
+bool SortBids(cyclus::Bid<cyclus::Material>* i,
+              cyclus::Bid<cyclus::Material>* j);
+
 ///  The RandomEnrich is based on the Cycamore Enrich facility.
 ///  It is a simple Agent that enriches natural
 ///  uranium in a Cyclus simulation. It does not explicitly compute
@@ -179,6 +193,9 @@ class RandomEnrich : public cyclus::Facility {
   // --- Facility Members ---
   /// perform module-specific tasks when entering the simulation
   virtual void Build(cyclus::Agent* parent);
+
+  /// seeds the random number streams (if rng_streams is set)
+  virtual void EnterNotify();
   // ---
 
   // --- Agent Members ---
@@ -246,6 +263,13 @@ class RandomEnrich : public cyclus::Facility {
 
   inline double SwuCapacity() const { return swu_capacity; }
 
+  ///  @brief fraction of product requests whose offer was taken from the
+  ///  previous timestep's (with cache_bids), over the simulation so far
+  inline double BidCacheHitRate() const {
+    return (bid_cache_lookups_ > 0) ?
+      static_cast<double>(bid_cache_hits_) / bid_cache_lookups_ : 0;
+  }
+
   inline const cyclus::toolkit::ResBuf<cyclus::Material>& Tails() const {
     return tails;
   } 
@@ -281,11 +305,71 @@ class RandomEnrich : public cyclus::Facility {
   ///  @param req the requested material being responded to
   cyclus::Material::Ptr Offer_(cyclus::Material::Ptr req);
 
+  ///  @brief U-235 to U-235 + U-238 atom ratio of a requested material, 0 if
+  ///  it holds no U-238 (see ValidReq)
+  double ReqAssay_(const cyclus::Material::Ptr mat);
+
+  ///  @brief tails assay product requests must be above to be bid to: that
+  ///  of the timestep, or with the Optimal tails_policy the highest it can
+  ///  be chosen (it is chosen after the requests are checked)
+  double BidTails_() const;
+
   cyclus::Material::Ptr Enrich_(cyclus::Material::Ptr mat, double qty);
 
+  ///  @brief enriches the products of several trades together: the feed for
+  ///  all of them is popped from the inventory at once, each product is
+  ///  extracted from that one blob, and the rest is pushed to the tails as
+  ///  one material. The enrichment is recorded once.
+  ///
+  ///  @param trades product trades, each responded to with the offered
+  ///  composition and the traded quantity
+  ///  @return the product of each trade, in the same order
+  std::vector<cyclus::Material::Ptr> EnrichBatch_(
+    const std::vector< cyclus::Trade<cyclus::Material> >& trades);
+
+  ///  @brief enriches the products of several trades from the feed assay
+  ///  bins chosen by the feed_optimizer linear program (see FeedBlend).
+  ///  Each product has the offered composition and the traded quantity.
+  ///  @return the product of each trade, in the same order, or no products
+  ///  if the trades cannot be filled this way (the inventory is unchanged)
+  std::vector<cyclus::Material::Ptr> EnrichOptimized_(
+    const std::vector< cyclus::Trade<cyclus::Material> >& trades);
+
   ///  @brief calculates the feed assay based on the unenriched inventory
   double FeedAssay();
 
+  ///  @brief feed drawn richest first to make the product of the bids, for
+  ///  their SWU and natural uranium constraints: from the feed pool with
+  ///  the HighAssay feed_policy, and from the feed bins below the product
+  ///  assay with a feed_optimizer (the bins its linear program can use)
+  FeedDraw BidFeed_(double product_assay, double product_qty);
+
+  ///  @brief kg of feed material needed to enrich qty of product at
+  ///  product_assay, and the U-235 fraction of that feed. With the
+  ///  HighAssay feed_policy it is drawn from the richest bins, after the
+  ///  richest skip kg (feed already committed to other products);
+  ///  otherwise it is taken from the merged inventory.
+  double FeedRequired_(double product_assay, double qty, double skip,
+		       double* feed_assay);
+
+  ///  @brief tails assay within [tails_assay - sigma_tails,
+  ///  tails_assay + sigma_tails] that lets the remaining SWU capacity and
+  ///  feed deliver the most product at product_assay (see TailsOptimizer)
+  double OptimalTails_(double product_assay);
+
+  ///  @brief adds feed to the inventory, and to the feed pool index for the
+  ///  HighAssay feed_policy
+  void PushFeed_(cyclus::Material::Ptr mat);
+
+  ///  @brief pops qty kg of feed from the inventory as one material. With
+  ///  the HighAssay feed_policy the lots of the richest bins are taken
+  ///  first (and taken out of the feed pool index); otherwise the oldest.
+  cyclus::Material::Ptr PopFeed_(double qty);
+
+  ///  @brief rebuilds the feed pool index from the inventory lots, which
+  ///  are left as they are
+  void IndexFeed_();
+
   ///  @brief records and enrichment with the cyclus::Recorder
   void RecordRandomEnrich_(double natural_u, double swu);
 
@@ -294,6 +378,9 @@ class RandomEnrich : public cyclus::Facility {
   /// unique sampling location
   void RecordInspection_();
 
+  /// @brief seeds the named random number streams (if rng_streams is set)
+  void InitRngStreams_();
+
   #pragma cyclus var { \
     "tooltip": "feed commodity",					\
     "doc": "feed commodity that the enrichment facility accepts",	\
@@ -341,6 +428,20 @@ class RandomEnrich : public cyclus::Facility {
   }
   double sigma_tails;  
 
+  #pragma cyclus var { \
+    "default": "Normal",					\
+    "userlevel": 10,							\
+    "tooltip": "How the tails assay of each timestep is chosen",	\
+    "doc": "Normal draws it from the normal distribution given by " \
+           "tails_assay and sigma_tails. Optimal chooses, when bidding, " \
+           "the tails assay within [tails_assay - sigma_tails, " \
+           "tails_assay + sigma_tails] that lets the remaining SWU " \
+           "capacity and feed inventory deliver the most product. " \
+           "Product requests are then bid to only if they are above " \
+           "tails_assay + sigma_tails." \
+  }
+  std::string tails_policy;
+
   #pragma cyclus var {							\
     "default": 0, "tooltip": "initial uranium reserves (kg)",		\
     "uilabel": "Initial Feed Inventory",				\
@@ -382,6 +483,74 @@ class RandomEnrich : public cyclus::Facility {
            "so that EF chooses higher U235 content first" \
   }
   bool order_prefs;
+
+  #pragma cyclus var { \
+    "default": 0,						\
+    "userlevel": 10,							\
+    "tooltip": "Enrich all product trades of a timestep together",	\
+    "doc": "If 1, the products of all trades in a timestep are " \
+           "enriched from one pop of feed, the tails of the timestep are " \
+           "pushed as one material (and offered as one bid), and one " \
+           "enrichment is recorded per timestep. The products are the " \
+           "same as with 0, where each trade is enriched on its own." \
+  }
+  bool batch_enrich;
+
+  #pragma cyclus var { \
+    "default": "None",						\
+    "userlevel": 10,							\
+    "tooltip": "Choose the feed of each timestep's trades by LP",	\
+    "doc": "None takes feed from the merged inventory. SWU or NatU " \
+           "keep the feed inventory in assay bins (feed_bin_width " \
+           "wide) and, for the product trades of each timestep, solve a " \
+           "linear program for the feed to take from each bin that " \
+           "minimises the SWU or the feed used, within the SWU capacity. " \
+           "Bids are constrained at the assay of the feed drawn richest " \
+           "bin first from the bins below the product assay. If the " \
+           "trades cannot be filled that way, the merged inventory is " \
+           "used." \
+  }
+  std::string feed_optimizer;
+
+  #pragma cyclus var { \
+    "default": 1e-4,						\
+    "userlevel": 10,							\
+    "tooltip": "Assay width of feed bins for feed_optimizer",		\
+    "doc": "Feed materials whose U-235 fractions fall in the same " \
+           "interval of this width are merged into one bin by the " \
+           "feed_optimizer, and indexed as one bin by the HighAssay " \
+           "feed_policy. If 0, each " \
+           "composition is its own bin (feed_optimizer only)." \
+  }
+  double feed_bin_width;
+
+  #pragma cyclus var { \
+    "default": "FIFO",						\
+    "userlevel": 10,							\
+    "tooltip": "Order in which feed is withdrawn",			\
+    "doc": "FIFO enriches from the merged feed inventory. HighAssay " \
+           "indexes the inventory lots by assay bin (feed_bin_width " \
+           "wide), and withdraws feed from the lots of the richest " \
+           "bins, which needs less SWU per kg of product. The bid " \
+           "constraints and the enrichments then use the assay of the " \
+           "feed that would be withdrawn." \
+  }
+  std::string feed_policy;
+
+  #pragma cyclus var { \
+    "default": 0,						\
+    "userlevel": 10,							\
+    "tooltip": "Reuse bids to unchanged product requests",		\
+    "doc": "If 1, each product request is fingerprinted by its " \
+           "requester, commodity, quantity and composition, and if the " \
+           "same request was made in the previous timestep, the offer " \
+           "made to it then is bid again (if the request is above the " \
+           "tails assay of the timestep) instead of checking and decoding " \
+           "the request. The SWU and natural " \
+           "uranium converters and constraints are also reused while the " \
+           "feed assay, tails assay and inventory are unchanged." \
+  }
+  bool cache_bids;
   double initial_reserves;
   //***
   #pragma cyclus var {"default": "None", "tooltip": "social behavior" ,	\
@@ -437,6 +606,16 @@ class RandomEnrich : public cyclus::Facility {
                           "doc": "seed on current system time if set to -1," \
                                  " otherwise seed on number defined"}
   int rng_seed;
+
+  #pragma cyclus var {"default": 0, "tooltip": "Use named RNG streams", \
+                      "doc": "If 1, trade timing, tails assay, inspection " \
+                             "timing and inspection swipes each draw from " \
+                             "their own random number stream, seeded from " \
+                             "rng_seed, the names of the facility and its " \
+                             "institution, and the purpose. Paired runs of " \
+                             "two scenarios then line up draw for draw. If " \
+                             "0, all agents share one random sequence."}
+  bool rng_streams;
   //***
   
   #pragma cyclus var {						       \
@@ -450,6 +629,21 @@ class RandomEnrich : public cyclus::Facility {
 
   double current_swu_capacity;
 
+  #pragma cyclus var {"default": 0, "tooltip": "buffer sampling interval", \
+                      "doc": "If positive, the number of resources, total " \
+                             "quantity and approximate heap bytes of the " \
+                             "feed inventory and tails are written to the " \
+                             "BufferStats table every buffer_stats " \
+                             "timesteps. If 0, they are not sampled."}
+  int buffer_stats;
+
+  #pragma cyclus var {"default": 0, "tooltip": "maximum buffer growth", \
+                      "doc": "If positive (and buffer_stats is set), a " \
+                             "warning is given the first time the number of " \
+                             "resources in a buffer grows by more than this " \
+                             "many per timestep between two samples."}
+  double max_buffer_growth;
+
   #pragma cyclus var { 'capacity': 'max_feed_inventory' }
   cyclus::toolkit::ResBuf<cyclus::Material> inventory;  // natural u
   #pragma cyclus var {}
@@ -459,6 +653,52 @@ class RandomEnrich : public cyclus::Facility {
   // these help enable time series generation.
   double intra_timestep_swu_;
   double intra_timestep_feed_;
+
+  // random number streams for each purpose, used if rng_streams is set
+  mbmore::RngStream trade_rng_;
+  mbmore::RngStream tails_rng_;
+  mbmore::RngStream inspect_rng_;
+  mbmore::RngStream swipe_rng_;
+
+  // samples of the inventory and tails, if buffer_stats is set
+  mbmore::BufferStats buf_stats_;
+
+  // assay index of the inventory lots for the HighAssay feed_policy,
+  // rebuilt from the inventory (by IndexFeed_) when feed_indexed_ is false
+  mbmore::FeedPool feed_pool_;
+  bool feed_indexed_;
+
+  // searches and caches the best tails assay for the Optimal tails_policy,
+  // created on first use
+  mbmore::TailsOptimizer tails_opt_;
+  bool tails_opt_ready_;
+
+  // ids of the feed compositions already checked by AddMat_
+  std::set<int> checked_comps_;
+
+  // product request fingerprint, (requester id, commodity) and (quantity,
+  // composition id), for cache_bids
+  typedef std::pair<std::pair<int, std::string>, std::pair<double, int> >
+    BidKey_;
+  // U-235 fraction of the uranium of the product requests of the last
+  // timestep, and the offers made for them (null where none could be), which
+  // are bid again if the request is above the tails assay of the timestep
+  typedef std::pair<double, cyclus::Material::Ptr> BidEntry_;
+  std::map<BidKey_, BidEntry_> bid_cache_;
+  int bid_cache_hits_;
+  int bid_cache_lookups_;
+  // the last product constraints, and the feed assay, tails assay and
+  // inventory they were made for
+  std::vector< cyclus::CapacityConstraint<cyclus::Material> >
+    bid_constraints_;
+  double constraint_feed_assay_;
+  double constraint_tails_assay_;
+  double constraint_inventory_;
+
+#ifdef MBMORE_TIMINGS
+  // hot path timings of the current timestep (see agent_timings.h)
+  mbmore::AgentTimings timings_;
+#endif
   
   friend class RandomEnrichTest;
   // ---
@@ -1,6 +1,10 @@
 #include <gtest/gtest.h>
 
+#include <algorithm>
+
 #include "cyclus.h"
+#include "RandomEnrich.h"
+#include "feed_blend.h"
 
 using cyclus::QueryResult;
 using cyclus::Cond;
@@ -12,6 +16,15 @@ using cyclus::Composition;
 
 namespace mbmore {
   
+// reads the private feed state of a RandomEnrich
+class RandomEnrichTest {
+ public:
+  static const FeedPool& feed_pool(RandomEnrich* e) { return e->feed_pool_; }
+  static cyclus::toolkit::ResBuf<Material>& inventory(RandomEnrich* e) {
+    return e->inventory;
+  }
+};
+
 namespace randomenrichtests {
 
 Composition::Ptr c_nou235() {
@@ -37,6 +50,12 @@ Composition::Ptr c_leu() {
   m[922380000] = 0.96;
   return Composition::CreateFromMass(m);
 };
+Composition::Ptr c_leu5() {
+  cyclus::CompMap m;
+  m[922350000] = 0.05;
+  m[922380000] = 0.95;
+  return Composition::CreateFromMass(m);
+};
 Composition::Ptr c_heu() {
   cyclus::CompMap m;
   m[922350000] = 0.20;
@@ -314,6 +333,376 @@ TEST(RandomEnrichTests, TradeTails) {
     "Not providing the requested quantity" ;
 }
 
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST(RandomEnrichTests, BatchEnrich) {
+  // this tests that with batch_enrich the products of a timestep, and the
+  // feed and SWU they use in total, are the same as when each trade is
+  // enriched on its own (batch_enrich 0), and that their tails are pushed
+  // (and then traded) as one material
+
+  // time 1-source to EF, 2-Enrich, add to tails, 3-tails avail. for trade
+  int simdur = 3;
+  std::vector< std::pair<double, CompMap> > products[2];
+  double natu[2] = {0, 0};
+  double swu[2] = {0, 0};
+  for (int b = 0; b < 2; b++) {
+    std::string config = 
+      "   <feed_commod>natu</feed_commod> "
+      "   <feed_recipe>natu1</feed_recipe> "
+      "   <product_commod>enr_u</product_commod> "
+      "   <tails_commod>tails</tails_commod> "
+      "   <tails_assay>0.003</tails_assay> "
+      "   <batch_enrich>" + std::string(b ? "1" : "0") + "</batch_enrich> ";
+
+    cyclus::MockSim sim(cyclus::AgentSpec
+			(":mbmore:RandomEnrich"), config, simdur);
+    sim.AddRecipe("natu1", c_natu1());
+    sim.AddRecipe("leu", c_leu());
+    sim.AddRecipe("heu", c_heu());
+  
+    sim.AddSource("natu")
+      .recipe("natu1")
+      .Finalize();
+    sim.AddSink("enr_u")
+      .recipe("leu")
+      .capacity(0.5)
+      .Finalize();
+    sim.AddSink("enr_u")
+      .recipe("heu")
+      .capacity(0.2)
+      .Finalize();
+    sim.AddSink("tails")
+      .Finalize();
+
+    int id = sim.Run();
+
+    std::vector<Cond> conds;
+    conds.push_back(Cond("Commodity", "==", std::string("enr_u")));
+    conds.push_back(Cond("Time", "==", 1));
+    QueryResult qr = sim.db().Query("Transactions", &conds);
+    ASSERT_EQ(2, qr.rows.size());
+    for (int i = 0; i < qr.rows.size(); i++) {
+      Material::Ptr m = sim.GetMaterial(qr.GetVal<int>("ResourceId", i));
+      CompMap got = m->comp()->mass();
+      cyclus::compmath::Normalize(&got);
+      products[b].push_back(std::make_pair(m->quantity(), got));
+    }
+    std::sort(products[b].begin(), products[b].end());
+
+    conds.clear();
+    conds.push_back(Cond("ID", "==", id));
+    conds.push_back(Cond("Time", "==", 1));
+    qr = sim.db().Query("RandomEnrichs", &conds);
+    // one enrichment is recorded per trade, or one for the batch
+    EXPECT_EQ(b ? 1 : 2, qr.rows.size());
+    for (int i = 0; i < qr.rows.size(); i++) {
+      natu[b] += qr.GetVal<double>("Natural_Uranium", i);
+      swu[b] += qr.GetVal<double>("SWU", i);
+    }
+
+    if (b == 0) {
+      continue;
+    }
+    // Both enrichments' tails are one material, traded in one transaction
+    conds.clear();
+    conds.push_back(Cond("Commodity", "==", std::string("tails")));
+    qr = sim.db().Query("Transactions", &conds);
+    EXPECT_EQ(1, qr.rows.size());
+    Material::Ptr m = sim.GetMaterial(qr.GetVal<int>("ResourceId"));
+    EXPECT_NEAR(natu[b] - 0.7, m->quantity(), 1e-8);
+  }
+
+  // the same products, in order of quantity
+  for (int i = 0; i < 2; i++) {
+    EXPECT_NEAR(products[0][i].first, products[1][i].first, 1e-10);
+    CompMap& want = products[0][i].second;
+    CompMap& got = products[1][i].second;
+    CompMap::iterator it;
+    for (it = want.begin(); it != want.end(); ++it) {
+      EXPECT_DOUBLE_EQ(it->second, got[it->first]) <<
+	"nuclide qty off: " << pyne::nucname::name(it->first);
+    }
+  }
+  EXPECT_NEAR(natu[0], natu[1], 1e-10);
+  EXPECT_NEAR(swu[0], swu[1], 1e-10);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST(RandomEnrichTests, FeedOptimizer) {
+  // this tests that a feed_optimizer makes each product from the richer of
+  // two feeds, and that its bids are constrained at that feed's assay: the
+  // SWU capacity makes 1kg of leu from 1% feed (3.86 SWU) but not from the
+  // mean 0.85% feed (4.51 SWU), which is all that None delivers
+
+  // time 0-both feeds fill the inventory, 1-Enrich 2 x 0.5kg of leu
+  int simdur = 2;
+  std::string optimizers[] = {"None", "SWU", "NatU"};
+  for (int o = 0; o < 3; o++) {
+    std::string config = 
+      "   <feed_commod>natu</feed_commod> "
+      "   <feed_recipe>natu1</feed_recipe> "
+      "   <product_commod>enr_u</product_commod> "
+      "   <tails_commod>tails</tails_commod> "
+      "   <tails_assay>0.003</tails_assay> "
+      "   <max_feed_inventory>200</max_feed_inventory> "
+      "   <swu_capacity>4.2</swu_capacity> "
+      "   <feed_optimizer>" + optimizers[o] + "</feed_optimizer> ";
+
+    cyclus::MockSim sim(cyclus::AgentSpec
+			(":mbmore:RandomEnrich"), config, simdur);
+    sim.AddRecipe("natu1", c_natu1());
+    sim.AddRecipe("natu2", c_natu2());
+    sim.AddRecipe("leu", c_leu());
+
+    sim.AddSource("natu")
+      .recipe("natu1")
+      .capacity(100)
+      .Finalize();
+    sim.AddSource("natu")
+      .recipe("natu2")
+      .capacity(100)
+      .Finalize();
+    sim.AddSink("enr_u")
+      .recipe("leu")
+      .capacity(0.5)
+      .Finalize();
+    sim.AddSink("enr_u")
+      .recipe("leu")
+      .capacity(0.5)
+      .Finalize();
+
+    int id = sim.Run();
+
+    std::vector<Cond> conds;
+    conds.push_back(Cond("Commodity", "==", std::string("enr_u")));
+    conds.push_back(Cond("Time", "==", 1));
+    QueryResult qr = sim.db().Query("Transactions", &conds);
+    double product = 0;
+    for (int i = 0; i < qr.rows.size(); i++) {
+      Material::Ptr m = sim.GetMaterial(qr.GetVal<int>("ResourceId", i));
+      product += m->quantity();
+    }
+    if (optimizers[o] == "None") {
+      EXPECT_NEAR(4.2 / 4.5058, product, 1e-3) << optimizers[o];
+      continue;
+    }
+
+    ASSERT_EQ(2, qr.rows.size()) << optimizers[o];
+    CompMap want = c_leu()->mass();
+    cyclus::compmath::Normalize(&want);
+    for (int i = 0; i < qr.rows.size(); i++) {
+      Material::Ptr m = sim.GetMaterial(qr.GetVal<int>("ResourceId", i));
+      EXPECT_NEAR(0.5, m->quantity(), 1e-8) << optimizers[o];
+      CompMap got = m->comp()->mass();
+      cyclus::compmath::Normalize(&got);
+      CompMap::iterator it;
+      for (it = want.begin(); it != want.end(); ++it) {
+	EXPECT_NEAR(it->second, got[it->first], 1e-10) <<
+	  optimizers[o] << " nuclide qty off: " <<
+	  pyne::nucname::name(it->first);
+      }
+    }
+
+    // both products are made from the 1% feed
+    conds.clear();
+    conds.push_back(Cond("ID", "==", id));
+    conds.push_back(Cond("Time", "==", 1));
+    qr = sim.db().Query("RandomEnrichs", &conds);
+    ASSERT_EQ(1, qr.rows.size());
+    EXPECT_NEAR(0.037 / 0.007, qr.GetVal<double>("Natural_Uranium"), 1e-6);
+    EXPECT_NEAR(3.8552, qr.GetVal<double>("SWU"), 1e-3);
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST(RandomEnrichTests, FeedOptimizerFallback) {
+  // this tests that when the feed_optimizer cannot fill the trades, they
+  // are enriched from the merged inventory instead: the 5% feed is above
+  // the product assay, so only the 0.7% feed can be blended, and there is
+  // not enough of it for 1kg of leu
+
+  std::string config = 
+    "   <feed_commod>natu</feed_commod> "
+    "   <feed_recipe>leu5</feed_recipe> "
+    "   <product_commod>enr_u</product_commod> "
+    "   <tails_commod>tails</tails_commod> "
+    "   <tails_assay>0.003</tails_assay> "
+    "   <initial_feed>5</initial_feed> "
+    "   <max_feed_inventory>10</max_feed_inventory> "
+    "   <feed_optimizer>SWU</feed_optimizer> ";
+
+  // time 0-0.7% feed fills the inventory, 1-Enrich 1kg of leu
+  int simdur = 2;
+  cyclus::MockSim sim(cyclus::AgentSpec
+		      (":mbmore:RandomEnrich"), config, simdur);
+  sim.AddRecipe("natu1", c_natu1());
+  sim.AddRecipe("leu5", c_leu5());
+  sim.AddRecipe("leu", c_leu());
+
+  sim.AddSource("natu")
+    .recipe("natu1")
+    .Finalize();
+  sim.AddSink("enr_u")
+    .recipe("leu")
+    .capacity(1)
+    .start(1)
+    .Finalize();
+
+  int id = sim.Run();
+
+  std::vector<Cond> conds;
+  conds.push_back(Cond("Commodity", "==", std::string("enr_u")));
+  QueryResult qr = sim.db().Query("Transactions", &conds);
+  ASSERT_EQ(1, qr.rows.size());
+  Material::Ptr m = sim.GetMaterial(qr.GetVal<int>("ResourceId"));
+  EXPECT_NEAR(1, m->quantity(), 1e-8);
+  EXPECT_NEAR(0.04, cyclus::toolkit::UraniumAssay(m), 1e-10);
+
+  // the feed is the merged 2.85% inventory
+  conds.clear();
+  conds.push_back(Cond("ID", "==", id));
+  conds.push_back(Cond("Time", "==", 1));
+  qr = sim.db().Query("RandomEnrichs", &conds);
+  ASSERT_EQ(1, qr.rows.size());
+  EXPECT_NEAR(0.037 / 0.0255, qr.GetVal<double>("Natural_Uranium"), 1e-6);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST(RandomEnrichTests, CacheBids) {
+  // this tests that with cache_bids a sink making the same request every
+  // timestep is still bid to and enriched for at each of them, and that the
+  // offers are reused also when the tails assay changes every timestep
+
+  std::string sigmas[] = {"0", "0.0005"};
+  for (int s = 0; s < 2; s++) {
+    std::string config = 
+      "   <feed_commod>natu</feed_commod> "
+      "   <feed_recipe>natu1</feed_recipe> "
+      "   <product_commod>enr_u</product_commod> "
+      "   <tails_commod>tails</tails_commod> "
+      "   <tails_assay>0.003</tails_assay> "
+      "   <sigma_tails>" + sigmas[s] + "</sigma_tails> "
+      "   <cache_bids>1</cache_bids> ";
+
+    int simdur = 4;
+    cyclus::MockSim sim(cyclus::AgentSpec
+			(":mbmore:RandomEnrich"), config, simdur);
+    sim.AddRecipe("natu1", c_natu1());
+    sim.AddRecipe("leu", c_leu());
+  
+    sim.AddSource("natu")
+      .recipe("natu1")
+      .Finalize();
+    sim.AddSink("enr_u")
+      .recipe("leu")
+      .capacity(0.5)
+      .Finalize();
+
+    sim.Run();
+
+    std::vector<Cond> conds;
+    conds.push_back(Cond("Commodity", "==", std::string("enr_u")));
+    QueryResult qr = sim.db().Query("Transactions", &conds);
+    ASSERT_EQ(simdur - 1, qr.rows.size()) << "sigma_tails " << sigmas[s];
+    for (int i = 0; i < qr.rows.size(); i++) {
+      Material::Ptr m = sim.GetMaterial(qr.GetVal<int>("ResourceId", i));
+      EXPECT_NEAR(0.5, m->quantity(), 1e-10);
+      EXPECT_NEAR(cyclus::toolkit::UraniumAssay(
+		    Material::CreateUntracked(1, c_leu())),
+		  cyclus::toolkit::UraniumAssay(m), 1e-10);
+    }
+
+    // the offers after the first timestep come from the cache
+    RandomEnrich* enrich = dynamic_cast<RandomEnrich*>(sim.agent);
+    ASSERT_TRUE(enrich != NULL);
+    EXPECT_GT(enrich->BidCacheHitRate(), 0) << "sigma_tails " << sigmas[s];
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST(RandomEnrichTests, HighAssay) {
+  // this tests that with the HighAssay feed_policy the richer of two feeds
+  // is enriched first, with less SWU than from the mixed feed under FIFO,
+  // and that the feed pool still matches the inventory after only part of
+  // a lot was taken
+
+  // time 0-both feeds fill the inventory, 1-Enrich 1kg of leu
+  int simdur = 2;
+  std::string policies[] = {"FIFO", "HighAssay"};
+  double swu[2];
+  double natu[2];
+  for (int p = 0; p < 2; p++) {
+    std::string config = 
+      "   <feed_commod>natu</feed_commod> "
+      "   <feed_recipe>natu1</feed_recipe> "
+      "   <product_commod>enr_u</product_commod> "
+      "   <tails_commod>tails</tails_commod> "
+      "   <tails_assay>0.003</tails_assay> "
+      "   <max_feed_inventory>200</max_feed_inventory> "
+      "   <feed_policy>" + policies[p] + "</feed_policy> ";
+
+    cyclus::MockSim sim(cyclus::AgentSpec
+			(":mbmore:RandomEnrich"), config, simdur);
+    sim.AddRecipe("natu1", c_natu1());
+    sim.AddRecipe("natu2", c_natu2());
+    sim.AddRecipe("leu", c_leu());
+
+    sim.AddSource("natu")
+      .recipe("natu1")
+      .capacity(100)
+      .Finalize();
+    sim.AddSource("natu")
+      .recipe("natu2")
+      .capacity(100)
+      .Finalize();
+    sim.AddSink("enr_u")
+      .recipe("leu")
+      .capacity(1)
+      .Finalize();
+
+    int id = sim.Run();
+
+    std::vector<Cond> conds;
+    conds.push_back(Cond("ID", "==", id));
+    conds.push_back(Cond("Time", "==", 1));
+    QueryResult qr = sim.db().Query("RandomEnrichs", &conds);
+    ASSERT_EQ(1, qr.rows.size());
+    swu[p] = qr.GetVal<double>("SWU");
+    natu[p] = qr.GetVal<double>("Natural_Uranium");
+
+    if (policies[p] != "HighAssay") {
+      continue;
+    }
+    // 1kg of 4% from 1% feed with 0.3% tails
+    EXPECT_NEAR(0.037 / 0.007, natu[p], 1e-6);
+
+    // all of the 0.7% lot and the rest of the 1% lot are left
+    RandomEnrich* enrich = dynamic_cast<RandomEnrich*>(sim.agent);
+    ASSERT_TRUE(enrich != NULL);
+    cyclus::toolkit::ResBuf<Material>& inv =
+      RandomEnrichTest::inventory(enrich);
+    std::vector<Material::Ptr> mats = inv.PopN(inv.count());
+    inv.Push(mats);
+    EXPECT_EQ(2, mats.size());
+    double u = 0;
+    double u235 = 0;
+    for (int i = 0; i < mats.size(); i++) {
+      MatQuery mq(mats[i]);
+      u += mq.mass(922350000) + mq.mass(922380000);
+      u235 += mq.mass(922350000);
+    }
+    EXPECT_NEAR(0.7 + (100 - natu[p]) * 0.01, u235, 1e-6);
+
+    const FeedPool& pool = RandomEnrichTest::feed_pool(enrich);
+    EXPECT_NEAR(inv.quantity(), pool.quantity(), 1e-8);
+    EXPECT_NEAR(u, pool.uranium(), 1e-8);
+    EXPECT_NEAR(u235 / u, pool.assay(), 1e-10);
+    EXPECT_EQ(2, pool.n_bins());
+  }
+  EXPECT_LT(swu[1], swu[0]);
+  EXPECT_LT(natu[1], natu[0]);
+}
+
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 TEST(RandomEnrichTests, BidPrefs) {
   // This tests that natu sources are preference-ordered by
@@ -539,6 +928,64 @@ TEST(RandomEnrichTests, TestTailsAssay) {
 
 }
 
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST(RandomEnrichTests, OptimalTails) {
+  // With the Optimal tails_policy, the tails assay is the top of the band
+  // when SWU binds (1000kg of feed for 2 SWU) and the bottom when feed binds
+  // (20kg of feed for 1e4 SWU). The bids and the enrichment use the same
+  // value, so the SWU-bound product uses all of the SWU at that tails assay.
+
+  std::string swus[] = {"2", "1e4"};
+  std::string feeds[] = {"1000", "20"};
+  double want[] = {0.004, 0.002};
+  for (int c = 0; c < 2; c++) {
+    std::string config = 
+      "   <feed_commod>natu</feed_commod> "
+      "   <feed_recipe>natu1</feed_recipe> "
+      "   <product_commod>enr_u</product_commod> "
+      "   <tails_commod>tails</tails_commod> "
+      "   <tails_assay>0.003</tails_assay> "
+      "   <sigma_tails>0.001</sigma_tails> "
+      "   <tails_policy>Optimal</tails_policy> "
+      "   <swu_capacity>" + swus[c] + "</swu_capacity> "
+      "   <initial_feed>" + feeds[c] + "</initial_feed> "
+      "   <max_feed_inventory>" + feeds[c] + "</max_feed_inventory> ";
+
+    // time 0-Enrich from the initial feed, 1-tails avail. for trade
+    int simdur = 2;
+    cyclus::MockSim sim(cyclus::AgentSpec
+			(":mbmore:RandomEnrich"), config, simdur);
+    sim.AddRecipe("natu1", c_natu1());
+    sim.AddRecipe("leu", c_leu());
+
+    sim.AddSink("enr_u")
+      .recipe("leu")
+      .capacity(1.0)
+      .Finalize();
+    sim.AddSink("tails")
+      .Finalize();
+
+    sim.Run();
+
+    std::vector<Cond> conds;
+    conds.push_back(Cond("Commodity", "==", std::string("tails")));
+    QueryResult qr = sim.db().Query("Transactions", &conds);
+    ASSERT_EQ(1, qr.rows.size()) << "swu_capacity " << swus[c];
+    Material::Ptr m = sim.GetMaterial(qr.GetVal<int>("ResourceId"));
+    EXPECT_NEAR(want[c], cyclus::toolkit::UraniumAssay(m), 1e-8) <<
+      "swu_capacity " << swus[c];
+
+    conds.clear();
+    conds.push_back(Cond("Commodity", "==", std::string("enr_u")));
+    conds.push_back(Cond("Time", "==", 0));
+    qr = sim.db().Query("Transactions", &conds);
+    ASSERT_EQ(1, qr.rows.size()) << "swu_capacity " << swus[c];
+    m = sim.GetMaterial(qr.GetVal<int>("ResourceId"));
+    double product = (c == 0) ? 2 / SwuPerProduct(0.007, 0.04, 0.004) : 1.0;
+    EXPECT_NEAR(product, m->quantity(), 1e-6) << "swu_capacity " << swus[c];
+  }
+}
+
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 TEST(RandomEnrichTests, TestInspectionNegatives) {
   // Inspections occur with an average frequency (50%),
@@ -15,10 +15,15 @@ RandomSink::RandomSink(cyclus::Context* ctx)
       social_behav(""), //***
       behav_interval(0), //***
       rng_seed(0), //****
+      rng_streams(false),
       user_pref(1), //***
       sigma(0), //***
       t_trade(0), //***
-      max_inv_size(1e299) {}  // actually only used in header file
+      max_inv_size(1e299),  // actually only used in header file
+      buffer_stats(0),
+      max_buffer_growth(0),
+      account_only(false),
+      absorbed_qty(0) {}
 
 
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
@@ -65,6 +70,7 @@ std::string RandomSink::str() {
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 std::set<cyclus::RequestPortfolio<cyclus::Material>::Ptr>
 RandomSink::GetMatlRequests() {
+  MBMORE_TIME(kGetMatlRequests);
   using cyclus::Material;
   using cyclus::RequestPortfolio;
   using cyclus::Request;
@@ -135,6 +141,7 @@ RandomSink::GetGenRsrcRequests() {
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 void RandomSink::AdjustMatlPrefs(
   cyclus::PrefMap<cyclus::Material>::type& prefs) {
+  MBMORE_TIME(kAdjustMatlPrefs);
 
   using cyclus::Bid;
   using cyclus::Material;
@@ -153,10 +160,11 @@ void RandomSink::AdjustMatlPrefs(
 void RandomSink::AcceptMatlTrades(
     const std::vector< std::pair<cyclus::Trade<cyclus::Material>,
                                  cyclus::Material::Ptr> >& responses) {
+  MBMORE_TIME(kAcceptMatlTrades);
   std::vector< std::pair<cyclus::Trade<cyclus::Material>,
                          cyclus::Material::Ptr> >::const_iterator it;
   for (it = responses.begin(); it != responses.end(); ++it) {
-    inventory.Push(it->second);
+    Store_(it->second);
   }
 }
 
@@ -167,12 +175,52 @@ void RandomSink::AcceptGenRsrcTrades(
   std::vector< std::pair<cyclus::Trade<cyclus::Product>,
                          cyclus::Product::Ptr> >::const_iterator it;
   for (it = responses.begin(); it != responses.end(); ++it) {
-    inventory.Push(it->second);
+    Store_(it->second);
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// With account_only the resource is only counted, so the sink does not keep
+// every object it receives alive. The totals are limited by max_inv_size
+// like the inventory.
+void RandomSink::Store_(cyclus::Resource::Ptr r) {
+  if (!account_only) {
+    inventory.Push(r);
+    return;
+  }
+  if (Held() + r->quantity() - max_inv_size > cyclus::eps_rsrc()) {
+    throw cyclus::ValueError(Agent::InformErrorMsg(
+      "absorbing the resource would exceed max_inv_size"));
+  }
+  if (r->type() == cyclus::Material::kType) {
+    cyclus::Material::Ptr m = cyclus::ResCast<cyclus::Material>(r);
+    cyclus::CompMap mass = m->comp()->mass();
+    cyclus::compmath::Normalize(&mass, m->quantity());
+    cyclus::CompMap::const_iterator it;
+    for (it = mass.begin(); it != mass.end(); ++it) {
+      absorbed_comp[it->first] += it->second;
+    }
+  }
+  absorbed_qty += r->quantity();
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Streams are keyed by the institution and facility names so that they are
+// the same in two scenarios that differ elsewhere.
+void RandomSink::EnterNotify() {
+  cyclus::Facility::EnterNotify();
+  if (rng_streams) {
+    uint64_t seed = RngStream::BaseSeed(rng_seed);
+    std::string owner = RngStream::AgentOwner(this);
+    recipe_rng_.Seed(seed, owner, "recipe");
+    qty_rng_.Seed(seed, owner, "quantity");
+    trade_rng_.Seed(seed, owner, "trade_timing");
   }
 }
 
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 void RandomSink::Tick() {
+  MBMORE_TIME(kTick);
   using std::string;
   using std::vector;
   LOG(cyclus::LEV_INFO3, "SnkFac") << prototype() << " is ticking {";
@@ -183,7 +231,9 @@ void RandomSink::Tick() {
   // one randomly
   int n_recipes = recipe_names.size();
   if (n_recipes > 0) {
-    int curr_recipe_index = RNG_Integer(0.0, n_recipes, rng_seed);
+    int curr_recipe_index = rng_streams ?
+      RNG_Integer(0.0, n_recipes, recipe_rng_) :
+      RNG_Integer(0.0, n_recipes, rng_seed);
     curr_recipe = context()->GetRecipe(recipe_names[curr_recipe_index]);
   }
   else {
@@ -197,8 +247,11 @@ void RandomSink::Tick() {
   
   /// determine the amount to request
   // If sigma=0 then RNG is not queried
-  double desired_amt = RNG_NormalDist(avg_qty, sigma, rng_seed);
-  amt = std::min(desired_amt, std::max(0.0, inventory.space()));
+  double desired_amt = rng_streams ?
+    RNG_NormalDist(avg_qty, sigma, qty_rng_) :
+    RNG_NormalDist(avg_qty, sigma, rng_seed);
+  amt = std::min(desired_amt,
+		 std::max(0.0, inventory.space() - absorbed_qty));
 
   if (cur_time < t_trade) {
     std::cout << "Amt is zero because curr time " << cur_time << " <t_trade" << t_trade << std::endl;
@@ -213,7 +266,10 @@ void RandomSink::Tick() {
   }
   // Call EveryRandom only if the agent REALLY want it (dummyproofing)
   else if ((social_behav == "Random") && (amt > 0)){
-    if (!EveryRandomXTimestep(behav_interval, rng_seed)) // HEU randomly one in X times
+    bool res = rng_streams ?
+      EveryRandomXTimestep(behav_interval, trade_rng_) :
+      EveryRandomXTimestep(behav_interval, rng_seed);
+    if (!res) // HEU randomly one in X times
       {
 	std::cout << "Amt is zero because Random is negatvive " << std::endl;
 	amt = 0;
@@ -221,7 +277,9 @@ void RandomSink::Tick() {
   }
   // If reference, query RNG but force trade as zero quantity.
   else if ((social_behav == "Reference") && (amt > 0)){
-    bool res = EveryRandomXTimestep(behav_interval, rng_seed);
+    bool res = rng_streams ?
+      EveryRandomXTimestep(behav_interval, trade_rng_) :
+      EveryRandomXTimestep(behav_interval, rng_seed);
     std::cout << "Amt is zero because Reference superficially queries RNG " << std::endl;
     amt = 0;
   }
@@ -240,15 +298,21 @@ void RandomSink::Tick() {
 
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 void RandomSink::Tock() {
+  MBMORE_TIME_TOCK();
   LOG(cyclus::LEV_INFO3, "SnkFac") << prototype() << " is tocking {";
 
   // On the tock, the sink facility doesn't really do much.
   // Maybe someday it will record things.
   // For now, lets just print out what we have at each timestep.
   LOG(cyclus::LEV_INFO4, "SnkFac") << "RandomSink " << this->id()
-                                   << " is holding " << inventory.quantity()
+                                   << " is holding " << Held()
                                    << " units of material at the close of month "
                                    << context()->time() << ".";
+  if ((buffer_stats > 0) && (context()->time() % buffer_stats == 0)) {
+    buf_stats_.Record(this, "inventory", inventory.count(), Held(),
+		      ApproxBufferBytes<cyclus::Material>(inventory.count()),
+		      max_buffer_growth);
+  }
   LOG(cyclus::LEV_INFO3, "SnkFac") << "}";
 
 }
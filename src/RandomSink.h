@@ -2,12 +2,15 @@
 #define MBMORE_SRC_RANDOMSINK_H_
 
 #include <algorithm>
+#include <map>
 #include <string>
 #include <utility>
 #include <vector>
 
 #include "cyclus.h"
+#include "agent_timings.h"
 #include "behavior_functions.h"
+#include "buffer_stats.h"
 
 namespace mbmore {
 
@@ -52,6 +55,8 @@ class RandomSink : public cyclus::Facility  {
 
   virtual std::string str();
 
+  virtual void EnterNotify();
+
   virtual void Tick();
 
   virtual void Tock();
@@ -81,6 +86,10 @@ class RandomSink : public cyclus::Facility  {
       const std::vector< std::pair<cyclus::Trade<cyclus::Product>,
       cyclus::Product::Ptr> >& responses);
 
+  /// @brief quantity held: the inventory and anything absorbed with
+  /// account_only
+  inline double Held() const { return inventory.quantity() + absorbed_qty; }
+
   // Amount of material to be requested. Re-assessed at each timestep
   // in the Tick
   double amt ;
@@ -90,6 +99,10 @@ class RandomSink : public cyclus::Facility  {
   cyclus::Composition::Ptr curr_recipe;
   
  private:
+  /// @brief adds a received resource to the inventory or, with
+  /// account_only, to the running totals
+  void Store_(cyclus::Resource::Ptr r);
+
   /// all facilities must have at least one input commodity
   #pragma cyclus var {"tooltip": "input commodities", \
                       "doc": "commodities that the sink facility accepts", \
@@ -140,6 +153,16 @@ class RandomSink : public cyclus::Facility  {
                                " otherwise seed on number defined"}
   int rng_seed;
 
+  #pragma cyclus var {"default": 0, "tooltip": "Use named RNG streams", \
+                      "doc": "If 1, the recipe, quantity and trade timing " \
+                             "each draw from their own random number " \
+                             "stream, seeded from rng_seed, the names of " \
+                             "the facility and its institution, and the " \
+                             "purpose, so that paired runs of two " \
+                             "scenarios line up draw for draw. If 0, all " \
+                             "agents share one random sequence."}
+  bool rng_streams;
+
   #pragma cyclus var {"default": 1e299, "tooltip": "sink avg_qty",	\
                           "doc": "mean for the normal distribution that " \
                                  "is sampled to determine the amount of " \
@@ -176,9 +199,61 @@ class RandomSink : public cyclus::Facility  {
                              "accept at each time step"}
   double capacity;
 
+  #pragma cyclus var {"default": 0, "tooltip": "buffer sampling interval", \
+                      "doc": "If positive, the number of resources, total " \
+                             "quantity and approximate heap bytes of the " \
+                             "inventory are written to the " \
+                             "BufferStats table every buffer_stats " \
+                             "timesteps. If 0, they are not sampled."}
+  int buffer_stats;
+
+  #pragma cyclus var {"default": 0, "tooltip": "maximum buffer growth", \
+                      "doc": "If positive (and buffer_stats is set), a " \
+                             "warning is given the first time the number of " \
+                             "resources in a buffer grows by more than this " \
+                             "many per timestep between two samples."}
+  double max_buffer_growth;
+
+  #pragma cyclus var {"default": 0, "tooltip": "keep only totals of receipts",\
+                      "doc": "If 1, each received resource is added to " \
+                             "absorbed_qty (and a material's nuclides to " \
+                             "absorbed_comp) and then released, instead of " \
+                             "being kept in the inventory. max_inv_size " \
+                             "and capacity limit the totals as they would " \
+                             "the inventory."}
+  bool account_only;
+
+  #pragma cyclus var {"default": 0, "internal": true, \
+                      "tooltip": "quantity absorbed", \
+                      "doc": "total quantity of the resources received " \
+                             "with account_only (kept by the facility)"}
+  double absorbed_qty;
+
+  #pragma cyclus var {"default": {}, "internal": true, \
+                      "tooltip": "nuclides absorbed", \
+                      "doc": "total mass of each nuclide of the materials " \
+                             "received with account_only (kept by the " \
+                             "facility)"}
+  std::map<int, double> absorbed_comp;
+
   /// this facility holds material in storage.
   #pragma cyclus var {'capacity': 'max_inv_size'}
   cyclus::toolkit::ResBuf<cyclus::Resource> inventory;
+
+  // random number streams for each purpose, used if rng_streams is set
+  RngStream recipe_rng_;
+  RngStream qty_rng_;
+  RngStream trade_rng_;
+
+  // samples of the inventory, if buffer_stats is set
+  BufferStats buf_stats_;
+
+#ifdef MBMORE_TIMINGS
+  // hot path timings of the current timestep (see agent_timings.h)
+  AgentTimings timings_;
+#endif
+
+  friend class RandomSinkTest;
 };
 
 }  // namespace mbmore
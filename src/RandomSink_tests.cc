@@ -1,6 +1,7 @@
 #include <gtest/gtest.h>
 
 #include "cyclus.h"
+#include "RandomSink.h"
 
 using cyclus::QueryResult;
 using cyclus::Cond;
@@ -31,6 +32,18 @@ Composition::Ptr c_heu() {
   return Composition::CreateFromMass(m);
 };
   
+// Reads the private state of a RandomSink
+class RandomSinkTest {
+ public:
+  static double inventory_qty(RandomSink* sink) {
+    return sink->inventory.quantity();
+  }
+  static double absorbed_qty(RandomSink* sink) { return sink->absorbed_qty; }
+  static std::map<int, double> absorbed_comp(RandomSink* sink) {
+    return sink->absorbed_comp;
+  }
+};
+
 namespace randomsinktests {
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 TEST(RandomSinkTests, TestEvery) {
@@ -141,6 +154,46 @@ TEST(RandomSinkTests, TestTradeTime) {
   EXPECT_EQ(2.0, qr.rows.size());
   
 }
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST(RandomSinkTests, TestAccountOnly) {
+  // Tests that with account_only the sink stops requesting once it has
+  // absorbed max_inv_size, as it would with the materials kept
+
+  std::string config = 
+    "   <in_commods><val>leu</val></in_commods> "
+    "   <recipe_name>leu</recipe_name> "
+    "   <max_inv_size>2</max_inv_size> "
+    "   <account_only>1</account_only>";
+
+  int simdur = 4;
+  cyclus::MockSim sim(cyclus::AgentSpec
+		      (":mbmore:RandomSink"), config, simdur);
+  sim.AddRecipe("leu", c_leu());
+  
+  sim.AddSource("leu")
+    .capacity(1)
+    .recipe("leu")
+    .Finalize();
+  
+  int id = sim.Run();
+
+  std::vector<Cond> conds;
+  conds.push_back(Cond("Commodity", "==", std::string("leu")));
+  QueryResult qr = sim.db().Query("Transactions", &conds);
+  
+  // Should be only two transactions into the sink
+  EXPECT_EQ(2.0, qr.rows.size());
+
+  // and nothing is kept in the inventory, only the totals
+  RandomSink* sink = dynamic_cast<RandomSink*>(sim.agent);
+  ASSERT_TRUE(sink != NULL);
+  EXPECT_EQ(0, RandomSinkTest::inventory_qty(sink));
+  EXPECT_NEAR(2.0, RandomSinkTest::absorbed_qty(sink), 1e-9);
+  EXPECT_NEAR(2.0, sink->Held(), 1e-9);
+  std::map<int, double> comp = RandomSinkTest::absorbed_comp(sink);
+  EXPECT_NEAR(0.08, comp[922350000], 1e-9);
+  EXPECT_NEAR(1.92, comp[922380000], 1e-9);
+}
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
   /*
     rng_seed: cannot be tested
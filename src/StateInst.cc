@@ -8,7 +8,12 @@ namespace mbmore {
 
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 StateInst::StateInst(cyclus::Context* ctx)
-  : cyclus::Institution(ctx){
+  : cyclus::Institution(ctx),
+    state_id(-1),
+    lr_weight(1.0),
+    rng_streams(false),
+    pursuit_tilt(1.0),
+    acquire_tilt(1.0) {
     //    kind("State"){
   cyclus::Warn<cyclus::EXPERIMENTAL_WARNING>("the StateInst agent is experimental.");
 }
@@ -29,6 +34,20 @@ void StateInst::DecomNotify(Agent* a) {
 void StateInst::EnterNotify() {
   cyclus::Institution::EnterNotify();
 
+  // Get an index from the region so that all per-state lookups are integers
+  InteractRegion* pseudo_region =
+    dynamic_cast<InteractRegion*>(this->parent());
+  state_id = pseudo_region->RegisterState(prototype());
+
+  // Streams are keyed by the region and state names so that they are the
+  // same in two scenarios that differ elsewhere
+  if (rng_streams) {
+    uint64_t seed = RngStream::BaseSeed(rng_seed);
+    std::string owner = RngStream::AgentOwner(this);
+    factor_rng_.Seed(seed, owner, "factor_timing");
+    pursuit_rng_.Seed(seed, owner, "pursuit");
+    acquire_rng_.Seed(seed, owner, "acquire");
+  }
 
   //TODO: IS THIS NECESSARY?
   using cyclus::toolkit::CommodityProducer;
@@ -47,6 +66,14 @@ void StateInst::EnterNotify() {
   }
 }
 
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void StateInst::Decommission() {
+  InteractRegion* pseudo_region =
+    dynamic_cast<InteractRegion*>(this->parent());
+  pseudo_region->UnregisterState(state_id);
+  cyclus::Institution::Decommission();
+}
+
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 void StateInst::Register_(Agent* a) {
   using cyclus::toolkit::CommodityProducer;
@@ -72,6 +99,7 @@ void StateInst::Unregister_(Agent* a) {
 }
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 void StateInst::Tick() {
+  MBMORE_TIME(kTick);
 
   // Things to do only at beginning of Simulation
   if (context()->time() == 0){
@@ -81,14 +109,15 @@ void StateInst::Tick() {
       throw cyclus::ValueError(
 			       "ERROR: Only 0, 2, 3 allowed for Weapon Status");
     }
+    if ((pursuit_tilt <= 0) || (acquire_tilt <= 0)) {
+      throw cyclus::ValueError("pursuit_tilt and acquire_tilt must be "
+			       "positive");
+    }
     
     //Record initial weapon status
-    Agent* me = this;
-    std::string proto = me->prototype();
-
     InteractRegion* pseudo_region =
       dynamic_cast<InteractRegion*>(this->parent());
-    pseudo_region->UpdateWeaponStatus(proto, weapon_status);
+    pseudo_region->UpdateWeaponStatus(state_id, weapon_status);
 
     // If starting status is 'pursuing' or 'acquired', create the secret sink
     // at simulation start
@@ -110,7 +139,8 @@ void StateInst::Tick() {
 	  && (constants.size() == 2)){
 	double y0 = constants[0];
 	double yf = constants[1];
-	int t_change = RNG_Integer(0, simdur, rng_seed);
+	int t_change = rng_streams ? RNG_Integer(0, simdur, factor_rng_) :
+	  RNG_Integer(0, simdur, rng_seed);
 	// add the t_change to the P_f record
 	eqn_it->second.second.push_back(t_change);
       }
@@ -121,7 +151,9 @@ void StateInst::Tick() {
 	  && (constants.size() == 1)){
 	double yf = constants[0];
 	if (std::abs(yf) <= 1){
-	  int t_change = RNG_Integer(0, simdur, rng_seed);
+	  int t_change = rng_streams ?
+	    RNG_Integer(0, simdur, factor_rng_) :
+	    RNG_Integer(0, simdur, rng_seed);
 	  eqn_it->second.second.push_back(t_change);
 	}
       }
@@ -131,12 +163,11 @@ void StateInst::Tick() {
   
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 void StateInst::Tock() {
+  MBMORE_TIME_TOCK();
   // TODO:: How to force SecretEnrich to trade Only with SecretSink??
 
   InteractRegion* pseudo_region =
     dynamic_cast<InteractRegion*>(this->parent());
-  Agent* me = this;
-  std::string proto = me->prototype();
   // Pursuit (if detected) and acquire each change the conflict map
   if (weapon_status == 0) {
     std::string eqn_type = "Pursuit";
@@ -147,7 +178,7 @@ void StateInst::Tock() {
 					  << context()->time() << ".";
       DeploySecret();
       weapon_status = 2;
-      pseudo_region->UpdateWeaponStatus(proto, weapon_status);
+      pseudo_region->UpdateWeaponStatus(state_id, weapon_status);
     }
   }
   // If state is pursuing but hasn't yet acquired
@@ -158,18 +189,20 @@ void StateInst::Tock() {
     // State now successfully acquires
     if (acquire_decision == 1) {
       weapon_status = 3;
-      pseudo_region->UpdateWeaponStatus(proto, weapon_status);
+      pseudo_region->UpdateWeaponStatus(state_id, weapon_status);
       LOG(cyclus::LEV_INFO2, "StateInst") << "StateInst " << this->id()
 					  << " is producing weapons at: " 
 					  << context()->time() << ".";
     }
   }
+  pseudo_region->StateTocked();
 }
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 // State inst disallows any trading from SecretSink or SecretEnrich when
 // until acquired = 1.
 void StateInst::AdjustMatlPrefs(
   cyclus::PrefMap<cyclus::Material>::type& prefs) {
+  MBMORE_TIME(kAdjustMatlPrefs);
 
   using cyclus::Bid;
   using cyclus::Material;
@@ -215,16 +248,10 @@ void StateInst::DeploySecret() {
 // At each timestep where pursuit has not yet occurred, calculate whether to
 // pursue at this time step.
   bool StateInst::WeaponDecision(std::string eqn_type) {
+  MBMORE_TRACE("WeaponDecision");
   using cyclus::Context;
   using cyclus::Agent;
   using cyclus::Recorder;
-  cyclus::Datum *d = context()->NewDatum("WeaponProgress");
-  d->AddVal("Time", context()->time());
-  d->AddVal("AgentId", cyclus::Agent::id());
-  d->AddVal("EqnType", eqn_type);
-
-  std::map <std::string, double> P_wt;
-  std::map <std::string, double> P_factors;
 
   // Make a pointer to my parent region so I can access the RegionLevel
   // variables (in a similar way to how the Context provides simulation
@@ -233,80 +260,143 @@ void StateInst::DeploySecret() {
     dynamic_cast<InteractRegion*>(this->parent());
   
   // All defined factors should be recorded with their actual value
-  P_wt = pseudo_region->GetWeights("Pursuit");
+  const std::vector<double>& P_wt = pseudo_region->GetFactorWeights();
   // Even if state is already pursuing and working toward acquire, the success
   // rate is determined by the value of the pursuit factors, so score must be
   // calculated
   
   // Any factors not defined for sim should have a value of zero in the table
   std::vector<std::string>& master_factors = pseudo_region->GetMasterFactors();
-  std::map<std::string, bool> present = pseudo_region->DefinedFactors("Pursuit");
+  const std::vector<bool>& present =
+    pseudo_region->GetDefinedFactors();
+  int n_states = pseudo_region->GetNStates();
+
+  // Look up this state's factor equations once, by master factor index
+  if (factor_eqns.empty()) {
+    factor_eqns.assign(master_factors.size(), NULL);
+    for(int f = 0; f < master_factors.size(); f++){
+      std::map<std::string,
+	       std::pair<std::string, std::vector<double> > >::iterator eqn_it;
+      eqn_it = P_f.find(master_factors[f]);
+      if (eqn_it != P_f.end()) {
+	factor_eqns[f] = &(eqn_it->second);
+      }
+    }
+  }
 
   double pursuit_eqn = 0;
+  int n_factors = master_factors.size();
+  progress_row_.resize(n_factors + kNProgressValues_);
 
   // Iterate through master list of factors. If not present then record 0
   // in database. If present then calculate current value based on time
   // dynamics
   for(int f = 0; f < master_factors.size(); f++){
     const std::string& factor = master_factors[f];
-    bool f_defined  = present[std::string(factor)];
-    // for most factors 'relation' defines the function for time dynamics of
-    // the factor. But for Conflict, 'relation' is the pair state in the
-    // relationship
-    std::string relation = P_f[factor].first;
-    std::vector<double> constants =  P_f[factor].second;
+    bool f_defined  = present[f];
 
     // Record zeroes for any columns not defined in input file
     if (!f_defined) {
-      d->AddVal(factor.c_str(), 0.0);
+      progress_row_[f] = 0.0;
     }
     else {
       double factor_curr_y;
       // Determine the State's conflict score for this timestep
-      int n_states = pseudo_region->GetNStates();
       if (factor == "Conflict"){
 	if (n_states <= 1){
 	  factor_curr_y = 0;
 	}
 	else{
-	  Agent* me = this;
-	  std::string proto = me->prototype();
 	  factor_curr_y =
-	    pseudo_region->GetConflictScore("Pursuit", proto);
+	    pseudo_region->GetConflictScore(state_id);
 	  // Then check conflict value to see if it needs to change. If
 	  //constants is a single element then it doesn't have a time-based
 	  // change. This change is not propogated until the NEXT timestep
 	  // This is done last because changing conflict for one state will
 	  // also affect another state whose score for this timestep may have
 	  // already been calculated.
-	  if ((constants.size() > 1) && (constants[1] == context()->time())){
-	    int new_val = std::round(constants[0]);
-	    // TODO: THIS SHOULD BE eqn_Type not PURSUIT (but doesn't really matteR)
-	    pseudo_region->ChangeConflictReln("Pursuit", proto,
-				      relation, new_val); 
+	  if (factor_eqns[f] != NULL) {
+	    // for Conflict, 'relation' is the pair state in the relationship
+	    const std::string& relation = factor_eqns[f]->first;
+	    const std::vector<double>& constants = factor_eqns[f]->second;
+	    if ((constants.size() > 1) && (constants[1] == context()->time())){
+	      int new_val = std::round(constants[0]);
+	      // TODO: THIS SHOULD BE eqn_Type not PURSUIT (but doesn't really matteR)
+	      pseudo_region->ChangeConflictReln("Pursuit", state_id,
+				pseudo_region->StateIndex(relation), new_val);
+	    }
 	  }
 	}
       }
       else {
-	factor_curr_y = CalcYVal(relation, constants,context()->time());
+	if (factor_eqns[f] == NULL) {
+	  throw cyclus::ValueError("Pursuit factor " + factor + " has a weight"
+				   " but is not defined in pursuit_factors");
+	}
+	// for most factors 'relation' defines the function for time dynamics
+	factor_curr_y = CalcYVal(factor_eqns[f]->first, factor_eqns[f]->second,
+				 context()->time());
       }
-      pursuit_eqn += (factor_curr_y * P_wt[factor]);
-      P_factors[factor] = factor_curr_y;
-      d->AddVal(factor.c_str(), factor_curr_y);
+      pursuit_eqn += (factor_curr_y * P_wt[f]);
+      pseudo_region->SetFactorValue(state_id, f, factor_curr_y);
+      progress_row_[f] = factor_curr_y;
     }
   }
   // Convert pursuit eqn result to a Y/N decision
   // GetLikely requires an input value between 0-10, and the function type
   // should be normalized to convert that value to have a max of y=1.0 for x=10
   double likely = pseudo_region->GetLikely(eqn_type, pursuit_eqn);
-  bool decision = XLikely(likely, rng_seed);
+  // With importance sampling, draw from the tilted likelihood and weight
+  // the run by the ratio of the true and tilted likelihoods of the outcome
+  double tilt = (eqn_type == "Pursuit") ? pursuit_tilt : acquire_tilt;
+  double sample_likely = (tilt == 1) ? likely : TiltProb(likely, tilt);
+  bool decision;
+  if (rng_streams) {
+    decision = XLikely(sample_likely, (eqn_type == "Pursuit") ? pursuit_rng_ :
+		       acquire_rng_);
+  }
+  else {
+    decision = XLikely(sample_likely, rng_seed);
+  }
+  if (tilt != 1) {
+    lr_weight *= TiltWeight(likely, tilt, decision);
+  }
 
-  d->AddVal("EqnVal", pursuit_eqn);
-  d->AddVal("Likelihood", likely);
-  d->AddVal("Decision", decision);
-  d->Record();
+  progress_row_[n_factors] = pursuit_eqn;
+  progress_row_[n_factors + 1] = likely;
+  progress_row_[n_factors + 2] = lr_weight;
+  progress_row_[n_factors + 3] = decision;
+
+  // In Delta mode, unchanged rows are only written at keyframes
+  bool changed = (eqn_type != last_eqn_type_) ||
+    (progress_row_ != last_progress_row_);
+  if (pseudo_region->RecordProgress(context()->time(), changed)) {
+    RecordProgress_(eqn_type, master_factors);
+  }
+  if (changed) {
+    last_eqn_type_ = eqn_type;
+    last_progress_row_ = progress_row_;
+  }
   return decision;  
 }
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void StateInst::RecordProgress_(const std::string& eqn_type,
+				const std::vector<std::string>& master_factors) {
+  int n_factors = master_factors.size();
+  cyclus::Datum *d = context()->NewDatum("WeaponProgress");
+  d->AddVal("Time", context()->time());
+  d->AddVal("AgentId", cyclus::Agent::id());
+  d->AddVal("EqnType", eqn_type);
+  for (int f = 0; f < n_factors; f++) {
+    d->AddVal(master_factors[f].c_str(), progress_row_[f]);
+  }
+  d->AddVal("EqnVal", progress_row_[n_factors]);
+  d->AddVal("Likelihood", progress_row_[n_factors + 1]);
+  d->AddVal("LRWeight", progress_row_[n_factors + 2]);
+  d->AddVal("Decision", progress_row_[n_factors + 3] != 0);
+  d->Record();
+}
   
 
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
@@ -2,6 +2,8 @@
 #define MBMORE_SRC_STATE_INST_H_
 
 #include "cyclus.h"
+#include "agent_timings.h"
+#include "rng_stream.h"
 
 namespace mbmore {
 
@@ -42,6 +44,9 @@ class StateInst
   /// unregister a child
   virtual void DecomNotify(Agent* m);
 
+  /// leave the simulation, removing this state from its InteractRegion
+  virtual void Decommission();
+
   /// deploy secret child facilities
   //  virtual void DeploySecret(cyclus::Agent* parent);
   virtual void DeploySecret();
@@ -75,9 +80,40 @@ class StateInst
   /// unregister a child
   void Unregister_(cyclus::Agent* agent);
 
+  /// writes the values of progress_row_ to the WeaponProgress table
+  void RecordProgress_(const std::string& eqn_type,
+		       const std::vector<std::string>& master_factors);
+
   // Find the simulation duration
   //  cyclus::SimInfo si_;
   int simdur = context()->sim_info().duration;
+
+  // Index of this state in the InteractRegion registry
+  int state_id;
+
+  // Pursuit factor equations (P_f entries) indexed by the region's master
+  // factor list, NULL for factors this state does not define
+  std::vector<std::pair<std::string, std::vector<double> >*> factor_eqns;
+
+  // Values of the latest WeaponProgress row (master factors, then EqnVal,
+  // Likelihood, LRWeight and Decision) and of the previous one that
+  // differed, used by the region's Delta progress_record mode. The previous
+  // row is not a state variable, so the first decision after a restart
+  // always writes its row.
+  static const int kNProgressValues_ = 4;
+  std::vector<double> progress_row_;
+  std::vector<double> last_progress_row_;
+  std::string last_eqn_type_;
+
+  // random number streams for each purpose, used if rng_streams is set
+  RngStream factor_rng_;
+  RngStream pursuit_rng_;
+  RngStream acquire_rng_;
+
+#ifdef MBMORE_TIMINGS
+  // hot path timings of the current timestep (see agent_timings.h)
+  AgentTimings timings_;
+#endif
   
   #pragma cyclus var { \
     "tooltip": "Declared facility prototypes (at start of sim)",         \
@@ -112,6 +148,42 @@ class StateInst
            " otherwise seed on number defined"}
   int rng_seed;
 
+#pragma cyclus var {				\
+    "default": 0,\
+    "tooltip": "Use named RNG streams" ,			    \
+    "doc": "If 1, the random factor change times and the pursuit and " \
+           "acquire decisions each draw from their own random number " \
+           "stream, seeded from rng_seed, the names of the state and its " \
+           "region, and the purpose, so that paired runs of two scenarios " \
+           "line up draw for draw. If 0, all agents share one random " \
+           "sequence."}
+  bool rng_streams;
+
+#pragma cyclus var {				\
+    "default": 1,\
+    "tooltip": "Importance sampling tilt of pursuit" ,		    \
+    "doc": "Importance sampling of rare decisions. The odds of pursuing " \
+           "at each timestep are multiplied by this factor, and the " \
+           "likelihood ratio of the run (LRWeight in the WeaponProgress " \
+           "table) is updated so that weighted averages over runs are " \
+           "unbiased. 1 (default) samples the true likelihood."}
+  double pursuit_tilt;
+
+#pragma cyclus var {				\
+    "default": 1,\
+    "tooltip": "Importance sampling tilt of acquire" ,		    \
+    "doc": "Same as pursuit_tilt, for the decision to acquire a weapon."}
+  double acquire_tilt;
+
+#pragma cyclus var {				\
+    "default": 1,\
+    "internal": true,\
+    "tooltip": "Likelihood ratio so far" ,		    \
+    "doc": "Likelihood ratio of all the pursuit and acquire decisions " \
+           "made so far (kept by the state), 1 unless pursuit_tilt or " \
+           "acquire_tilt is set."}
+  double lr_weight;
+
 
   #pragma cyclus var { \
     "alias": ["pursuit_factors", "factor", ["function","name", ["params","val"]]], \
@@ -0,0 +1,54 @@
+#include "agent_timings.h"
+
+namespace mbmore {
+
+namespace {
+
+const char* kPhaseNames[AgentTimings::kNPhases] = {
+  "Tick",
+  "Tock",
+  "GetMatlRequests",
+  "GetMatlBids",
+  "AdjustMatlPrefs",
+  "GetMatlTrades",
+  "AcceptMatlTrades",
+};
+
+} // namespace
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+AgentTimings::AgentTimings() {
+  Reset();
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+const char* AgentTimings::PhaseName(Phase phase) {
+  return kPhaseNames[phase];
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void AgentTimings::Record(cyclus::Agent* agent) {
+  for (int p = 0; p < kNPhases; p++) {
+    if (calls_[p] == 0) {
+      continue;
+    }
+    agent->context()->NewDatum("AgentTimings")
+      ->AddVal("AgentId", agent->id())
+      ->AddVal("Time", agent->context()->time())
+      ->AddVal("Phase", std::string(kPhaseNames[p]))
+      ->AddVal("Calls", calls_[p])
+      ->AddVal("Seconds", nanoseconds_[p] * 1e-9)
+      ->Record();
+  }
+  Reset();
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void AgentTimings::Reset() {
+  for (int p = 0; p < kNPhases; p++) {
+    calls_[p] = 0;
+    nanoseconds_[p] = 0;
+  }
+}
+
+} // namespace mbmore
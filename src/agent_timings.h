@@ -0,0 +1,107 @@
+#ifndef MBMORE_SRC_AGENT_TIMINGS_H_
+#define MBMORE_SRC_AGENT_TIMINGS_H_
+
+#include <chrono>
+#include <cstdint>
+
+#include "cyclus.h"
+#include "trace.h"
+
+namespace mbmore {
+
+// Wall time spent by one agent in each of its hot paths (Tick, Tock and the
+// material exchange calls), accumulated over a timestep and written to the
+// AgentTimings table: one row per phase that was called, with columns
+// AgentId, Time, Phase, Calls and Seconds.
+//
+// The archetypes only hold and fill an AgentTimings when the module is built
+// with MBMORE_TIMINGS defined (cmake -DMBMORE_TIMINGS=ON). Otherwise the
+// MBMORE_TIME macros below compile to nothing (unless MBMORE_TRACING is
+// defined, in which case they still record trace spans).
+class AgentTimings {
+ public:
+  enum Phase {
+    kTick,
+    kTock,
+    kGetMatlRequests,
+    kGetMatlBids,
+    kAdjustMatlPrefs,
+    kGetMatlTrades,
+    kAcceptMatlTrades,
+    kNPhases
+  };
+
+  AgentTimings();
+
+  inline void Add(Phase phase, int64_t nanoseconds) {
+    calls_[phase]++;
+    nanoseconds_[phase] += nanoseconds;
+  }
+
+  int calls(Phase phase) const { return calls_[phase]; }
+  int64_t nanoseconds(Phase phase) const { return nanoseconds_[phase]; }
+
+  static const char* PhaseName(Phase phase);
+
+  // Writes a row for each phase called since the last Record (or Reset) at
+  // the current time of the agent, then resets the counters.
+  void Record(cyclus::Agent* agent);
+
+  void Reset();
+
+ private:
+  int calls_[kNPhases];
+  int64_t nanoseconds_[kNPhases];
+};
+
+// Adds the time from its construction to its destruction to one phase. If
+// record_agent is given, the timings are then recorded for that agent (used
+// at the end of Tock, so that each row covers a whole timestep).
+class ScopedTimer {
+ public:
+  ScopedTimer(AgentTimings* timings, AgentTimings::Phase phase,
+	      cyclus::Agent* record_agent = NULL)
+    : timings_(timings),
+      phase_(phase),
+      record_agent_(record_agent),
+      start_(std::chrono::steady_clock::now()) {}
+
+  ~ScopedTimer() {
+    std::chrono::steady_clock::duration elapsed =
+      std::chrono::steady_clock::now() - start_;
+    timings_->Add(phase_, std::chrono::duration_cast<
+		  std::chrono::nanoseconds>(elapsed).count());
+    if (record_agent_ != NULL) {
+      timings_->Record(record_agent_);
+    }
+  }
+
+ private:
+  AgentTimings* timings_;
+  AgentTimings::Phase phase_;
+  cyclus::Agent* record_agent_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+} // namespace mbmore
+
+#ifdef MBMORE_TIMINGS
+#define MBMORE_TIMER_(phase, record_agent)				\
+  mbmore::ScopedTimer mbmore_scoped_timer_(				\
+    &timings_, mbmore::AgentTimings::phase, record_agent)
+#else
+#define MBMORE_TIMER_(phase, record_agent)
+#endif
+
+// Times the rest of the enclosing function as one phase (ie. kTick) in the
+// agent's timings_ member, and traces it as a span (see trace.h)
+#define MBMORE_TIME(phase)						\
+  MBMORE_TRACE(								\
+    mbmore::AgentTimings::PhaseName(mbmore::AgentTimings::phase));	\
+  MBMORE_TIMER_(phase, NULL)
+// Same for Tock, and records the timings of the timestep when it returns
+#define MBMORE_TIME_TOCK()						\
+  MBMORE_TRACE("Tock");							\
+  MBMORE_TIMER_(kTock, this)
+
+#endif  //  MBMORE_SRC_AGENT_TIMINGS_H_
@@ -0,0 +1,68 @@
+#include <gtest/gtest.h>
+
+#include "agent_timings.h"
+
+namespace mbmore {
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Calls and time accumulate per phase until Reset
+TEST(Agent_Timings_Test, Accumulate) {
+  AgentTimings timings;
+  timings.Add(AgentTimings::kTick, 100);
+  timings.Add(AgentTimings::kTick, 50);
+  timings.Add(AgentTimings::kGetMatlBids, 7);
+
+  EXPECT_EQ(2, timings.calls(AgentTimings::kTick));
+  EXPECT_EQ(150, timings.nanoseconds(AgentTimings::kTick));
+  EXPECT_EQ(1, timings.calls(AgentTimings::kGetMatlBids));
+  EXPECT_EQ(0, timings.calls(AgentTimings::kTock));
+  EXPECT_STREQ("GetMatlBids", AgentTimings::PhaseName(
+		 AgentTimings::kGetMatlBids));
+
+  timings.Reset();
+  EXPECT_EQ(0, timings.calls(AgentTimings::kTick));
+  EXPECT_EQ(0, timings.nanoseconds(AgentTimings::kTick));
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// A scoped timer adds one call covering its lifetime
+TEST(Agent_Timings_Test, ScopedTimer) {
+  AgentTimings timings;
+  {
+    ScopedTimer timer(&timings, AgentTimings::kAdjustMatlPrefs);
+    volatile double x = 0;
+    for (int i = 0; i < 100000; i++) {
+      x += i;
+    }
+  }
+  EXPECT_EQ(1, timings.calls(AgentTimings::kAdjustMatlPrefs));
+  EXPECT_GT(timings.nanoseconds(AgentTimings::kAdjustMatlPrefs), 0);
+}
+
+#ifdef MBMORE_TIMINGS
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// A timed build writes a Tick and a Tock row for every timestep
+TEST(Agent_Timings_Test, RecordTable) {
+  std::string config =
+    "   <in_commods><val>leu</val></in_commods> "
+    "   <recipe_name>leu</recipe_name> ";
+  int simdur = 3;
+  cyclus::MockSim sim(cyclus::AgentSpec(":mbmore:RandomSink"), config,
+		      simdur);
+  cyclus::CompMap m;
+  m[922350000] = 0.04;
+  m[922380000] = 0.96;
+  sim.AddRecipe("leu", cyclus::Composition::CreateFromMass(m));
+  sim.AddSource("leu").capacity(1).recipe("leu").Finalize();
+  int id = sim.Run();
+
+  std::vector<cyclus::Cond> conds;
+  conds.push_back(cyclus::Cond("AgentId", "==", id));
+  conds.push_back(cyclus::Cond("Phase", "==", std::string("Tock")));
+  cyclus::QueryResult qr = sim.db().Query("AgentTimings", &conds);
+  EXPECT_EQ(simdur, qr.rows.size());
+  EXPECT_EQ(1, qr.GetVal<int>("Calls", 0));
+}
+#endif
+
+} // namespace mbmore
@@ -3,9 +3,48 @@
 #include <cstdlib>
 #include <iostream>
 #include <cmath>
+#include <random>
 
-bool seeded;
 namespace mbmore {
+
+namespace {
+
+// Each thread has its own RNG so that replicas run on different threads do
+// not share (or race on) a random sequence.
+thread_local std::mt19937 rng;
+// The rng_seed overloads draw from one sequence shared by all agents (see
+// README), so only the first of them to be called seeds it; seeding on every
+// call would restart the sequence at each draw. Callers that need their own
+// seed use SeedRNG (as DecisionEnsemble does per replica) or an RngStream.
+thread_local bool seeded = false;
+
+// Seeds this thread's RNG on the first call only
+void SeedOnce(int rng_seed) {
+  if (!seeded) {
+    SeedRNG(rng_seed);
+  }
+}
+
+// Random integer between 0 and RAND_MAX (replaces rand()), from either the
+// thread's RNG or an RngStream
+template <class URNG>
+int Rand(URNG& gen) {
+  std::uniform_int_distribution<int> dist(0, RAND_MAX);
+  return dist(gen);
+}
+
+} // namespace
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void SeedRNG(int rng_seed) {
+  if (rng_seed == -1) {
+    rng.seed(time(0));    // seed random
+  }
+  else {
+    rng.seed(rng_seed);   // user-defined fixed seed
+  }
+  seeded = true;
+}
   
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 bool EveryXTimestep(int curr_time, int interval) {
@@ -14,22 +53,13 @@ bool EveryXTimestep(int curr_time, int interval) {
 }
 
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-bool EveryRandomXTimestep(int frequency, int rng_seed) {
+template <class URNG>
+bool EveryRandomXTimestep_(int frequency, URNG& gen) {
   //TODO: Doesn't work for a frequency of 1
   if (frequency == 0) {
     return false;
   }
 
-  if (!seeded) {
-    if (rng_seed == -1) {
-      srand(time(0));    // seed random
-    }
-    else {
-      srand(rng_seed);   // user-defined fixed seed
-    }
-    seeded = true;
-  }
-
   // Because this relies on integer rounding, it fails for a frequency of
   // 1 because the midpoint rounds to zero.
   double midpoint;
@@ -37,7 +67,7 @@ bool EveryRandomXTimestep(int frequency, int rng_seed) {
     
   // The interwebs say that rand is not truly random.
   //  tRan = rand() % frequency;
-  double cur_rand = rand();
+  double cur_rand = Rand(gen);
   int tRan = 1 + (cur_rand*(1.0/(RAND_MAX+1.0))) * frequency;
   //  int tRan = 1 + uniform_deviate_(rand()) * frequency;
   //  std::cout << "tRan: " << tRan << " midpoint " << midpoint << std::endl;
@@ -49,11 +79,24 @@ bool EveryRandomXTimestep(int frequency, int rng_seed) {
   }
 }
 
+bool EveryRandomXTimestep(int frequency, int rng_seed) {
+  if (frequency == 0) {
+    return false;
+  }
+  SeedOnce(rng_seed);
+  return EveryRandomXTimestep_(frequency, rng);
+}
+
+bool EveryRandomXTimestep(int frequency, RngStream& stream) {
+  return EveryRandomXTimestep_(frequency, stream);
+}
+
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 // Returns true for this instance with a particular likelihood of getting a
 // True over all instances.
 
-  bool XLikely(double prob, int rng_seed) {
+template <class URNG>
+bool XLikely_(double prob, URNG& gen) {
 
     /*
   if (prob == 0) {
@@ -61,17 +104,7 @@ bool EveryRandomXTimestep(int frequency, int rng_seed) {
   }
     */
     
-  if (!seeded) {
-    if (rng_seed == -1) {
-      srand(time(0));    // seed random
-    }
-    else {
-      srand(rng_seed);   // user-defined fixed seed
-    }
-    seeded = true;
-  }
-
-  double cur_rand = rand();
+  double cur_rand = Rand(gen);
   double tRan = (cur_rand/RAND_MAX);
 
   if (tRan <= prob) {
@@ -81,6 +114,15 @@ bool EveryRandomXTimestep(int frequency, int rng_seed) {
   }
 }
 
+bool XLikely(double prob, int rng_seed) {
+  SeedOnce(rng_seed);
+  return XLikely_(prob, rng);
+}
+
+bool XLikely(double prob, RngStream& stream) {
+  return XLikely_(prob, stream);
+}
+
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 /*
 bool EveryRandomXTimestep(int frequency) {
@@ -93,32 +135,19 @@ bool EveryRandomXTimestep(int frequency) {
 // Use Box-Muller algorithm to make a random number sampled from
 // a normal distribution
 
-double RNG_NormalDist(double mean, double sigma, int rng_seed) {
+template <class URNG>
+double RNG_NormalDist_(double mean, double sigma, URNG& gen) {
 
   if (sigma == 0 ) {
     return mean ;
   }
 
-  static double n2 = 0.0;
-  static int n2_cached = 0;
-
-  double result ;
   double x, y, r;
   double rand1, rand2;
 
-  if (!seeded) {
-    if (rng_seed == -1) {
-      srand(time(0)); // if seeding on time
-    }
-    else {
-      srand(rng_seed);  //use fixed seed for reproducibility
-    }
-    seeded = true;
-  }
-  
   do {
-    rand1 = rand();
-    rand2 = rand();
+    rand1 = Rand(gen);
+    rand2 = Rand(gen);
     x = 2.0*rand1/RAND_MAX - 1;
     y = 2.0*rand2/RAND_MAX - 1;
     r = x*x + y*y;
@@ -127,44 +156,45 @@ double RNG_NormalDist(double mean, double sigma, int rng_seed) {
   
   double d = std::sqrt(-2.0*log(r)/r);
   double n1 = x*d;
-  n2 = y*d;
   
-  /*
-  if (!n2_cached) {
-    n2_cached = 1;
-    return n1*sigma + mean;
-  }
-  else {
-    n2_cached = 0 ;
-    return n2*sigma + mean;
-  }
-  */
   //  std::cout << "NormalDist: " << n1*sigma + mean  << std::endl;
   return n1*sigma + mean;
 
 }
 
+double RNG_NormalDist(double mean, double sigma, int rng_seed) {
+  if (sigma == 0 ) {
+    return mean ;
+  }
+  SeedOnce(rng_seed);
+  return RNG_NormalDist_(mean, sigma, rng);
+}
+
+double RNG_NormalDist(double mean, double sigma, RngStream& stream) {
+  return RNG_NormalDist_(mean, sigma, stream);
+}
+
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 // Randomly choose a discrete number between min and max
 // (ie. integer betweeen 1 and 5)
 
-double RNG_Integer(double min, double max, int rng_seed) {
-
-  if (!seeded) {
-    if (rng_seed == -1) {
-      srand(time(0)); // if seeding on time
-    }
-    else {
-      srand(rng_seed);  //use fixed seed for reproducibility
-    }
-    seeded = true;
-  }
+template <class URNG>
+double RNG_Integer_(double min, double max, URNG& gen) {
 
-  int tRan = min + (rand()*(1.0/(RAND_MAX+1.0))) * max;
+  int tRan = min + (Rand(gen)*(1.0/(RAND_MAX+1.0))) * max;
 
   return tRan;
 }
 
+double RNG_Integer(double min, double max, int rng_seed) {
+  SeedOnce(rng_seed);
+  return RNG_Integer_(min, max, rng);
+}
+
+double RNG_Integer(double min, double max, RngStream& stream) {
+  return RNG_Integer_(min, max, stream);
+}
+
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 // For various types of x_val varying curves, calculate y for some x
 // Constants = [y_int, (slope or y_final), (t_change)]
@@ -245,6 +275,36 @@ double ProbPerTime(double xval, double n_timesteps){
   return 1 - (pow((1.0 - xval), (1.0/n_timesteps)));
 }
 
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+double ProbOverTime(double xval, double n_timesteps){
+  if (xval < 0){
+    throw "Xval must be positive";
+  }
+  if (xval >= 1){
+    return 1.0;
+  }
+  return 1 - (pow((1.0 - xval), n_timesteps));
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+double TiltProb(double prob, double tilt){
+  if (tilt <= 0){
+    throw "Tilt must be positive";
+  }
+  return tilt * prob / (1.0 - prob + tilt * prob);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// With Q = tilt*P/(1 - P + tilt*P), P/Q = (1 - P + tilt*P)/tilt and
+// (1-P)/(1-Q) = 1 - P + tilt*P, which stay finite when P is 0 or 1
+double TiltWeight(double prob, double tilt, bool outcome){
+  if (tilt <= 0){
+    throw "Tilt must be positive";
+  }
+  double norm = 1.0 - prob + tilt * prob;
+  return outcome ? norm / tilt : norm;
+}
+
 /*
 double RNG_NormalDist(double mean, double sigma) {
   bool time_seed = 0;
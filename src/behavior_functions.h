@@ -4,8 +4,21 @@
 #include <string>
 #include <vector>
 
+#include "rng_stream.h"
+
 namespace mbmore {
 
+// Seeds the random number generator used by the behavior functions on the
+// calling thread (seeded on the system time if rng_seed is -1). Each thread
+// has its own generator. If SeedRNG is not called, the generator is seeded
+// by the first random behavior function called on the thread, using its
+// rng_seed.
+//
+// Each random behavior function also has an overload that draws from an
+// RngStream instead, so that every agent and purpose can have its own
+// stream (see rng_stream.h).
+void SeedRNG(int rng_seed);
+
 // returns true every X interval (ie every 5th timestep)
 bool EveryXTimestep(int curr_time, int interval);
 
@@ -15,12 +28,14 @@ bool EveryXTimestep(int curr_time, int interval);
 //bool EveryRandomXTimestep(int frequency);
 
 bool EveryRandomXTimestep(int frequency, int rng_seed);
+bool EveryRandomXTimestep(int frequency, RngStream& stream);
 
 // returns True with a defined probability
 // (ie. if probability is 0.2 then will return True on average
 // 1 in 5 calls).
 // 
 bool XLikely(double prob, int rng_seed);
+bool XLikely(double prob, RngStream& stream);
 
 // returns a randomly generated number from a
 // normal distribution defined by mean and
@@ -29,11 +44,13 @@ bool XLikely(double prob, int rng_seed);
 
  
 double RNG_NormalDist(double mean, double sigma, int rng_seed);
+double RNG_NormalDist(double mean, double sigma, RngStream& stream);
 
 // returns a randomly chosen discrete number between min and max
 // (ie. integer betweeen 1 and 5)
 
 double RNG_Integer(double min, double max, int rng_seed);
+double RNG_Integer(double min, double max, RngStream& stream);
 
 // For various types of time varying curves, calculate y for some x
 double CalcYVal(std::string function, std::vector<double> constants,
@@ -43,6 +60,24 @@ double CalcYVal(std::string function, std::vector<double> constants,
 // at single time, by solving for P:  L = 1 - (1-P)^N 
 double ProbPerTime(double xval, double n_timesteps);
 
+// Inverse of ProbPerTime: convert a probability (P) at a single time to the
+// probability integrated over n_timesteps, L = 1 - (1-P)^N. N does not have
+// to be an integer (ie. a yearly probability over a one-month timestep).
+// A P of 1 or more is certain over any duration.
+double ProbOverTime(double xval, double n_timesteps);
+
+// Importance sampling of rare decisions: the probability (Q) to draw a
+// decision with instead of its true probability (P), found by multiplying
+// the odds of the event by tilt, Q = tilt*P / (1 - P + tilt*P). A tilt above
+// 1 makes the event more likely, and a tilt of 1 leaves P unchanged.
+double TiltProb(double prob, double tilt);
+
+// Likelihood ratio P(outcome)/Q(outcome) of a decision drawn with
+// TiltProb(prob, tilt). The product of the ratios of all the decisions in a
+// run weights that run so that weighted averages over tilted runs are
+// unbiased estimates of averages over untilted runs.
+double TiltWeight(double prob, double tilt, bool outcome);
+
 } // namespace mbmore
 
 #endif  //  MBMORE_SRC_BEHAVIOR_FUNCTIONS_H_
@@ -1,5 +1,8 @@
 #include <gtest/gtest.h>
 
+#include <functional>
+#include <thread>
+
 #include "behavior_functions.h"
 
 #include "agent_tests.h"
@@ -263,4 +266,52 @@ TEST(Behavior_Functions_Test, TestProbPerTime) {
   EXPECT_NEAR(y_val, py_val, tol);
 }
 
-} // namespace mbmore
\ No newline at end of file
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Yearly probability over monthly and 5-year timesteps
+TEST(Behavior_Functions_Test, TestProbOverTime) {
+  double tol = 1e-12;
+  double p_year = 0.1;
+  double p_month = ProbOverTime(p_year, 1.0/12);
+  EXPECT_NEAR(p_year, ProbOverTime(p_month, 12), tol);
+  EXPECT_NEAR(ProbPerTime(p_year, 12), p_month, tol);
+  EXPECT_NEAR(1 - pow(0.9, 5), ProbOverTime(p_year, 5), tol);
+  EXPECT_DOUBLE_EQ(1.0, ProbOverTime(1.5, 1.0/12));
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Tilting multiplies the odds of the event, and the expected likelihood
+// ratio under the tilted probability is 1
+TEST(Behavior_Functions_Test, TiltProb) {
+  double tol = 1e-12;
+  double p = 0.01;
+  double q = TiltProb(p, 10.0);
+  EXPECT_NEAR(10 * p / (1 - p), q / (1 - q), tol);
+  EXPECT_NEAR(p, TiltProb(p, 1.0), tol);
+  EXPECT_NEAR(p / q, TiltWeight(p, 10.0, true), tol);
+  EXPECT_NEAR((1 - p) / (1 - q), TiltWeight(p, 10.0, false), tol);
+  EXPECT_NEAR(1.0, q * TiltWeight(p, 10.0, true) +
+	      (1 - q) * TiltWeight(p, 10.0, false), tol);
+  EXPECT_THROW(TiltProb(p, 0), const char*);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Each thread has its own RNG, so the same seed gives the same sequence on
+// every thread
+TEST(Behavior_Functions_Test, ThreadRNG) {
+  std::vector<bool> first;
+  std::vector<bool> second;
+  std::function<void(std::vector<bool>*)> draw = [](std::vector<bool>* out) {
+    SeedRNG(5);
+    for (int i = 0; i < 100; i++) {
+      out->push_back(XLikely(0.5, 5));
+    }
+  };
+  std::thread t1(draw, &first);
+  std::thread t2(draw, &second);
+  t1.join();
+  t2.join();
+  EXPECT_EQ(100, first.size());
+  EXPECT_EQ(first, second);
+}
+
+} // namespace mbmore
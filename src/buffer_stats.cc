@@ -0,0 +1,56 @@
+#include "buffer_stats.h"
+
+#include <sstream>
+
+namespace mbmore {
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void BufferStats::Record(cyclus::Agent* agent, const std::string& buffer,
+			 int count, double quantity, double bytes,
+			 double max_growth) {
+  int time = agent->context()->time();
+  agent->context()->NewDatum("BufferStats")
+    ->AddVal("AgentId", agent->id())
+    ->AddVal("Time", time)
+    ->AddVal("Buffer", buffer)
+    ->AddVal("Count", count)
+    ->AddVal("Quantity", quantity)
+    ->AddVal("Bytes", bytes)
+    ->Record();
+
+  double growth = Growth(buffer, time, count);
+  if ((max_growth > 0) && (growth > max_growth) && !warned(buffer)) {
+    last_[buffer].warned = true;
+    std::stringstream ss;
+    ss << agent->prototype() << " " << agent->id() << ": " << buffer
+       << " grew by " << growth << " resources per timestep at time "
+       << time << " (" << count << " resources, max_buffer_growth is "
+       << max_growth << ")";
+    cyclus::Warn<cyclus::VALUE_WARNING>(ss.str());
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+double BufferStats::Growth(const std::string& buffer, int time, int count) {
+  std::map<std::string, Sample>::iterator it = last_.find(buffer);
+  if (it == last_.end()) {
+    Sample sample = {time, count, false};
+    last_[buffer] = sample;
+    return 0;
+  }
+  double growth = 0;
+  if (time > it->second.time) {
+    growth = double(count - it->second.count) / (time - it->second.time);
+  }
+  it->second.time = time;
+  it->second.count = count;
+  return growth;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+bool BufferStats::warned(const std::string& buffer) const {
+  std::map<std::string, Sample>::const_iterator it = last_.find(buffer);
+  return (it != last_.end()) && it->second.warned;
+}
+
+} // namespace mbmore
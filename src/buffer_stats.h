@@ -0,0 +1,65 @@
+#ifndef MBMORE_SRC_BUFFER_STATS_H_
+#define MBMORE_SRC_BUFFER_STATS_H_
+
+#include <map>
+#include <string>
+
+#include "cyclus.h"
+
+namespace mbmore {
+
+// Approximate heap bytes held by a ResBuf of n resources of type T: each
+// resource object and its shared_ptr control block, plus the list and set
+// nodes that the buffer keeps per resource. Compositions are shared between
+// materials and are not counted.
+template <class T>
+double ApproxBufferBytes(int n) {
+  const double ptr = sizeof(typename T::Ptr);
+  const double per_resource = sizeof(T) + 3 * sizeof(void*)  // control block
+    + 2 * sizeof(void*) + ptr  // list node
+    + 4 * sizeof(void*) + ptr;  // set node
+  return n * per_resource;
+}
+
+// Samples of the resource buffers of one agent, written to the BufferStats
+// table: one row per buffer and sample with columns AgentId, Time, Buffer,
+// Count, Quantity and Bytes (see ApproxBufferBytes).
+//
+// Each sample is compared with the previous sample of the same buffer, and
+// a warning is given (once per buffer) if the number of resources grew
+// faster than a maximum number per timestep.
+class BufferStats {
+ public:
+  // Writes a row for the buffer at the current time of the agent. If
+  // max_growth is positive, warns if the buffer grew faster than that. The
+  // bytes are estimated for materials, which all mbmore buffers hold.
+  template <class T>
+  void Record(cyclus::Agent* agent, const std::string& buffer,
+	      const cyclus::toolkit::ResBuf<T>& buf, double max_growth) {
+    Record(agent, buffer, buf.count(), buf.quantity(),
+	   ApproxBufferBytes<cyclus::Material>(buf.count()), max_growth);
+  }
+
+  void Record(cyclus::Agent* agent, const std::string& buffer, int count,
+	      double quantity, double bytes, double max_growth);
+
+  // Resources added to the buffer per timestep since its previous sample
+  // (0 for the first sample), and remembers this sample
+  double Growth(const std::string& buffer, int time, int count);
+
+  // True if the growth of the buffer was already warned about
+  bool warned(const std::string& buffer) const;
+
+ private:
+  struct Sample {
+    int time;
+    int count;
+    bool warned;
+  };
+
+  std::map<std::string, Sample> last_;
+};
+
+} // namespace mbmore
+
+#endif  //  MBMORE_SRC_BUFFER_STATS_H_
@@ -0,0 +1,62 @@
+#include <gtest/gtest.h>
+
+#include "buffer_stats.h"
+
+namespace mbmore {
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Growth is the change in count per timestep since the previous sample of
+// the same buffer
+TEST(Buffer_Stats_Test, Growth) {
+  BufferStats stats;
+  EXPECT_DOUBLE_EQ(0, stats.Growth("inventory", 0, 5));
+  EXPECT_DOUBLE_EQ(0, stats.Growth("tails", 0, 100));
+  EXPECT_DOUBLE_EQ(5, stats.Growth("inventory", 2, 15));
+  EXPECT_DOUBLE_EQ(-25, stats.Growth("tails", 4, 0));
+  // a second sample at the same time does not divide by zero
+  EXPECT_DOUBLE_EQ(0, stats.Growth("inventory", 2, 20));
+  EXPECT_FALSE(stats.warned("inventory"));
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// The byte estimate is at least the size of the materials themselves
+TEST(Buffer_Stats_Test, ApproxBytes) {
+  EXPECT_DOUBLE_EQ(0, ApproxBufferBytes<cyclus::Material>(0));
+  EXPECT_GT(ApproxBufferBytes<cyclus::Material>(1),
+	    sizeof(cyclus::Material));
+  EXPECT_DOUBLE_EQ(10 * ApproxBufferBytes<cyclus::Material>(1),
+		   ApproxBufferBytes<cyclus::Material>(10));
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// A sink sampling every timestep writes one inventory row per timestep, and
+// its count grows with each accepted trade
+TEST(Buffer_Stats_Test, RecordTable) {
+  std::string config =
+    "   <in_commods><val>leu</val></in_commods> "
+    "   <recipe_name>leu</recipe_name> "
+    "   <buffer_stats>1</buffer_stats> ";
+  int simdur = 3;
+  cyclus::MockSim sim(cyclus::AgentSpec(":mbmore:RandomSink"), config,
+		      simdur);
+  cyclus::CompMap m;
+  m[922350000] = 0.04;
+  m[922380000] = 0.96;
+  sim.AddRecipe("leu", cyclus::Composition::CreateFromMass(m));
+  sim.AddSource("leu").capacity(1).recipe("leu").Finalize();
+  int id = sim.Run();
+
+  std::vector<cyclus::Cond> conds;
+  conds.push_back(cyclus::Cond("AgentId", "==", id));
+  conds.push_back(cyclus::Cond("Buffer", "==", std::string("inventory")));
+  cyclus::QueryResult qr = sim.db().Query("BufferStats", &conds);
+  ASSERT_EQ(simdur, qr.rows.size());
+  for (int t = 0; t < simdur; t++) {
+    EXPECT_EQ(t, qr.GetVal<int>("Time", t));
+    EXPECT_EQ(t + 1, qr.GetVal<int>("Count", t));
+    EXPECT_DOUBLE_EQ(t + 1, qr.GetVal<double>("Quantity", t));
+    EXPECT_GT(qr.GetVal<double>("Bytes", t), 0);
+  }
+}
+
+} // namespace mbmore
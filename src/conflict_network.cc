@@ -0,0 +1,158 @@
+#include "conflict_network.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace mbmore {
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+SparseMatrix::SparseMatrix() : n_rows_(0) {
+  row_start_.push_back(0);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void SparseMatrix::Clear(int n) {
+  n_rows_ = n;
+  row_start_.clear();
+  row_start_.reserve(n + 1);
+  cols_.clear();
+  vals_.clear();
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void SparseMatrix::StartRow() {
+  row_start_.push_back(cols_.size());
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void SparseMatrix::Add(int col, double val) {
+  cols_.push_back(col);
+  vals_.push_back(val);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void SparseMatrix::Finish() {
+  // any rows that were never started are empty
+  while (row_start_.size() < n_rows_ + 1) {
+    row_start_.push_back(cols_.size());
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void SparseMatrix::Multiply(const std::vector<double>& x,
+			    std::vector<double>& y) const {
+  y.resize(n_rows_);
+  for (int row = 0; row < n_rows_; row++) {
+    double sum = 0;
+    for (int i = row_start_[row]; i < row_start_[row + 1]; i++) {
+      sum += vals_[i] * x[cols_[i]];
+    }
+    y[row] = sum;
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+ConflictNetwork::ConflictNetwork()
+  : mode_("None"),
+    n_hops_(0),
+    damping_(0),
+    relations_stale_(true),
+    scores_stale_(true),
+    n_updates_(0) {}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void ConflictNetwork::Configure(std::string mode, int n_hops, double damping) {
+  mode_ = mode;
+  n_hops_ = n_hops;
+  damping_ = damping;
+  RelationsChanged();
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Row i of the alliance matrix averages over the allies of state i and is
+// scaled by the damping, so each iteration is a single sparse mat-vec.
+void ConflictNetwork::BuildAllianceMatrix_(const RelationLists& relations) {
+  int n = relations.size();
+  bool propagate = (mode_ != "None") && (damping_ > 0);
+
+  alliance_.Clear(n);
+  keep_.assign(n, 1.0);
+  for (int state = 0; state < n; state++) {
+    alliance_.StartRow();
+    if (!propagate) {
+      continue;
+    }
+    int n_allies = 0;
+    for (int r = 0; r < relations[state].size(); r++) {
+      if (relations[state][r].second == 1) {
+	n_allies++;
+      }
+    }
+    if (n_allies == 0) {
+      continue;
+    }
+    for (int r = 0; r < relations[state].size(); r++) {
+      if (relations[state][r].second == 1) {
+	alliance_.Add(relations[state][r].first, damping_ / n_allies);
+      }
+    }
+    keep_[state] = 1.0 - damping_;
+  }
+  alliance_.Finish();
+  relations_stale_ = false;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void ConflictNetwork::Update(const RelationLists& relations,
+			     const std::vector<int>& status,
+			     const ConflictScores& scores) {
+  if (relations.size() != direct_.size()) {
+    RelationsChanged();
+  }
+  if (!scores_stale_) {
+    return;
+  }
+  if (relations_stale_) {
+    BuildAllianceMatrix_(relations);
+  }
+  n_updates_++;
+
+  // Direct score: average of the pairwise scores of each state
+  int n = relations.size();
+  direct_.assign(n, 0.0);
+  for (int state = 0; state < n; state++) {
+    const std::vector<std::pair<int, int> >& pairs = relations[state];
+    if (pairs.size() == 0) {
+      continue;
+    }
+    int gross_score = 0;
+    for (int r = 0; r < pairs.size(); r++) {
+      gross_score += scores.Score(pairs[r].second, status[state],
+				  status[pairs[r].first]);
+    }
+    direct_[state] = static_cast<double>(gross_score) / pairs.size();
+  }
+  conflict_ = direct_;
+
+  if ((alliance_.n_entries() > 0) && (mode_ == "KHop" || mode_ == "Damped")) {
+    // KHop stops after n_hops, Damped iterates to convergence (the iteration
+    // is a contraction for damping < 1)
+    int max_iter = (mode_ == "KHop") ? n_hops_ : 1000;
+    double tol = 1e-10;
+    for (int iter = 0; iter < max_iter; iter++) {
+      alliance_.Multiply(conflict_, work_);
+      double change = 0;
+      for (int state = 0; state < n; state++) {
+	double next = keep_[state] * direct_[state] + work_[state];
+	change = std::max(change, std::fabs(next - conflict_[state]));
+	conflict_[state] = next;
+      }
+      if ((mode_ == "Damped") && (change < tol)) {
+	break;
+      }
+    }
+  }
+  scores_stale_ = false;
+}
+
+} // namespace mbmore
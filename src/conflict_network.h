@@ -0,0 +1,107 @@
+#ifndef MBMORE_SRC_CONFLICT_NETWORK_H_
+#define MBMORE_SRC_CONFLICT_NETWORK_H_
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "conflict_scores.h"
+
+namespace mbmore {
+
+// Conflict relations of each state as (pair state index, relation), indexed
+// by state (see InteractRegion state registry)
+typedef std::vector<std::vector<std::pair<int, int> > > RelationLists;
+
+// Square matrix in compressed sparse row format
+class SparseMatrix {
+ public:
+  SparseMatrix();
+
+  // Builds an n x n matrix with no entries
+  void Clear(int n);
+
+  // Appends an entry to the last row that was started with StartRow.
+  // Rows must be started in order 0..n-1.
+  void StartRow();
+  void Add(int col, double val);
+  void Finish();
+
+  // y = A x
+  void Multiply(const std::vector<double>& x, std::vector<double>& y) const;
+
+  int n_rows() const { return n_rows_; }
+  int n_entries() const { return vals_.size(); }
+
+ private:
+  int n_rows_;
+  std::vector<int> row_start_;
+  std::vector<int> cols_;
+  std::vector<double> vals_;
+};
+
+// Computes the conflict score of every state at once, optionally propagating
+// threat through alliance chains (an ally's enemy raises my conflict).
+//
+// The direct score d of a state is the average of its pairwise conflict
+// scores (as defined by ConflictScores). In the network modes each state
+// with allies mixes in the scores of its allies:
+//     c(k+1) = (1 - damping) d + damping W c(k),    c(0) = d
+// where W averages over a state's allies. "KHop" applies this n_hops times,
+// "Damped" iterates until the scores converge. States without allies keep
+// their direct score. With n_hops = 0 or damping = 0 the result is the
+// direct average.
+//
+// Scores are cached and only recomputed after the relations or the weapon
+// statuses have been marked as changed.
+class ConflictNetwork {
+ public:
+  ConflictNetwork();
+
+  // mode is None (direct average), KHop or Damped
+  void Configure(std::string mode, int n_hops, double damping);
+
+  // Relations between states have changed (rebuilds the alliance matrix)
+  void RelationsChanged() { relations_stale_ = true; scores_stale_ = true; }
+
+  // Weapon status of any state has changed
+  void StatusChanged() { scores_stale_ = true; }
+
+  bool stale() const { return scores_stale_; }
+
+  // Recomputes the scores of all states, if anything has changed since the
+  // last call.
+  void Update(const RelationLists& relations, const std::vector<int>& status,
+	      const ConflictScores& scores);
+
+  // Conflict score of a state as of the last Update. Only valid for states
+  // that have at least one relation.
+  double Score(int state) const { return conflict_[state]; }
+
+  // Number of times the scores were recomputed (for testing)
+  int n_updates() const { return n_updates_; }
+
+ private:
+  void BuildAllianceMatrix_(const RelationLists& relations);
+
+  std::string mode_;
+  int n_hops_;
+  double damping_;
+
+  bool relations_stale_;
+  bool scores_stale_;
+  int n_updates_;
+
+  // damping-scaled row-averaging matrix over allies, and the weight kept by
+  // each state's own direct score
+  SparseMatrix alliance_;
+  std::vector<double> keep_;
+
+  std::vector<double> direct_;
+  std::vector<double> conflict_;
+  std::vector<double> work_;
+};
+
+} // namespace mbmore
+
+#endif  //  MBMORE_SRC_CONFLICT_NETWORK_H_
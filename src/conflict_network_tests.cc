@@ -0,0 +1,136 @@
+#include <gtest/gtest.h>
+
+#include "conflict_network.h"
+
+namespace mbmore {
+
+// Three states: A (0) allied with B (1), B enemy of C (2)
+RelationLists ChainRelations() {
+  RelationLists rel(3);
+  rel[0].push_back(std::make_pair(1, 1));
+  rel[1].push_back(std::make_pair(0, 1));
+  rel[1].push_back(std::make_pair(2, -1));
+  rel[2].push_back(std::make_pair(1, -1));
+  return rel;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST(Conflict_Network_Test, SparseMultiply) {
+  SparseMatrix m;
+  m.Clear(3);
+  m.StartRow();
+  m.Add(1, 2.0);
+  m.StartRow();
+  m.StartRow();
+  m.Add(0, 1.0);
+  m.Add(2, 0.5);
+  m.Finish();
+
+  std::vector<double> x(3);
+  x[0] = 1; x[1] = 2; x[2] = 4;
+  std::vector<double> y;
+  m.Multiply(x, y);
+
+  EXPECT_EQ(3, m.n_rows());
+  EXPECT_EQ(3, m.n_entries());
+  EXPECT_DOUBLE_EQ(4.0, y[0]);
+  EXPECT_DOUBLE_EQ(0.0, y[1]);
+  EXPECT_DOUBLE_EQ(3.0, y[2]);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Without propagation the score is the average of the pairwise scores
+TEST(Conflict_Network_Test, DirectAverage) {
+  ConflictScores scores;
+  RelationLists rel = ChainRelations();
+  std::vector<int> status(3, 0);
+  status[2] = 3;
+
+  ConflictNetwork net;
+  net.Update(rel, status, scores);
+  EXPECT_DOUBLE_EQ(scores.Score(1, 0, 0), net.Score(0));
+  EXPECT_DOUBLE_EQ((scores.Score(1, 0, 0) + scores.Score(-1, 0, 3)) / 2.0,
+		   net.Score(1));
+  EXPECT_DOUBLE_EQ(scores.Score(-1, 3, 0), net.Score(2));
+
+  // zero hops is the same as the direct average
+  ConflictNetwork zero_hop;
+  zero_hop.Configure("KHop", 0, 0.5);
+  zero_hop.Update(rel, status, scores);
+  for (int s = 0; s < 3; s++) {
+    EXPECT_DOUBLE_EQ(net.Score(s), zero_hop.Score(s));
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// An ally's enemy raises my conflict. A state with no allies is unchanged.
+TEST(Conflict_Network_Test, KHop) {
+  ConflictScores scores;
+  RelationLists rel = ChainRelations();
+  std::vector<int> status(3, 0);
+
+  ConflictNetwork direct;
+  direct.Update(rel, status, scores);
+
+  ConflictNetwork net;
+  double damping = 0.5;
+  net.Configure("KHop", 1, damping);
+  net.Update(rel, status, scores);
+
+  EXPECT_GT(net.Score(0), direct.Score(0));
+  EXPECT_DOUBLE_EQ((1 - damping) * direct.Score(0) + damping * direct.Score(1),
+		   net.Score(0));
+  EXPECT_DOUBLE_EQ(direct.Score(2), net.Score(2));
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Damped propagation converges to the fixed point c = (1-a) d + a W c
+TEST(Conflict_Network_Test, Damped) {
+  ConflictScores scores;
+  RelationLists rel = ChainRelations();
+  std::vector<int> status(3, 0);
+
+  ConflictNetwork direct;
+  direct.Update(rel, status, scores);
+  double d0 = direct.Score(0);
+  double d1 = direct.Score(1);
+
+  double a = 0.4;
+  ConflictNetwork net;
+  net.Configure("Damped", 0, a);
+  net.Update(rel, status, scores);
+
+  // A and B are each other's only ally:
+  //   c0 = (1-a) d0 + a c1,  c1 = (1-a) d1 + a c0
+  double c0 = (1 - a) * (d0 + a * d1) / (1 - a * a);
+  double c1 = (1 - a) * (d1 + a * d0) / (1 - a * a);
+  EXPECT_NEAR(c0, net.Score(0), 1e-8);
+  EXPECT_NEAR(c1, net.Score(1), 1e-8);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Scores are only recomputed after a change has been flagged
+TEST(Conflict_Network_Test, Caching) {
+  ConflictScores scores;
+  RelationLists rel = ChainRelations();
+  std::vector<int> status(3, 0);
+
+  ConflictNetwork net;
+  net.Configure("KHop", 2, 0.5);
+  net.Update(rel, status, scores);
+  net.Update(rel, status, scores);
+  EXPECT_EQ(1, net.n_updates());
+  double before = net.Score(0);
+
+  status[2] = 2;
+  net.Update(rel, status, scores);
+  EXPECT_EQ(1, net.n_updates());
+  EXPECT_DOUBLE_EQ(before, net.Score(0));
+
+  net.StatusChanged();
+  net.Update(rel, status, scores);
+  EXPECT_EQ(2, net.n_updates());
+  EXPECT_NE(before, net.Score(0));
+}
+
+} // namespace mbmore
@@ -0,0 +1,68 @@
+#include "conflict_scores.h"
+
+#include <cstdlib>
+
+namespace mbmore {
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+bool ParseScorePair(const std::string& key, int* relation, int* statusA,
+		    int* statusB) {
+  std::string::size_type first = key.find('_');
+  if (first == std::string::npos) {
+    return false;
+  }
+  std::string::size_type second = key.find('_', first + 1);
+  if (second == std::string::npos) {
+    return false;
+  }
+  std::string rel_name = key.substr(0, first);
+  std::string status_a = key.substr(first + 1, second - first - 1);
+  std::string status_b = key.substr(second + 1);
+
+  if (rel_name == "ally") {
+    *relation = 1;
+  }
+  else if (rel_name == "neut") {
+    *relation = 0;
+  }
+  else if (rel_name == "enemy") {
+    *relation = -1;
+  }
+  else {
+    return false;
+  }
+  if (((status_a != "0") && (status_a != "2") && (status_a != "3")) ||
+      ((status_b != "0") && (status_b != "2") && (status_b != "3"))) {
+    return false;
+  }
+  *statusA = std::atoi(status_a.c_str());
+  *statusB = std::atoi(status_b.c_str());
+  return true;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+ConflictScores::ConflictScores() {
+  Reset();
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void ConflictScores::Reset() {
+  for (int r = 0; r < kNRelations; r++) {
+    for (int a = 0; a < kNStatuses; a++) {
+      for (int b = 0; b < kNStatuses; b++) {
+	table_[r][a][b] = kDefaultConflictScores[r][a][b];
+      }
+    }
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void ConflictScores::Set(int relation, int statusA, int statusB, int score) {
+  int r = RelationIndex(relation);
+  int a = StatusIndex(statusA);
+  int b = StatusIndex(statusB);
+  table_[r][a][b] = score;
+  table_[r][b][a] = score;
+}
+
+} // namespace mbmore
@@ -0,0 +1,75 @@
+#ifndef MBMORE_SRC_CONFLICT_SCORES_H_
+#define MBMORE_SRC_CONFLICT_SCORES_H_
+
+#include <string>
+
+namespace mbmore {
+
+// Number of relation types (ally, neutral, enemy) and of weapon statuses
+// (never pursued, pursuing, acquired) that index the conflict score table
+const int kNRelations = 3;
+const int kNStatuses = 3;
+
+// Default conflict scores (0-10) for a pair of states, indexed as
+// [relation][statusA][statusB] (see RelationIndex and StatusIndex). The
+// table is symmetric in the two weapon statuses.
+constexpr int kDefaultConflictScores[kNRelations][kNStatuses][kNStatuses] = {
+  // ally:  0   2   3
+  { {2, 3, 1},     // 0
+    {3, 3, 3},     // 2
+    {1, 3, 1} },   // 3
+  // neut:  0   2   3
+  { {2, 4, 4},     // 0
+    {4, 4, 5},     // 2
+    {4, 5, 3} },   // 3
+  // enemy: 0   2   3
+  { {6, 8, 6},     // 0
+    {8, 9, 10},    // 2
+    {6, 10, 5} },  // 3
+};
+
+// Maps a relationship (+1 ally, 0 neutral, -1 enemy) to a table index.
+// Anything other than +1 or 0 is treated as enemy.
+inline int RelationIndex(int relation) {
+  return (relation == 1) ? 0 : ((relation == 0) ? 1 : 2);
+}
+
+// Maps a weapon status (0 never pursued, 2 pursuing, 3 acquired) to a table
+// index. Any other status is treated as never pursued.
+inline int StatusIndex(int status) {
+  return (status == 2) ? 1 : ((status == 3) ? 2 : 0);
+}
+
+// Parses the name of a conflict score entry, relation_statusA_statusB
+// (ie. enemy_2_3), where relation is ally, neut or enemy and the statuses are
+// 0, 2 or 3. Returns false if the name is not of this form.
+bool ParseScorePair(const std::string& key, int* relation, int* statusA,
+		    int* statusB);
+
+// Lookup table that defines the conflict score between two states given their
+// relationship and their weapon statuses. Starts from kDefaultConflictScores,
+// individual entries can be overridden (e.g. from the input file).
+class ConflictScores {
+ public:
+  ConflictScores();
+
+  // Restores every entry to kDefaultConflictScores
+  void Reset();
+
+  // Conflict score for a pair of states. No allocation or map lookup.
+  inline int Score(int relation, int statusA, int statusB) const {
+    return table_[RelationIndex(relation)][StatusIndex(statusA)]
+      [StatusIndex(statusB)];
+  }
+
+  // Changes the score for a relation and pair of weapon statuses. The change
+  // is applied to both orderings of the statuses.
+  void Set(int relation, int statusA, int statusB, int score);
+
+ private:
+  int table_[kNRelations][kNStatuses][kNStatuses];
+};
+
+} // namespace mbmore
+
+#endif  //  MBMORE_SRC_CONFLICT_SCORES_H_
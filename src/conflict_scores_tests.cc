@@ -0,0 +1,71 @@
+#include <gtest/gtest.h>
+
+#include "conflict_scores.h"
+
+namespace mbmore {
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Default table reproduces the original string-keyed score matrix
+// (ie. "enemy_2_3" = 10), independent of the order of the two states
+TEST(Conflict_Scores_Test, DefaultTable) {
+  ConflictScores scores;
+
+  EXPECT_EQ(2, scores.Score(1, 0, 0));
+  EXPECT_EQ(2, scores.Score(0, 0, 0));
+  EXPECT_EQ(6, scores.Score(-1, 0, 0));
+  EXPECT_EQ(3, scores.Score(1, 0, 2));
+  EXPECT_EQ(4, scores.Score(0, 0, 3));
+  EXPECT_EQ(9, scores.Score(-1, 2, 2));
+  EXPECT_EQ(5, scores.Score(0, 2, 3));
+  EXPECT_EQ(10, scores.Score(-1, 2, 3));
+  EXPECT_EQ(1, scores.Score(1, 3, 3));
+  EXPECT_EQ(5, scores.Score(-1, 3, 3));
+
+  for (int rel = -1; rel <= 1; rel++) {
+    EXPECT_EQ(scores.Score(rel, 0, 3), scores.Score(rel, 3, 0));
+    EXPECT_EQ(scores.Score(rel, 2, 3), scores.Score(rel, 3, 2));
+    EXPECT_EQ(scores.Score(rel, 0, 2), scores.Score(rel, 2, 0));
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Statuses other than 0, 2, 3 are treated as never pursued.
+TEST(Conflict_Scores_Test, UnknownStatus) {
+  ConflictScores scores;
+
+  EXPECT_EQ(scores.Score(-1, 0, 2), scores.Score(-1, 1, 2));
+  EXPECT_EQ(scores.Score(-1, 0, 2), scores.Score(-1, -1, 2));
+  EXPECT_EQ(scores.Score(0, 0, 0), scores.Score(0, 7, 4));
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Overrides change both orderings of a single entry, Reset restores defaults
+TEST(Conflict_Scores_Test, Override) {
+  ConflictScores scores;
+
+  scores.Set(-1, 3, 2, 7);
+  EXPECT_EQ(7, scores.Score(-1, 2, 3));
+  EXPECT_EQ(7, scores.Score(-1, 3, 2));
+  EXPECT_EQ(9, scores.Score(-1, 2, 2));
+  EXPECT_EQ(5, scores.Score(0, 2, 3));
+
+  scores.Reset();
+  EXPECT_EQ(10, scores.Score(-1, 2, 3));
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST(Conflict_Scores_Test, ParsePair) {
+  int rel, a, b;
+  EXPECT_TRUE(ParseScorePair("enemy_2_3", &rel, &a, &b));
+  EXPECT_EQ(-1, rel);
+  EXPECT_EQ(2, a);
+  EXPECT_EQ(3, b);
+  EXPECT_TRUE(ParseScorePair("ally_0_0", &rel, &a, &b));
+  EXPECT_EQ(1, rel);
+
+  EXPECT_FALSE(ParseScorePair("enemy_2", &rel, &a, &b));
+  EXPECT_FALSE(ParseScorePair("foe_2_3", &rel, &a, &b));
+  EXPECT_FALSE(ParseScorePair("neut_1_3", &rel, &a, &b));
+}
+
+} // namespace mbmore
@@ -0,0 +1,116 @@
+#include "cyclus_run.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <spawn.h>
+#include <sys/wait.h>
+
+#include "sqlite_back.h"
+
+extern char** environ;
+
+namespace mbmore {
+
+namespace {
+
+bool HasTable(cyclus::SqliteDb& db, const std::string& table) {
+  cyclus::SqlStatement::Ptr stmt = db.Prepare(
+      "SELECT COUNT(*) FROM sqlite_master"
+      " WHERE type = 'table' AND name = '" + table + "';");
+  return stmt->Step() && (stmt->GetInt(0) > 0);
+}
+
+std::string GetText(cyclus::SqlStatement::Ptr stmt, int col) {
+  int n = 0;
+  const char* text = stmt->GetText(col, &n);
+  return std::string(text, n);
+}
+
+} // namespace
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+int RunCyclus(const std::string& command, const std::string& input_file,
+	      const std::string& db_file) {
+  std::string run = command + " -o " + db_file + " " + input_file;
+  std::remove(db_file.c_str());
+
+  // std::system is not thread safe, so the shell is spawned directly
+  const char* argv[] = {"sh", "-c", run.c_str(), NULL};
+  pid_t pid;
+  if (posix_spawn(&pid, "/bin/sh", NULL, NULL, const_cast<char**>(argv),
+		  environ) != 0) {
+    return -1;
+  }
+  int status;
+  while (waitpid(pid, &status, 0) == -1) {
+    if (errno != EINTR) {
+      return -1;
+    }
+  }
+  return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+RunTotals ReadRunTotals(const std::string& db_file) {
+  RunTotals totals = {0, 0, std::map<std::string, double>()};
+  cyclus::SqliteBack back(db_file);
+  cyclus::SqliteDb& db = back.db();
+
+  // the RandomEnrichs table is only made if a RandomEnrich enriched
+  cyclus::SqlStatement::Ptr stmt;
+  if (HasTable(db, "RandomEnrichs")) {
+    stmt = db.Prepare(
+	"SELECT SUM(SWU), SUM(Natural_Uranium) FROM RandomEnrichs;");
+    if (stmt->Step()) {
+      totals.swu = stmt->GetDouble(0);
+      totals.natural_u = stmt->GetDouble(1);
+    }
+  }
+
+  stmt = db.Prepare(
+      "SELECT t.Commodity, SUM(r.Quantity) FROM Transactions AS t"
+      " INNER JOIN Resources AS r ON r.ResourceId = t.ResourceId"
+      " GROUP BY t.Commodity;");
+  while (stmt->Step()) {
+    totals.traded[GetText(stmt, 0)] = stmt->GetDouble(1);
+  }
+  return totals;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+RunDecisions ReadRunDecisions(const std::string& db_file) {
+  RunDecisions decisions;
+  decisions.weight = 1.0;
+  cyclus::SqliteBack back(db_file);
+  cyclus::SqliteDb& db = back.db();
+  if (!HasTable(db, "WeaponProgress")) {
+    return decisions;
+  }
+
+  cyclus::SqlStatement::Ptr stmt = db.Prepare(
+      "SELECT a.Prototype, w.EqnType, MIN(w.Time) FROM WeaponProgress AS w"
+      " INNER JOIN AgentEntry AS a ON a.AgentId = w.AgentId"
+      " WHERE w.Decision = 1 GROUP BY a.Prototype, w.EqnType;");
+  while (stmt->Step()) {
+    std::string state = GetText(stmt, 0);
+    if (GetText(stmt, 1) == "Pursuit") {
+      decisions.pursuit_time[state] = stmt->GetInt(2);
+    }
+    else {
+      decisions.acquire_time[state] = stmt->GetInt(2);
+    }
+  }
+
+  // lr_weight is accumulated over the decisions of a state, so its last row
+  // holds the weight of the whole run
+  stmt = db.Prepare(
+      "SELECT w.LRWeight FROM WeaponProgress AS w"
+      " WHERE w.Time = (SELECT MAX(v.Time) FROM WeaponProgress AS v"
+      "                 WHERE v.AgentId = w.AgentId);");
+  while (stmt->Step()) {
+    decisions.weight *= stmt->GetDouble(0);
+  }
+  return decisions;
+}
+
+} // namespace mbmore
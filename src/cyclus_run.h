@@ -0,0 +1,48 @@
+#ifndef MBMORE_SRC_CYCLUS_RUN_H_
+#define MBMORE_SRC_CYCLUS_RUN_H_
+
+#include <map>
+#include <string>
+
+namespace mbmore {
+
+// Runs "command -o db_file input_file" with /bin/sh (ie. command is
+// "cyclus -v 0") and waits for it to finish. db_file is removed first, as
+// cyclus would otherwise add to an old database. Returns the exit status of
+// the command, or -1 if it could not be started or was killed. Safe to call
+// from several threads at once, so that a WorkPool can keep a fixed number
+// of simulations running.
+int RunCyclus(const std::string& command, const std::string& input_file,
+	      const std::string& db_file);
+
+// Totals of a cyclus output database
+struct RunTotals {
+  // of all RandomEnrich enrichments
+  double swu;
+  double natural_u;
+  // kg of resources transacted, by commodity
+  std::map<std::string, double> traded;
+};
+
+RunTotals ReadRunTotals(const std::string& db_file);
+
+// Weapon decisions of the StateInsts in a cyclus output database, by
+// prototype name
+struct RunDecisions {
+  // first timestep at which the state decided to pursue (acquire) a weapon,
+  // states for which it did not happen are left out
+  std::map<std::string, int> pursuit_time;
+  std::map<std::string, int> acquire_time;
+  // likelihood ratio weight of the run: the product of the final lr_weight
+  // of every StateInst (1 unless a tilt is set)
+  double weight;
+};
+
+// Reads the WeaponProgress table. In Delta progress_record mode every row
+// with a decision or a change in lr_weight is still written, so nothing is
+// lost.
+RunDecisions ReadRunDecisions(const std::string& db_file);
+
+} // namespace mbmore
+
+#endif  //  MBMORE_SRC_CYCLUS_RUN_H_
@@ -0,0 +1,179 @@
+#include "decision_input.h"
+
+#include <fstream>
+#include <sstream>
+
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/xml_parser.hpp>
+
+namespace mbmore {
+
+using boost::property_tree::ptree;
+
+namespace {
+
+// Default cyclus timestep (one month) in seconds
+const double kDefaultDt = 2629846;
+
+// Reads a value from an element, ignoring surrounding whitespace
+template <class T>
+T Value(const ptree& node, const std::string& path, T default_val) {
+  boost::optional<std::string> text = node.get_optional<std::string>(path);
+  if (!text) {
+    return default_val;
+  }
+  std::istringstream ss(*text);
+  T val;
+  if (!(ss >> val)) {
+    throw "could not read a value from the input file";
+  }
+  return val;
+}
+
+// <name>function</name><params><val>..</val>...</params>
+FactorEqn ReadEqn(const ptree& function) {
+  FactorEqn eqn;
+  eqn.first = Value<std::string>(function, "name", "");
+  boost::optional<const ptree&> params = function.get_child_optional("params");
+  if (params) {
+    ptree::const_iterator it;
+    for (it = params->begin(); it != params->end(); ++it) {
+      if (it->first == "val") {
+	eqn.second.push_back(Value<double>(it->second, "", 0));
+      }
+    }
+  }
+  return eqn;
+}
+
+void ReadRegion(const ptree& region, DecisionConfig* config) {
+  config->symmetric = Value<int>(region, "symmetric", 0) != 0;
+  config->conflict_network = Value<std::string>(region, "conflict_network",
+						"None");
+  config->network_hops = Value<int>(region, "network_hops", 1);
+  config->network_damping = Value<double>(region, "network_damping", 0.5);
+  config->likely_table_tol = Value<double>(region, "likely_table_tol", 1e-6);
+
+  ptree::const_iterator it;
+  boost::optional<const ptree&> node;
+  if ((node = region.get_child_optional("pursuit_weights"))) {
+    for (it = node->begin(); it != node->end(); ++it) {
+      config->wts[Value<std::string>(it->second, "factor", "")] =
+	Value<double>(it->second, "weight", 0);
+    }
+  }
+  if ((node = region.get_child_optional("likely_converter"))) {
+    for (it = node->begin(); it != node->end(); ++it) {
+      config->likely_rescale[Value<std::string>(it->second, "phase", "")] =
+	ReadEqn(it->second.get_child("function"));
+    }
+  }
+  if ((node = region.get_child_optional("conflict_scores"))) {
+    for (it = node->begin(); it != node->end(); ++it) {
+      config->score_overrides[Value<std::string>(it->second, "pair", "")] =
+	Value<int>(it->second, "score", 0);
+    }
+  }
+  if ((node = region.get_child_optional("p_conflict_relations"))) {
+    for (it = node->begin(); it != node->end(); ++it) {
+      const ptree& item = it->second;
+      if (item.get_child_optional("states")) {
+	// <states><primary_state/><pair_state/></states><relation/>
+	std::pair<std::string, std::string> key(
+	  Value<std::string>(item, "states.primary_state", ""),
+	  Value<std::string>(item, "states.pair_state", ""));
+	config->p_conflict_map[key] = Value<int>(item, "relation", 0);
+      }
+      else {
+	// <primary_state/><pair_state><item><name/><relation/></item>..
+	std::string primary = Value<std::string>(item, "primary_state", "");
+	const ptree& pairs = item.get_child("pair_state");
+	ptree::const_iterator p_it;
+	for (p_it = pairs.begin(); p_it != pairs.end(); ++p_it) {
+	  std::pair<std::string, std::string> key(
+	    primary, Value<std::string>(p_it->second, "name", ""));
+	  config->p_conflict_map[key] = Value<int>(p_it->second, "relation", 0);
+	}
+      }
+    }
+  }
+}
+
+void ReadState(const std::string& name, const ptree& inst,
+	       DecisionConfig* config) {
+  StateConfig state;
+  state.name = name;
+  state.weapon_status = Value<int>(inst, "weapon_status", 0);
+  state.pursuit_tilt = Value<double>(inst, "pursuit_tilt", 1.0);
+  state.acquire_tilt = Value<double>(inst, "acquire_tilt", 1.0);
+  boost::optional<const ptree&> factors =
+    inst.get_child_optional("pursuit_factors");
+  if (factors) {
+    ptree::const_iterator it;
+    for (it = factors->begin(); it != factors->end(); ++it) {
+      state.P_f[Value<std::string>(it->second, "factor", "")] =
+	ReadEqn(it->second.get_child("function"));
+    }
+  }
+  config->states.push_back(state);
+}
+
+} // namespace
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void ReadDecisionConfig(const std::string& xml_file, DecisionConfig* config) {
+  std::ifstream input(xml_file.c_str());
+  if (!input) {
+    throw "could not open the input file";
+  }
+  ReadDecisionConfig(input, config);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void ReadDecisionConfig(std::istream& input, DecisionConfig* config) {
+  ptree tree;
+  boost::property_tree::read_xml(input, tree);
+  ReadDecisionConfig(tree, config);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void ReadDecisionConfig(const ptree& tree, DecisionConfig* config) {
+  const ptree& sim = tree.get_child("simulation");
+
+  config->duration = Value<int>(sim, "control.duration", 0);
+  config->step_duration = Value<double>(sim, "control.dt", kDefaultDt) /
+    (12 * kDefaultDt);
+
+  bool found = false;
+  ptree::const_iterator r_it;
+  for (r_it = sim.begin(); r_it != sim.end() && !found; ++r_it) {
+    if (r_it->first != "region") {
+      continue;
+    }
+    boost::optional<const ptree&> region =
+      r_it->second.get_child_optional("config.InteractRegion");
+    if (!region) {
+      continue;
+    }
+    found = true;
+    ReadRegion(*region, config);
+
+    ptree::const_iterator i_it;
+    for (i_it = r_it->second.begin(); i_it != r_it->second.end(); ++i_it) {
+      if (i_it->first != "institution") {
+	continue;
+      }
+      boost::optional<const ptree&> inst =
+	i_it->second.get_child_optional("config.StateInst");
+      if (inst) {
+	ReadState(Value<std::string>(i_it->second, "name", ""), *inst,
+		  config);
+      }
+    }
+  }
+  if (!found) {
+    throw "input file has no InteractRegion";
+  }
+}
+
+} // namespace mbmore
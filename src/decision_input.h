@@ -0,0 +1,27 @@
+#ifndef MBMORE_SRC_DECISION_INPUT_H_
+#define MBMORE_SRC_DECISION_INPUT_H_
+
+#include <istream>
+#include <string>
+
+#include <boost/property_tree/ptree.hpp>
+
+#include "decision_model.h"
+
+namespace mbmore {
+
+// Reads the weapon decision model inputs from a cyclus input file: the
+// control duration and dt, the first InteractRegion config and the StateInst
+// config of each of its institutions (in input order). Other archetypes and
+// facilities are ignored.
+void ReadDecisionConfig(const std::string& xml_file, DecisionConfig* config);
+
+void ReadDecisionConfig(std::istream& input, DecisionConfig* config);
+
+// Same, from an input file that has already been parsed (ie. a sweep point)
+void ReadDecisionConfig(const boost::property_tree::ptree& tree,
+			DecisionConfig* config);
+
+} // namespace mbmore
+
+#endif  //  MBMORE_SRC_DECISION_INPUT_H_
@@ -0,0 +1,67 @@
+#include <gtest/gtest.h>
+
+#include <sstream>
+
+#include "decision_input.h"
+
+namespace mbmore {
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST(Decision_Input_Test, ReadConfig) {
+  std::stringstream xml;
+  xml << "<simulation>"
+      << " <control><duration>12</duration><dt>31558152</dt></control>"
+      << " <region><name>SuperRegion</name>"
+      << "  <config><InteractRegion>"
+      << "   <symmetric>1</symmetric>"
+      << "   <pursuit_weights>"
+      << "    <item><factor>Auth</factor> <weight>0.5</weight></item>"
+      << "    <item><factor>Conflict</factor> <weight>0.5</weight></item>"
+      << "   </pursuit_weights>"
+      << "   <likely_converter>"
+      << "    <item><phase>Pursuit</phase>"
+      << "     <function><name>power</name>"
+      << "      <params><val>4</val><val>0.1</val></params></function>"
+      << "    </item>"
+      << "   </likely_converter>"
+      << "   <p_conflict_relations>"
+      << "    <item><primary_state>StateA</primary_state>"
+      << "     <pair_state><item><name>StateB</name>"
+      << "      <relation>-1</relation></item></pair_state>"
+      << "    </item>"
+      << "   </p_conflict_relations>"
+      << "  </InteractRegion></config>"
+      << "  <institution><name>StateA</name>"
+      << "   <config><StateInst>"
+      << "    <weapon_status>2 </weapon_status>"
+      << "    <pursuit_factors>"
+      << "     <item><factor>Auth</factor>"
+      << "      <function><name>Constant</name>"
+      << "       <params><val>1</val></params></function>"
+      << "     </item>"
+      << "    </pursuit_factors>"
+      << "   </StateInst></config>"
+      << "  </institution>"
+      << " </region>"
+      << "</simulation>";
+
+  DecisionConfig config;
+  ReadDecisionConfig(xml, &config);
+
+  EXPECT_EQ(12, config.duration);
+  EXPECT_DOUBLE_EQ(1.0, config.step_duration);
+  EXPECT_TRUE(config.symmetric);
+  EXPECT_EQ("None", config.conflict_network);
+  EXPECT_DOUBLE_EQ(0.5, config.wts["Conflict"]);
+  EXPECT_EQ("power", config.likely_rescale["Pursuit"].first);
+  ASSERT_EQ(2, config.likely_rescale["Pursuit"].second.size());
+  EXPECT_DOUBLE_EQ(0.1, config.likely_rescale["Pursuit"].second[1]);
+  EXPECT_EQ(-1, config.p_conflict_map[std::make_pair(std::string("StateA"),
+						      std::string("StateB"))]);
+  ASSERT_EQ(1, config.states.size());
+  EXPECT_EQ("StateA", config.states[0].name);
+  EXPECT_EQ(2, config.states[0].weapon_status);
+  EXPECT_EQ("Constant", config.states[0].P_f["Auth"].first);
+}
+
+} // namespace mbmore
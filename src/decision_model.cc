@@ -0,0 +1,576 @@
+#include "decision_model.h"
+#include "behavior_functions.h"
+#include "work_pool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+
+namespace mbmore {
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+DecisionConfig::DecisionConfig()
+  : duration(0),
+    step_duration(1.0),
+    symmetric(false),
+    conflict_network("None"),
+    network_hops(1),
+    network_damping(0.5),
+    likely_table_tol(1e-6) {}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void TimeHistogram::Init(int duration) {
+  counts_.assign(duration, 0);
+  never_ = 0;
+  weights_.assign(duration, 0.0);
+  never_weight_ = 0;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void TimeHistogram::Add(int time, double weight) {
+  if (time < 0) {
+    never_++;
+    never_weight_ += weight;
+  }
+  else {
+    counts_[time]++;
+    weights_[time] += weight;
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void TimeHistogram::Merge(const TimeHistogram& other) {
+  for (int t = 0; t < counts_.size(); t++) {
+    counts_[t] += other.counts_[t];
+    weights_[t] += other.weights_[t];
+  }
+  never_ += other.never_;
+  never_weight_ += other.never_weight_;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+long TimeHistogram::total() const {
+  long sum = never_;
+  for (int t = 0; t < counts_.size(); t++) {
+    sum += counts_[t];
+  }
+  return sum;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+double TimeHistogram::event_weight() const {
+  double sum = 0;
+  for (int t = 0; t < weights_.size(); t++) {
+    sum += weights_[t];
+  }
+  return sum;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+DecisionModel::DecisionModel()
+  : duration_(0),
+    symmetric_(false),
+    use_conflict_(false),
+    conflict_wt_(0),
+    n_insts_(0),
+    pursuit_hash_(RngStream::Hash("pursuit")),
+    acquire_hash_(RngStream::Hash("acquire")),
+    factor_hash_(RngStream::Hash("factor_timing")) {}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+const std::vector<std::string>& DecisionModel::MasterFactors() {
+  static std::vector<std::string> master_factors;
+  if (master_factors.size() == 0) {
+    std::string factors [] = { "Auth", "Conflict", "Enrich",
+			       "Mil_Iso","Mil_Sp","Reactors",
+			       "Sci_Net", "U_Reserve"};
+    int n_factors = sizeof(factors) / sizeof(factors[0]);
+    master_factors.assign(factors, factors + n_factors);
+  }
+  return master_factors;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+int DecisionModel::StateIndex_(const std::string& name) {
+  std::map<std::string, int>::iterator it = ids_.find(name);
+  if (it != ids_.end()) {
+    return it->second;
+  }
+  int state = names_.size();
+  ids_[name] = state;
+  names_.push_back(name);
+  initial_status_.push_back(0);
+  initial_relations_.push_back(std::vector<std::pair<int, int> >());
+  return state;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void DecisionModel::Init(const DecisionConfig& config) {
+  duration_ = config.duration;
+  symmetric_ = config.symmetric;
+  ids_.clear();
+  names_.clear();
+  initial_status_.clear();
+  initial_relations_.clear();
+
+  // Conflict score table and network, as in InteractRegion::Tick
+  scores_.Reset();
+  std::map<std::string, int>::const_iterator sc_it;
+  for (sc_it = config.score_overrides.begin();
+       sc_it != config.score_overrides.end(); ++sc_it) {
+    int relation, status_a, status_b;
+    if (!ParseScorePair(sc_it->first, &relation, &status_a, &status_b)) {
+      throw "conflict_scores pairs must have the form relation_statusA_statusB";
+    }
+    scores_.Set(relation, status_a, status_b, sc_it->second);
+  }
+  if ((config.conflict_network != "None") &&
+      (config.conflict_network != "KHop") &&
+      (config.conflict_network != "Damped")) {
+    throw "conflict_network must be None, KHop or Damped";
+  }
+  if ((config.network_damping < 0) || (config.network_damping >= 1) ||
+      (config.network_hops < 0)) {
+    throw "network_damping must be in [0, 1) and network_hops must not be "
+      "negative";
+  }
+  network_.Configure(config.conflict_network, config.network_hops,
+		     config.network_damping);
+
+  // Normalized weights by master factor
+  const std::vector<std::string>& master_factors = MasterFactors();
+  std::vector<double> wts(master_factors.size(), 0.0);
+  std::vector<bool> present(master_factors.size(), false);
+  double tot_weight = 0.0;
+  std::map<std::string, double>::const_iterator wt_it;
+  for (wt_it = config.wts.begin(); wt_it != config.wts.end(); ++wt_it) {
+    tot_weight += wt_it->second;
+  }
+  for (int f = 0; f < master_factors.size(); f++) {
+    wt_it = config.wts.find(master_factors[f]);
+    if (wt_it != config.wts.end()) {
+      present[f] = true;
+      wts[f] = (tot_weight > 0) ? wt_it->second / tot_weight : 0;
+    }
+  }
+
+  // Registry: StateInsts first, then the other states in the relations
+  n_insts_ = config.states.size();
+  pursuit_tilt_.resize(n_insts_);
+  acquire_tilt_.resize(n_insts_);
+  for (int s = 0; s < n_insts_; s++) {
+    if (StateIndex_(config.states[s].name) != s) {
+      throw "StateInst names must be unique";
+    }
+    initial_status_[s] = config.states[s].weapon_status;
+    pursuit_tilt_[s] = config.states[s].pursuit_tilt;
+    acquire_tilt_[s] = config.states[s].acquire_tilt;
+    if ((pursuit_tilt_[s] <= 0) || (acquire_tilt_[s] <= 0)) {
+      throw "pursuit_tilt and acquire_tilt must be positive";
+    }
+  }
+  std::map<std::pair<std::string, std::string>, int>::const_iterator rel_it;
+  for (rel_it = config.p_conflict_map.begin();
+       rel_it != config.p_conflict_map.end(); ++rel_it) {
+    int this_state = StateIndex_(rel_it->first.first);
+    int other_state = StateIndex_(rel_it->first.second);
+    initial_relations_[this_state].push_back(std::make_pair(other_state,
+							    rel_it->second));
+  }
+
+  int conflict_f = -1;
+  for (int f = 0; f < master_factors.size(); f++) {
+    if (master_factors[f] == "Conflict") {
+      conflict_f = f;
+    }
+  }
+  use_conflict_ = present[conflict_f] && (n_insts_ > 1);
+  conflict_wt_ = wts[conflict_f];
+
+  // Time-dependent factors and Conflict relation changes of each state
+  base_eqn_.assign(n_insts_, std::vector<double>(duration_, 0.0));
+  changes_.assign(n_insts_, std::vector<RelationChange>());
+  random_changes_.assign(n_insts_, std::vector<RandomChange>());
+  for (int s = 0; s < n_insts_; s++) {
+    const std::map<std::string, FactorEqn>& P_f = config.states[s].P_f;
+    for (int f = 0; f < master_factors.size(); f++) {
+      if (!present[f] || (f == conflict_f)) {
+	continue;
+      }
+      std::map<std::string, FactorEqn>::const_iterator eqn_it =
+	P_f.find(master_factors[f]);
+      if (eqn_it == P_f.end()) {
+	throw "A pursuit factor has a weight but is not defined in "
+	  "pursuit_factors";
+      }
+      const std::string& function = eqn_it->second.first;
+      if (((function == "Step") || (function == "step")) &&
+	  (eqn_it->second.second.size() == 2)) {
+	continue;
+      }
+      for (int t = 0; t < duration_; t++) {
+	base_eqn_[s][t] += wts[f] * CalcYVal(eqn_it->second.first,
+					     eqn_it->second.second, t);
+      }
+    }
+
+    // Factors with a random change time, in the order StateInst::Tick
+    // draws them
+    std::map<std::string, FactorEqn>::const_iterator eqn_it;
+    for (eqn_it = P_f.begin(); eqn_it != P_f.end(); ++eqn_it) {
+      const std::string& factor = eqn_it->first;
+      const std::string& function = eqn_it->second.first;
+      const std::vector<double>& constants = eqn_it->second.second;
+      RandomChange change;
+      change.wt = 0;
+      change.other_state = -1;
+      if (((function == "Step") || (function == "step")) &&
+	  (constants.size() == 2)) {
+	change.step = true;
+	change.y0 = constants[0];
+	change.yf = constants[1];
+	for (int f = 0; f < master_factors.size(); f++) {
+	  if ((master_factors[f] == factor) && (f != conflict_f)) {
+	    change.wt = wts[f];
+	  }
+	}
+	random_changes_[s].push_back(change);
+      }
+      if (((factor == "Conflict") || (factor == "conflict")) &&
+	  (constants.size() == 1) && (std::abs(constants[0]) <= 1)) {
+	change.step = false;
+	change.new_val = std::round(constants[0]);
+	if (use_conflict_ && (factor == "Conflict")) {
+	  change.other_state = StateIndex_(function);
+	}
+	random_changes_[s].push_back(change);
+      }
+    }
+
+    if (!use_conflict_) {
+      continue;
+    }
+    if ((initial_relations_[s].size() == 0) && (initial_status_[s] != 3)) {
+      throw "A state is not defined in the p_conflict_relations";
+    }
+    std::map<std::string, FactorEqn>::const_iterator conflict_it =
+      P_f.find("Conflict");
+    if (conflict_it != P_f.end()) {
+      const std::vector<double>& constants = conflict_it->second.second;
+      if ((constants.size() > 1) &&
+	  (constants[1] == std::floor(constants[1]))) {
+	RelationChange change;
+	change.time = static_cast<int>(constants[1]);
+	change.other_state = StateIndex_(conflict_it->second.first);
+	change.new_val = std::round(constants[0]);
+	changes_[s].push_back(change);
+      }
+    }
+  }
+
+  double hist_duration = 75; // historical data covers 70 years
+  std::map<std::string, FactorEqn>::const_iterator p_it =
+    config.likely_rescale.find("Pursuit");
+  std::map<std::string, FactorEqn>::const_iterator a_it =
+    config.likely_rescale.find("Acquire");
+  if ((p_it == config.likely_rescale.end()) ||
+      (a_it == config.likely_rescale.end())) {
+    throw "likely_converter must define the Pursuit and Acquire phases";
+  }
+  p_likely_.Init("Pursuit", p_it->second.first, p_it->second.second,
+		 hist_duration, config.step_duration);
+  p_likely_.BuildTable(config.likely_table_tol);
+  a_likely_.Init("Acquire", a_it->second.first, a_it->second.second,
+		 hist_duration, config.step_duration);
+  a_likely_.BuildTable(config.likely_table_tol);
+
+  name_hashes_.resize(n_insts_);
+  for (int s = 0; s < n_insts_; s++) {
+    name_hashes_[s] = RngStream::Hash(names_[s]);
+  }
+  pursuit_rng_.resize(n_insts_);
+  acquire_rng_.resize(n_insts_);
+  factor_rng_.resize(n_insts_);
+  change_times_.resize(n_insts_);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Same as CalcYVal for a Step with constants (y0, yf, t_change)
+double DecisionModel::StepValue_(int state, int time,
+				 const std::vector<int>& change_times) const {
+  const std::vector<RandomChange>& changes = random_changes_[state];
+  double sum = 0;
+  for (int c = 0; c < changes.size(); c++) {
+    if (changes[c].step && (changes[c].wt != 0)) {
+      sum += changes[c].wt *
+	((time < change_times[c]) ? changes[c].y0 : changes[c].yf);
+    }
+  }
+  return sum;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Same as InteractRegion::ChangeConflictReln
+void DecisionModel::ChangeRelation_(int this_state, int other_state,
+				    int new_val) {
+  int n_changes = symmetric_ ? 2 : 1;
+  for (int i = 0; i < n_changes; i++) {
+    int primary = (i == 0) ? this_state : other_state;
+    int secondary = (i == 0) ? other_state : this_state;
+
+    std::vector<std::pair<int, int> >& relations = relations_[primary];
+    bool found = false;
+    for (int r = 0; r < relations.size(); r++) {
+      if (relations[r].first == secondary) {
+	relations[r].second = new_val;
+	found = true;
+      }
+    }
+    if (!found) {
+      relations.push_back(std::make_pair(secondary, new_val));
+    }
+  }
+  network_.RelationsChanged();
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void DecisionModel::Run(uint64_t seed, ReplicaOutcome* outcome) {
+  for (int s = 0; s < n_insts_; s++) {
+    pursuit_rng_[s].Seed(seed, name_hashes_[s], pursuit_hash_);
+    acquire_rng_[s].Seed(seed, name_hashes_[s], acquire_hash_);
+    factor_rng_[s].Seed(seed, name_hashes_[s], factor_hash_);
+    change_times_[s].resize(random_changes_[s].size());
+    for (int c = 0; c < random_changes_[s].size(); c++) {
+      change_times_[s][c] = RNG_Integer(0, duration_, factor_rng_[s]);
+    }
+  }
+  status_ = initial_status_;
+  relations_ = initial_relations_;
+  network_.RelationsChanged();
+  outcome->pursuit_time.assign(n_insts_, -1);
+  outcome->acquire_time.assign(n_insts_, -1);
+  outcome->weight = 1.0;
+
+  for (int t = 0; t < duration_; t++) {
+    for (int s = 0; s < n_insts_; s++) {
+      int status = status_[s];
+      if ((status != 0) && (status != 2)) {
+	continue;
+      }
+
+      double eqn_val = base_eqn_[s][t] + StepValue_(s, t, change_times_[s]);
+      if (use_conflict_) {
+	network_.Update(relations_, status_, scores_);
+	eqn_val += conflict_wt_ * network_.Score(s);
+	for (int c = 0; c < changes_[s].size(); c++) {
+	  if (changes_[s][c].time == t) {
+	    ChangeRelation_(s, changes_[s][c].other_state,
+			    changes_[s][c].new_val);
+	  }
+	}
+	const std::vector<RandomChange>& random = random_changes_[s];
+	for (int c = 0; c < random.size(); c++) {
+	  if (!random[c].step && (random[c].other_state >= 0) &&
+	      (change_times_[s][c] == t)) {
+	    ChangeRelation_(s, random[c].other_state, random[c].new_val);
+	  }
+	}
+      }
+
+      double likely;
+      double tilt;
+      RngStream* rng;
+      if (status == 0) {
+	likely = p_likely_.Likely(eqn_val);
+	tilt = pursuit_tilt_[s];
+	rng = &pursuit_rng_[s];
+      }
+      else {
+	likely = a_likely_.Likely(eqn_val);
+	tilt = acquire_tilt_[s];
+	rng = &acquire_rng_[s];
+      }
+      bool decision;
+      if (tilt == 1) {
+	decision = XLikely(likely, *rng);
+      }
+      else {
+	decision = XLikely(TiltProb(likely, tilt), *rng);
+	outcome->weight *= TiltWeight(likely, tilt, decision);
+      }
+      if (decision) {
+	if (status == 0) {
+	  status_[s] = 2;
+	  outcome->pursuit_time[s] = t;
+	}
+	else {
+	  status_[s] = 3;
+	  outcome->acquire_time[s] = t;
+	}
+	network_.StatusChanged();
+      }
+    }
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Each state decides in turn, as in Run. The probability of pursuing at t
+// is the probability of still being at status 0 times the pursuit
+// likelihood, and the probability of acquiring is the probability of being
+// at status 2 (before this timestep's pursuit) times the acquire likelihood.
+//
+// With the Conflict scores fixed, a state's factors do not depend on the
+// other states, so its random Step times are averaged over by carrying the
+// probabilities forward once for each combination of times.
+void DecisionModel::Expected(ExpectedOutcome* outcome) {
+  for (int s = 0; s < n_insts_; s++) {
+    for (int c = 0; c < random_changes_[s].size(); c++) {
+      if (!random_changes_[s][c].step &&
+	  (random_changes_[s][c].other_state >= 0)) {
+	throw "Expected does not support Conflict factors with a random "
+	  "change time";
+      }
+    }
+  }
+
+  // Equation values at status 0 and 2, [state][time]
+  status_ = initial_status_;
+  relations_ = initial_relations_;
+  network_.RelationsChanged();
+  std::vector<std::vector<double> > eqns_0 = base_eqn_;
+  std::vector<std::vector<double> > eqns_2 = base_eqn_;
+  for (int t = 0; t < duration_; t++) {
+    for (int s = 0; s < n_insts_; s++) {
+      bool deciding = (initial_status_[s] == 0) || (initial_status_[s] == 2);
+      if (use_conflict_ && deciding) {
+	int own_status = status_[s];
+	double* eqns[2] = {&eqns_0[s][t], &eqns_2[s][t]};
+	int statuses[2] = {0, 2};
+	for (int i = 0; i < 2; i++) {
+	  status_[s] = statuses[i];
+	  network_.StatusChanged();
+	  network_.Update(relations_, status_, scores_);
+	  *eqns[i] += conflict_wt_ * network_.Score(s);
+	}
+	status_[s] = own_status;
+	network_.StatusChanged();
+	for (int c = 0; c < changes_[s].size(); c++) {
+	  if (changes_[s][c].time == t) {
+	    ChangeRelation_(s, changes_[s][c].other_state,
+			    changes_[s][c].new_val);
+	  }
+	}
+      }
+    }
+  }
+
+  outcome->pursuit_prob.assign(n_insts_, std::vector<double>(duration_));
+  outcome->acquire_prob.assign(n_insts_, std::vector<double>(duration_));
+  outcome->pursuit_survival.assign(n_insts_, std::vector<double>(duration_));
+  outcome->acquire_survival.assign(n_insts_, std::vector<double>(duration_));
+
+  for (int s = 0; s < n_insts_; s++) {
+    const std::vector<RandomChange>& random = random_changes_[s];
+    double n_combos = 1;
+    for (int c = 0; c < random.size(); c++) {
+      if (random[c].step && (random[c].wt != 0)) {
+	n_combos *= duration_;
+      }
+    }
+    if (n_combos > 1e6) {
+      throw "Expected supports at most 1e6 combinations of random Step "
+	"times per state";
+    }
+    double combo_wt = 1.0 / n_combos;
+
+    // Odometer over the change times of the weighted random Steps
+    std::vector<int> times(random.size(), 0);
+    bool done = false;
+    while (!done) {
+      double p_0 = (initial_status_[s] == 0) ? 1.0 : 0.0;
+      double p_2 = (initial_status_[s] == 2) ? 1.0 : 0.0;
+      double p_3 = (initial_status_[s] == 3) ? 1.0 : 0.0;
+      for (int t = 0; t < duration_; t++) {
+	double step = StepValue_(s, t, times);
+	double pursue = 0;
+	double acquire = 0;
+	if (p_0 > 0) {
+	  pursue = p_0 * p_likely_.Likely(eqns_0[s][t] + step);
+	}
+	if (p_2 > 0) {
+	  acquire = p_2 * a_likely_.Likely(eqns_2[s][t] + step);
+	}
+	p_0 -= pursue;
+	p_2 += pursue - acquire;
+	p_3 += acquire;
+
+	outcome->pursuit_prob[s][t] += combo_wt * pursue;
+	outcome->acquire_prob[s][t] += combo_wt * acquire;
+	outcome->pursuit_survival[s][t] += combo_wt * p_0;
+	outcome->acquire_survival[s][t] += combo_wt * (1.0 - p_3);
+      }
+
+      done = true;
+      for (int c = 0; c < random.size(); c++) {
+	if (!random[c].step || (random[c].wt == 0)) {
+	  continue;
+	}
+	if (++times[c] < duration_) {
+	  done = false;
+	  break;
+	}
+	times[c] = 0;
+      }
+    }
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+DecisionEnsemble::DecisionEnsemble(const DecisionConfig& config) {
+  model_.Init(config);
+  pursuit_.resize(model_.n_states());
+  acquire_.resize(model_.n_states());
+  for (int s = 0; s < model_.n_states(); s++) {
+    pursuit_[s].Init(model_.duration());
+    acquire_[s].Init(model_.duration());
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Replica i is seeded with seed + i so that any replica can be reproduced
+void DecisionEnsemble::Run(long n_replicas, unsigned long seed,
+			   int n_threads) {
+  WorkPool pool(n_threads);
+  int n_states = model_.n_states();
+  long chunk_size = std::max(1L, std::min(1024L, n_replicas /
+					  (16L * pool.n_threads())));
+
+  std::vector<DecisionModel> models(pool.n_threads(), model_);
+  std::mutex merge_mutex;
+  pool.ParallelFor(n_replicas, chunk_size,
+		   [&](long begin, long end, int worker) {
+    ReplicaOutcome outcome;
+    std::vector<TimeHistogram> pursuit(n_states);
+    std::vector<TimeHistogram> acquire(n_states);
+    for (int s = 0; s < n_states; s++) {
+      pursuit[s].Init(model_.duration());
+      acquire[s].Init(model_.duration());
+    }
+
+    for (long i = begin; i < end; i++) {
+      models[worker].Run(seed + i, &outcome);
+      for (int s = 0; s < n_states; s++) {
+	pursuit[s].Add(outcome.pursuit_time[s], outcome.weight);
+	acquire[s].Add(outcome.acquire_time[s], outcome.weight);
+      }
+    }
+
+    std::lock_guard<std::mutex> lock(merge_mutex);
+    for (int s = 0; s < n_states; s++) {
+      pursuit_[s].Merge(pursuit[s]);
+      acquire_[s].Merge(acquire[s]);
+    }
+  });
+}
+
+} // namespace mbmore
@@ -0,0 +1,265 @@
+#ifndef MBMORE_SRC_DECISION_MODEL_H_
+#define MBMORE_SRC_DECISION_MODEL_H_
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "conflict_network.h"
+#include "conflict_scores.h"
+#include "likely_convert.h"
+#include "rng_stream.h"
+
+namespace mbmore {
+
+// Function name and constants of a factor or likelihood equation, as in the
+// StateInst pursuit_factors and InteractRegion likely_converter
+typedef std::pair<std::string, std::vector<double> > FactorEqn;
+
+// Inputs of a single StateInst
+struct StateConfig {
+  StateConfig() : weapon_status(0), pursuit_tilt(1), acquire_tilt(1) {}
+
+  std::string name;
+  int weapon_status;
+  std::map<std::string, FactorEqn> P_f;
+  // importance sampling tilts of the decision probabilities (see TiltProb)
+  double pursuit_tilt;
+  double acquire_tilt;
+};
+
+// Inputs of the weapon decision model. Names and defaults match the
+// InteractRegion and StateInst state variables.
+struct DecisionConfig {
+  DecisionConfig();
+
+  // number of timesteps and timestep length (years)
+  int duration;
+  double step_duration;
+
+  bool symmetric;
+  std::map<std::string, double> wts;
+  std::map<std::string, FactorEqn> likely_rescale;
+  std::map<std::pair<std::string, std::string>, int> p_conflict_map;
+  std::map<std::string, int> score_overrides;
+  std::string conflict_network;
+  int network_hops;
+  double network_damping;
+  double likely_table_tol;
+
+  // in the order the StateInsts make their decisions each timestep
+  std::vector<StateConfig> states;
+};
+
+// Timestep at which each state (in DecisionConfig order) began pursuit and
+// acquired a weapon, -1 if it did not happen during the replica. States that
+// start out pursuing have no pursuit time. weight is the likelihood ratio of
+// the replica (the product of the TiltWeights of every decision of every
+// state), which is 1 unless a tilt is set.
+struct ReplicaOutcome {
+  std::vector<int> pursuit_time;
+  std::vector<int> acquire_time;
+  double weight;
+};
+
+// Exact probabilities of the decisions of each state, [state][time]: the
+// probability that the state begins pursuit (acquires) at that timestep,
+// and the probability that it has not begun pursuit (acquired) by the end of
+// that timestep.
+struct ExpectedOutcome {
+  std::vector<std::vector<double> > pursuit_prob;
+  std::vector<std::vector<double> > acquire_prob;
+  std::vector<std::vector<double> > pursuit_survival;
+  std::vector<std::vector<double> > acquire_survival;
+};
+
+// Number of replicas in which an event happened at each timestep, and the
+// sum of their likelihood ratio weights. With importance sampling, the
+// weight divided by the number of replicas is an unbiased estimate of the
+// probability of the event at that time.
+class TimeHistogram {
+ public:
+  TimeHistogram() : never_(0), never_weight_(0) {}
+
+  void Init(int duration);
+
+  // Adds one replica, time -1 means the event never happened
+  void Add(int time, double weight = 1.0);
+
+  void Merge(const TimeHistogram& other);
+
+  const std::vector<long>& counts() const { return counts_; }
+  long never() const { return never_; }
+  long total() const;
+
+  const std::vector<double>& weights() const { return weights_; }
+  double never_weight() const { return never_weight_; }
+  // sum of the weights of the replicas in which the event happened
+  double event_weight() const;
+
+ private:
+  std::vector<long> counts_;
+  long never_;
+  std::vector<double> weights_;
+  double never_weight_;
+};
+
+// The pursuit and acquire decisions of StateInst::WeaponDecision and
+// InteractRegion, without a cyclus simulation (no material flow, database
+// or resource exchange). Each call to Run plays one replica of the status
+// state machine (0 -> 2 -> 3) of every state over the full duration:
+// states decide in order at each timestep, a change in status is seen by
+// the conflict scores of the states that decide after it, and Conflict
+// relation changes from pursuit_factors are applied when the state makes
+// its decision at that time.
+//
+// Factors other than Conflict only depend on time, so the weighted sum of
+// those factors is computed once for every state and timestep in Init. The
+// exceptions are the factors to which StateInst::Tick appends a random
+// t_change at the start of a simulation (a Step with two constants, and a
+// Conflict with a single constant of at most 1 in magnitude): their times
+// are drawn at the start of each replica, in pursuit_factors order, from a
+// per-state factor timing stream.
+//
+// Each state draws its pursuit and acquire decisions from its own
+// RngStream, keyed by the replica seed and the state name. Two scenarios
+// run with the same seed therefore use the same random numbers for the
+// same state and decision (common random numbers), even if states are
+// added or the statuses of other states change.
+//
+// A state with a pursuit or acquire tilt draws those decisions with the
+// tilted probability (TiltProb), and the replica is weighted by the
+// likelihood ratio of all its decisions, so that rare acquire events can be
+// estimated from far fewer replicas.
+class DecisionModel {
+ public:
+  DecisionModel();
+
+  // Throws if the inputs are inconsistent (ie. a weighted factor that a
+  // state does not define)
+  void Init(const DecisionConfig& config);
+
+  // Plays the replica with the given seed
+  void Run(uint64_t seed, ReplicaOutcome* outcome);
+
+  // Computes the probabilities of the decisions without sampling, by
+  // carrying the probability of each status (0, 2 and 3) of each state
+  // forward through the timesteps. The likelihoods come from the same
+  // factor curves and converters as Run (tilts are ignored).
+  //
+  // The Conflict score of a state is computed from its own status and the
+  // initial statuses of the other states (with the relation changes of
+  // pursuit_factors applied at their times). The result is exact when the
+  // Conflict score does not depend on the random statuses of the other
+  // states: a single state, no Conflict weight, or other states that do
+  // not change status. Otherwise it is the fixed-conflict approximation.
+  //
+  // Random Step times are averaged over every combination of times, of
+  // which there may be at most 1e6 per state. Random Conflict times are not
+  // supported (throws).
+  void Expected(ExpectedOutcome* outcome);
+
+  int n_states() const { return n_insts_; }
+  int duration() const { return duration_; }
+  const std::string& state_name(int state) const { return names_[state]; }
+
+  // Same list and order as InteractRegion::GetMasterFactors
+  static const std::vector<std::string>& MasterFactors();
+
+ private:
+  // A Conflict relation change from pursuit_factors
+  struct RelationChange {
+    int time;
+    int other_state;
+    int new_val;
+  };
+
+  // A factor that changes at a time drawn in each replica: a Step from y0
+  // to yf with weight wt, or a Conflict relation change. other_state is -1
+  // if the relation change is not used, as its time is drawn all the same.
+  struct RandomChange {
+    bool step;
+    double wt;
+    double y0;
+    double yf;
+    int other_state;
+    int new_val;
+  };
+
+  int StateIndex_(const std::string& name);
+  // Weighted sum of the random Step factors of a state at a time, given the
+  // change times of its RandomChanges
+  double StepValue_(int state, int time,
+		    const std::vector<int>& change_times) const;
+  void ChangeRelation_(int this_state, int other_state, int new_val);
+
+  int duration_;
+  bool symmetric_;
+  bool use_conflict_;
+  double conflict_wt_;
+
+  // StateInsts are indexed first, followed by any other state named in
+  // p_conflict_relations
+  int n_insts_;
+  std::map<std::string, int> ids_;
+  std::vector<std::string> names_;
+  std::vector<int> initial_status_;
+  RelationLists initial_relations_;
+  std::vector<double> pursuit_tilt_;
+  std::vector<double> acquire_tilt_;
+
+  // weighted sum of the non-Conflict factors, [state][time]
+  std::vector<std::vector<double> > base_eqn_;
+  std::vector<std::vector<RelationChange> > changes_;
+  std::vector<std::vector<RandomChange> > random_changes_;
+
+  ConflictScores scores_;
+  ConflictNetwork network_;
+  LikelyConverter p_likely_;
+  LikelyConverter a_likely_;
+
+  // hashes of the state names for seeding the streams
+  std::vector<uint64_t> name_hashes_;
+  uint64_t pursuit_hash_;
+  uint64_t acquire_hash_;
+  uint64_t factor_hash_;
+
+  // per-replica state
+  std::vector<int> status_;
+  RelationLists relations_;
+  std::vector<RngStream> pursuit_rng_;
+  std::vector<RngStream> acquire_rng_;
+  std::vector<RngStream> factor_rng_;
+  // [state][random change]
+  std::vector<std::vector<int> > change_times_;
+};
+
+// Plays n_replicas of the model starting from seed, and histograms the
+// pursuit and acquire times of each state
+class DecisionEnsemble {
+ public:
+  explicit DecisionEnsemble(const DecisionConfig& config);
+
+  // Replicas are spread over n_threads (0 for one per core) with a
+  // WorkPool. Each thread plays its own copy of the model, and the
+  // histograms of each finished chunk of replicas are merged into the
+  // ensemble as it goes. Replica i is always seeded with seed + i, so the
+  // result does not depend on the number of threads, and two ensembles run
+  // from the same seed are paired replica by replica. Successive calls add
+  // to the histograms.
+  void Run(long n_replicas, unsigned long seed, int n_threads = 1);
+
+  const DecisionModel& model() const { return model_; }
+  const TimeHistogram& pursuit(int state) const { return pursuit_[state]; }
+  const TimeHistogram& acquire(int state) const { return acquire_[state]; }
+
+ private:
+  DecisionModel model_;
+  std::vector<TimeHistogram> pursuit_;
+  std::vector<TimeHistogram> acquire_;
+};
+
+} // namespace mbmore
+
+#endif  //  MBMORE_SRC_DECISION_MODEL_H_
@@ -0,0 +1,327 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+#include "decision_model.h"
+
+namespace mbmore {
+
+namespace DecisionModelTests {
+
+// One state whose pursuit likelihood is p_pursue at every timestep (the
+// timestep is as long as the historical period) and whose acquire
+// likelihood is 1/avg_time
+DecisionConfig SingleState(double p_pursue, double avg_time, int status) {
+  DecisionConfig config;
+  config.duration = 5;
+  config.step_duration = 75;
+  config.wts["Auth"] = 1.0;
+  std::vector<double> pursuit;
+  pursuit.push_back(p_pursue);
+  config.likely_rescale["Pursuit"] = FactorEqn("Constant", pursuit);
+  std::vector<double> acquire;
+  acquire.push_back(avg_time);
+  config.likely_rescale["Acquire"] = FactorEqn("Constant", acquire);
+
+  StateConfig state;
+  state.name = "StateA";
+  state.weapon_status = status;
+  std::vector<double> auth;
+  auth.push_back(5);
+  state.P_f["Auth"] = FactorEqn("Constant", auth);
+  config.states.push_back(state);
+  return config;
+}
+
+} // namespace DecisionModelTests
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Pursuit times are geometrically distributed
+TEST(Decision_Model_Test, PursuitTimes) {
+  DecisionEnsemble ensemble(DecisionModelTests::SingleState(0.3, 1e6, 0));
+  long n = 20000;
+  ensemble.Run(n, 1);
+
+  const TimeHistogram& pursuit = ensemble.pursuit(0);
+  EXPECT_EQ(n, pursuit.total());
+  EXPECT_NEAR(0.3, pursuit.counts()[0] / double(n), 0.015);
+  EXPECT_NEAR(0.3 * 0.7, pursuit.counts()[1] / double(n), 0.015);
+  EXPECT_NEAR(pow(0.7, 5), pursuit.never() / double(n), 0.015);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// A state that starts out pursuing only makes acquire decisions. With a
+// timestep of 75 years an average time of 300 years is a likelihood of
+// 1 - (1 - 1/300)^75 per step.
+TEST(Decision_Model_Test, AcquireTimes) {
+  DecisionEnsemble ensemble(DecisionModelTests::SingleState(0.3, 300, 2));
+  long n = 20000;
+  ensemble.Run(n, 1);
+
+  double p = 1 - pow(1 - 1.0/300, 75);
+  EXPECT_EQ(n, ensemble.pursuit(0).never());
+  EXPECT_NEAR(p, ensemble.acquire(0).counts()[0] / double(n), 0.015);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Same seed gives the same histograms
+TEST(Decision_Model_Test, Reproducible) {
+  DecisionConfig config = DecisionModelTests::SingleState(0.3, 3, 0);
+  DecisionEnsemble first(config);
+  DecisionEnsemble second(config);
+  first.Run(500, 42);
+  second.Run(500, 42);
+  EXPECT_EQ(first.pursuit(0).counts(), second.pursuit(0).counts());
+  EXPECT_EQ(first.acquire(0).counts(), second.acquire(0).counts());
+}
+
+namespace DecisionModelTests {
+
+// StateB sees StateA (acquired) as an enemy (score 6) at t=0, then becomes
+// its ally (score 1) at t=1. The pursuit likelihood is 0.01 * conflict.
+DecisionConfig ConflictChange() {
+  DecisionConfig config;
+  config.duration = 2;
+  config.step_duration = 75;
+  config.wts["Conflict"] = 1.0;
+  std::vector<double> pursuit;
+  pursuit.push_back(0);
+  pursuit.push_back(0.01);
+  config.likely_rescale["Pursuit"] = FactorEqn("Linear", pursuit);
+  std::vector<double> acquire(1, 1e6);
+  config.likely_rescale["Acquire"] = FactorEqn("Constant", acquire);
+  config.p_conflict_map[std::make_pair("StateB", "StateA")] = -1;
+
+  StateConfig a;
+  a.name = "StateA";
+  a.weapon_status = 3;
+  config.states.push_back(a);
+  StateConfig b;
+  b.name = "StateB";
+  std::vector<double> change;
+  change.push_back(1);
+  change.push_back(0);
+  b.P_f["Conflict"] = FactorEqn("StateA", change);
+  config.states.push_back(b);
+  return config;
+}
+
+} // namespace DecisionModelTests
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// The pursuit likelihood follows StateB's change of relation to StateA
+TEST(Decision_Model_Test, ConflictChange) {
+  DecisionEnsemble ensemble(DecisionModelTests::ConflictChange());
+  long n = 40000;
+  ensemble.Run(n, 3);
+  const TimeHistogram& hist = ensemble.pursuit(1);
+  EXPECT_NEAR(0.06, hist.counts()[0] / double(n), 0.005);
+  EXPECT_NEAR(0.01, hist.counts()[1] / double(n - hist.counts()[0]), 0.003);
+  // StateA never decides
+  EXPECT_EQ(n, ensemble.pursuit(0).never());
+  EXPECT_EQ(n, ensemble.acquire(0).never());
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// A Step with two constants changes from 0 to 5 at a random time, drawn in
+// each replica, so the pursuit likelihood (0.1 * Auth) is 0.5 at t=0 in one
+// replica in five. Sampling agrees with the average over the change times.
+TEST(Decision_Model_Test, RandomStep) {
+  DecisionConfig config = DecisionModelTests::SingleState(0.3, 1e6, 0);
+  std::vector<double> pursuit;
+  pursuit.push_back(0);
+  pursuit.push_back(0.1);
+  config.likely_rescale["Pursuit"] = FactorEqn("Linear", pursuit);
+  std::vector<double> step;
+  step.push_back(0);
+  step.push_back(5);
+  config.states[0].P_f["Auth"] = FactorEqn("Step", step);
+
+  DecisionModel model;
+  EXPECT_NO_THROW(model.Init(config));
+  ExpectedOutcome expected;
+  model.Expected(&expected);
+  EXPECT_NEAR(0.2 * 0.5, expected.pursuit_prob[0][0], 1e-12);
+
+  DecisionEnsemble ensemble(config);
+  long n = 40000;
+  ensemble.Run(n, 5);
+  long pursued = 0;
+  for (int t = 0; t < config.duration; t++) {
+    pursued += ensemble.pursuit(0).counts()[t];
+    EXPECT_NEAR(expected.pursuit_survival[0][t], 1 - pursued / double(n),
+		0.01);
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// A Conflict with a single constant changes StateB's relation to StateA to
+// ally at t=0 or t=1, taking effect from the next timestep, so the pursuit
+// likelihood at t=1 is 0.01 or 0.06 with equal chance
+TEST(Decision_Model_Test, RandomConflictChange) {
+  DecisionConfig config = DecisionModelTests::ConflictChange();
+  std::vector<double> change(1, 1);
+  config.states[1].P_f["Conflict"] = FactorEqn("StateA", change);
+
+  DecisionEnsemble ensemble(config);
+  long n = 40000;
+  ensemble.Run(n, 3);
+  const TimeHistogram& hist = ensemble.pursuit(1);
+  EXPECT_NEAR(0.06, hist.counts()[0] / double(n), 0.005);
+  EXPECT_NEAR(0.035, hist.counts()[1] / double(n - hist.counts()[0]), 0.004);
+
+  DecisionModel model;
+  model.Init(config);
+  ExpectedOutcome expected;
+  EXPECT_THROW(model.Expected(&expected), const char*);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST(Decision_Model_Test, MissingFactor) {
+  DecisionConfig config = DecisionModelTests::SingleState(0.3, 3, 0);
+  config.wts["Enrich"] = 1.0;
+  DecisionModel model;
+  EXPECT_ANY_THROW(model.Init(config));
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Replicas are seeded by their index, so threads do not change the result
+TEST(Decision_Model_Test, Threads) {
+  DecisionConfig config = DecisionModelTests::SingleState(0.3, 3, 0);
+  DecisionEnsemble serial(config);
+  DecisionEnsemble threaded(config);
+  serial.Run(5000, 7, 1);
+  threaded.Run(5000, 7, 4);
+  EXPECT_EQ(serial.pursuit(0).counts(), threaded.pursuit(0).counts());
+  EXPECT_EQ(serial.acquire(0).counts(), threaded.acquire(0).counts());
+  EXPECT_EQ(5000, threaded.pursuit(0).total());
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Adding a state does not change the draws of the others (common random
+// numbers), so StateA has the same outcome in every paired replica
+TEST(Decision_Model_Test, CommonRandomNumbers) {
+  DecisionConfig config = DecisionModelTests::SingleState(0.3, 3, 0);
+  DecisionModel single;
+  single.Init(config);
+
+  StateConfig extra = config.states[0];
+  extra.name = "StateB";
+  config.states.insert(config.states.begin(), extra);
+  DecisionModel pair;
+  pair.Init(config);
+
+  ReplicaOutcome single_out;
+  ReplicaOutcome pair_out;
+  for (int i = 0; i < 200; i++) {
+    single.Run(i, &single_out);
+    pair.Run(i, &pair_out);
+    EXPECT_EQ(single_out.pursuit_time[0], pair_out.pursuit_time[1]);
+    EXPECT_EQ(single_out.acquire_time[0], pair_out.acquire_time[1]);
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// A rare acquire (about 1.5% over 20 steps) estimated from the weights of
+// 20000 tilted replicas matches brute force sampling of 200000 replicas and
+// the exact probability. About a quarter of the tilted replicas acquire, so
+// the estimate has a smaller error than brute force with a tenth of the
+// replicas.
+TEST(Decision_Model_Test, ImportanceSampling) {
+  DecisionConfig config = DecisionModelTests::SingleState(0.3, 1e5, 2);
+  config.duration = 20;
+  double p = 1 - pow(1 - 1e-5, 75);
+  double exact = 1 - pow(1 - p, config.duration);
+
+  DecisionEnsemble brute(config);
+  long n_brute = 200000;
+  brute.Run(n_brute, 1);
+  double brute_est = 1 - brute.acquire(0).never() / double(n_brute);
+
+  config.states[0].acquire_tilt = 20;
+  DecisionEnsemble tilted(config);
+  long n_tilted = 20000;
+  tilted.Run(n_tilted, 1);
+  const TimeHistogram& acquire = tilted.acquire(0);
+  double tilted_est = acquire.event_weight() / n_tilted;
+
+  EXPECT_GT(n_tilted - acquire.never(), 0.2 * n_tilted);
+  EXPECT_NEAR(exact, brute_est, 0.001);
+  EXPECT_NEAR(exact, tilted_est, 0.0006);
+  EXPECT_NEAR(brute_est, tilted_est, 0.0015);
+  // all the weight of the untilted replicas is accounted for
+  EXPECT_NEAR(1.0, (tilted_est * n_tilted + acquire.never_weight()) /
+	      n_tilted, 0.01);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Constant likelihoods give geometric pursuit times, and a state can only
+// acquire from the timestep after it began pursuit
+TEST(Decision_Model_Test, ExpectedGeometric) {
+  DecisionModel model;
+  model.Init(DecisionModelTests::SingleState(0.3, 300, 0));
+  ExpectedOutcome expected;
+  model.Expected(&expected);
+
+  double tol = 1e-12;
+  double a = 1 - pow(1 - 1.0/300, 75);
+  for (int t = 0; t < 5; t++) {
+    EXPECT_NEAR(0.3 * pow(0.7, t), expected.pursuit_prob[0][t], tol);
+    EXPECT_NEAR(pow(0.7, t + 1), expected.pursuit_survival[0][t], tol);
+  }
+  EXPECT_NEAR(0, expected.acquire_prob[0][0], tol);
+  EXPECT_NEAR(0.3 * a, expected.acquire_prob[0][1], tol);
+  EXPECT_NEAR(1 - 0.3 * a, expected.acquire_survival[0][1], tol);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Time-varying pursuit likelihood (0.05 * (1 + t)): the exact survival
+// curves agree with sampling
+TEST(Decision_Model_Test, ExpectedMatchesSampling) {
+  DecisionConfig config = DecisionModelTests::SingleState(0.3, 100, 0);
+  config.duration = 8;
+  std::vector<double> pursuit;
+  pursuit.push_back(0);
+  pursuit.push_back(0.05);
+  config.likely_rescale["Pursuit"] = FactorEqn("Linear", pursuit);
+  std::vector<double> auth;
+  auth.push_back(1);
+  auth.push_back(1);
+  config.states[0].P_f["Auth"] = FactorEqn("Linear", auth);
+
+  DecisionEnsemble ensemble(config);
+  long n = 20000;
+  ensemble.Run(n, 11);
+  ExpectedOutcome expected;
+  DecisionModel model;
+  model.Init(config);
+  model.Expected(&expected);
+
+  long pursued = 0;
+  long acquired = 0;
+  for (int t = 0; t < config.duration; t++) {
+    pursued += ensemble.pursuit(0).counts()[t];
+    acquired += ensemble.acquire(0).counts()[t];
+    EXPECT_NEAR(expected.pursuit_survival[0][t], 1 - pursued / double(n),
+		0.015);
+    EXPECT_NEAR(expected.acquire_survival[0][t], 1 - acquired / double(n),
+		0.015);
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// StateA does not change status, so the Conflict case is exact
+TEST(Decision_Model_Test, ExpectedConflict) {
+  DecisionModel model;
+  model.Init(DecisionModelTests::ConflictChange());
+  ExpectedOutcome expected;
+  model.Expected(&expected);
+
+  double tol = 1e-12;
+  EXPECT_NEAR(0.06, expected.pursuit_prob[1][0], tol);
+  EXPECT_NEAR(0.94 * 0.01, expected.pursuit_prob[1][1], tol);
+  EXPECT_NEAR(0, expected.pursuit_prob[0][0], tol);
+  EXPECT_NEAR(0, expected.acquire_survival[0][1], tol);
+}
+
+} // namespace mbmore
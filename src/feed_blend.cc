@@ -0,0 +1,158 @@
+#include "feed_blend.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "ClpSimplex.hpp"
+
+namespace mbmore {
+
+namespace {
+
+// separative potential of a U-235 fraction
+double ValueFunc(double assay) {
+  return (1 - 2 * assay) * std::log(1 / assay - 1);
+}
+
+} // namespace
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+double FeedPerProduct(double feed_assay, double product_assay,
+		      double tails_assay) {
+  return (product_assay - tails_assay) / (feed_assay - tails_assay);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+double SwuPerProduct(double feed_assay, double product_assay,
+		     double tails_assay) {
+  double feed = FeedPerProduct(feed_assay, product_assay, tails_assay);
+  return ValueFunc(product_assay) + (feed - 1) * ValueFunc(tails_assay)
+    - feed * ValueFunc(feed_assay);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+FeedBlend::FeedBlend(const std::string& objective, double tails_assay)
+  : tails_assay_(tails_assay),
+    n_bins_(0) {
+  if ((objective != "SWU") && (objective != "NatU")) {
+    throw "feed blend objective must be SWU or NatU";
+  }
+  min_swu_ = (objective == "SWU");
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// One column per usable (order, bin) pair, with a coefficient in the
+// order's row, the bin's row and the SWU row
+bool FeedBlend::Solve(const std::vector<FeedBin>& bins,
+		      const std::vector<FeedOrder>& orders,
+		      double swu_capacity) {
+  int n_orders = orders.size();
+  n_bins_ = bins.size();
+  product_.assign(n_orders * n_bins_, 0);
+  feed_per_.assign(n_orders * n_bins_, 0);
+  swu_per_.assign(n_orders * n_bins_, 0);
+  if (n_orders == 0) {
+    return true;
+  }
+
+  int swu_row = n_orders + n_bins_;
+  int n_rows = swu_row + 1;
+  std::vector<double> row_lb(n_rows, 0);
+  std::vector<double> row_ub(n_rows, 0);
+  for (int i = 0; i < n_orders; i++) {
+    row_lb[i] = orders[i].qty;
+    row_ub[i] = orders[i].qty;
+  }
+  for (int b = 0; b < n_bins_; b++) {
+    row_lb[n_orders + b] = 0;
+    row_ub[n_orders + b] = bins[b].qty;
+  }
+  row_lb[swu_row] = 0;
+  row_ub[swu_row] = swu_capacity;
+
+  std::vector<CoinBigIndex> starts(1, 0);
+  std::vector<int> rows;
+  std::vector<double> values;
+  std::vector<double> costs;
+  std::vector<int> pairs;
+  for (int i = 0; i < n_orders; i++) {
+    for (int b = 0; b < n_bins_; b++) {
+      double xf = bins[b].assay;
+      if ((xf <= tails_assay_) || (xf >= orders[i].assay) ||
+	  (bins[b].u_frac <= 0)) {
+	continue;
+      }
+      int pair = i * n_bins_ + b;
+      feed_per_[pair] = FeedPerProduct(xf, orders[i].assay, tails_assay_) /
+	bins[b].u_frac;
+      swu_per_[pair] = SwuPerProduct(xf, orders[i].assay, tails_assay_);
+      rows.push_back(i);
+      values.push_back(1);
+      rows.push_back(n_orders + b);
+      values.push_back(feed_per_[pair]);
+      rows.push_back(swu_row);
+      values.push_back(swu_per_[pair]);
+      starts.push_back(rows.size());
+      costs.push_back(min_swu_ ? swu_per_[pair] : feed_per_[pair]);
+      pairs.push_back(pair);
+    }
+  }
+  int n_cols = pairs.size();
+  if (n_cols == 0) {
+    return false;
+  }
+  std::vector<double> col_lb(n_cols, 0);
+
+  ClpSimplex model;
+  model.setLogLevel(0);
+  model.loadProblem(n_cols, n_rows, &starts[0], &rows[0], &values[0],
+		    &col_lb[0], NULL, &costs[0], &row_lb[0], &row_ub[0]);
+  model.setOptimizationDirection(1);
+  model.primal();
+  if (!model.isProvenOptimal()) {
+    return false;
+  }
+
+  const double* solution = model.primalColumnSolution();
+  for (int c = 0; c < n_cols; c++) {
+    product_[pairs[c]] = std::max(0.0, solution[c]);
+  }
+  return true;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+double FeedBlend::product(int order, int bin) const {
+  return product_[order * n_bins_ + bin];
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+double FeedBlend::feed(int order, int bin) const {
+  int pair = order * n_bins_ + bin;
+  return product_[pair] * feed_per_[pair];
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+double FeedBlend::swu(int order, int bin) const {
+  int pair = order * n_bins_ + bin;
+  return product_[pair] * swu_per_[pair];
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+double FeedBlend::total_feed() const {
+  double tot = 0;
+  for (int p = 0; p < product_.size(); p++) {
+    tot += product_[p] * feed_per_[p];
+  }
+  return tot;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+double FeedBlend::total_swu() const {
+  double tot = 0;
+  for (int p = 0; p < product_.size(); p++) {
+    tot += product_[p] * swu_per_[p];
+  }
+  return tot;
+}
+
+} // namespace mbmore
@@ -0,0 +1,81 @@
+#ifndef MBMORE_SRC_FEED_BLEND_H_
+#define MBMORE_SRC_FEED_BLEND_H_
+
+#include <string>
+#include <vector>
+
+namespace mbmore {
+
+// Feed material on hand with one U-235 assay
+struct FeedBin {
+  // U-235 fraction of the uranium
+  double assay;
+  // mass fraction of U-235 and U-238 in the material
+  double u_frac;
+  // kg of material
+  double qty;
+};
+
+// Product ordered in a timestep
+struct FeedOrder {
+  // U-235 fraction of the product
+  double assay;
+  // kg of product
+  double qty;
+};
+
+// SWU and kg of uranium feed needed per kg of product enriched from feed at
+// feed_assay, with tails at tails_assay (same as the cyclus toolkit
+// SwuRequired and FeedQty)
+double SwuPerProduct(double feed_assay, double product_assay,
+		     double tails_assay);
+double FeedPerProduct(double feed_assay, double product_assay,
+		      double tails_assay);
+
+// Chooses which feed bins each order is enriched from, by solving the linear
+// program
+//
+//   minimise    sum_ib c_ib y_ib
+//   subject to  sum_b y_ib = qty_i                 (each order is filled)
+//               sum_i feed_ib y_ib <= qty_b        (feed in each bin)
+//               sum_ib swu_ib y_ib <= swu_capacity
+//               y_ib >= 0
+//
+// where y_ib is the kg of product of order i made from bin b, feed_ib and
+// swu_ib are the kg of feed material and SWU per kg of that product, and
+// c_ib is swu_ib (objective "SWU") or feed_ib (objective "NatU"). Bins at or
+// below the tails assay, or at or above an order's assay, are not used for
+// that order.
+class FeedBlend {
+ public:
+  // throws if the objective is not SWU or NatU
+  FeedBlend(const std::string& objective, double tails_assay);
+
+  // Returns false if the orders cannot all be filled from the bins within
+  // the SWU capacity
+  bool Solve(const std::vector<FeedBin>& bins,
+	     const std::vector<FeedOrder>& orders, double swu_capacity);
+
+  // kg of product of an order made from a bin, and the kg of feed material
+  // and SWU used for it (after a successful Solve)
+  double product(int order, int bin) const;
+  double feed(int order, int bin) const;
+  double swu(int order, int bin) const;
+
+  // totals over all orders and bins
+  double total_feed() const;
+  double total_swu() const;
+
+ private:
+  bool min_swu_;
+  double tails_assay_;
+  int n_bins_;
+  // per order and bin, indexed order * n_bins_ + bin
+  std::vector<double> product_;
+  std::vector<double> feed_per_;
+  std::vector<double> swu_per_;
+};
+
+} // namespace mbmore
+
+#endif  //  MBMORE_SRC_FEED_BLEND_H_
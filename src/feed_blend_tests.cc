@@ -0,0 +1,75 @@
+#include <gtest/gtest.h>
+
+#include "feed_blend.h"
+
+namespace mbmore {
+
+namespace FeedBlendTests {
+
+// natural uranium and a richer recycled feed
+std::vector<FeedBin> TwoBins(double rich_qty) {
+  std::vector<FeedBin> bins;
+  FeedBin natural = {0.00711, 1.0, 1000};
+  FeedBin rich = {0.01, 1.0, rich_qty};
+  bins.push_back(natural);
+  bins.push_back(rich);
+  return bins;
+}
+
+std::vector<FeedOrder> OneOrder(double assay, double qty) {
+  FeedOrder order = {assay, qty};
+  return std::vector<FeedOrder>(1, order);
+}
+
+} // namespace FeedBlendTests
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Feed and SWU per kg of 4% product from natural uranium with 0.3% tails
+TEST(Feed_Blend_Test, PerProduct) {
+  EXPECT_NEAR(9.0024, FeedPerProduct(0.00711, 0.04, 0.003), 1e-4);
+  EXPECT_NEAR(5.2765, SwuPerProduct(0.00711, 0.04, 0.003), 1e-4);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// With enough rich feed, the whole order is made from it
+TEST(Feed_Blend_Test, RichestFeed) {
+  FeedBlend blend("SWU", 0.003);
+  ASSERT_TRUE(blend.Solve(FeedBlendTests::TwoBins(100),
+			  FeedBlendTests::OneOrder(0.04, 1), 1e299));
+  EXPECT_NEAR(0, blend.product(0, 0), 1e-9);
+  EXPECT_NEAR(1, blend.product(0, 1), 1e-9);
+  EXPECT_NEAR(SwuPerProduct(0.01, 0.04, 0.003), blend.total_swu(), 1e-9);
+  EXPECT_NEAR(FeedPerProduct(0.01, 0.04, 0.003), blend.total_feed(), 1e-9);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// When the rich feed runs out, the rest of the order is made from natural
+// uranium, for both objectives
+TEST(Feed_Blend_Test, SplitOrder) {
+  double rich_qty = 2;
+  double from_rich = rich_qty / FeedPerProduct(0.01, 0.04, 0.003);
+  for (int o = 0; o < 2; o++) {
+    FeedBlend blend((o == 0) ? "SWU" : "NatU", 0.003);
+    ASSERT_TRUE(blend.Solve(FeedBlendTests::TwoBins(rich_qty),
+			    FeedBlendTests::OneOrder(0.04, 1), 1e299));
+    EXPECT_NEAR(from_rich, blend.product(0, 1), 1e-9);
+    EXPECT_NEAR(1 - from_rich, blend.product(0, 0), 1e-9);
+    EXPECT_NEAR(rich_qty, blend.feed(0, 1), 1e-9);
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Orders that need more SWU or feed than available cannot be filled, and
+// feed above the product assay is not used
+TEST(Feed_Blend_Test, Infeasible) {
+  FeedBlend blend("SWU", 0.003);
+  EXPECT_FALSE(blend.Solve(FeedBlendTests::TwoBins(100),
+			   FeedBlendTests::OneOrder(0.04, 1), 3));
+  EXPECT_FALSE(blend.Solve(FeedBlendTests::TwoBins(0),
+			   FeedBlendTests::OneOrder(0.04, 200), 1e299));
+  EXPECT_FALSE(blend.Solve(FeedBlendTests::TwoBins(100),
+			   FeedBlendTests::OneOrder(0.005, 1), 1e299));
+  EXPECT_THROW(FeedBlend("Cost", 0.003), const char*);
+}
+
+} // namespace mbmore
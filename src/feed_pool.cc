@@ -0,0 +1,122 @@
+#include "feed_pool.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "feed_blend.h"
+
+namespace mbmore {
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+FeedPool::FeedPool(double bin_width)
+  : bin_width_(bin_width),
+    qty_(0),
+    u_(0),
+    u235_(0) {
+  if (bin_width <= 0) {
+    throw "feed pool bin width must be positive";
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+long FeedPool::Bin(double assay) const {
+  return static_cast<long>(std::floor(assay / bin_width_));
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void FeedPool::Add(double assay, double u_frac, double qty) {
+  if (qty <= 0) {
+    return;
+  }
+  double u = qty * u_frac;
+  Bin_& bin = bins_[Bin(assay)];
+  bin.qty += qty;
+  bin.u += u;
+  bin.u235 += u * assay;
+  qty_ += qty;
+  u_ += u;
+  u235_ += u * assay;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void FeedPool::Take(double qty) {
+  while ((qty > 0) && !bins_.empty()) {
+    std::map<long, Bin_>::iterator it = --bins_.end();
+    Bin_& bin = it->second;
+    if (qty >= bin.qty) {
+      qty -= bin.qty;
+      qty_ -= bin.qty;
+      u_ -= bin.u;
+      u235_ -= bin.u235;
+      bins_.erase(it);
+    } else {
+      double frac = qty / bin.qty;
+      qty_ -= qty;
+      u_ -= frac * bin.u;
+      u235_ -= frac * bin.u235;
+      bin.qty -= qty;
+      bin.u -= frac * bin.u;
+      bin.u235 -= frac * bin.u235;
+      qty = 0;
+    }
+  }
+  if (bins_.empty()) {
+    Clear();
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void FeedPool::Clear() {
+  bins_.clear();
+  qty_ = 0;
+  u_ = 0;
+  u235_ = 0;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+double FeedPool::assay() const {
+  return (u_ > 0) ? u235_ / u_ : 0;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Each bin (or what is left of it after the skipped feed) can make
+// u (xf - xt) / (xp - xt) kg of product, so bins are drawn whole until the
+// one that finishes the product, which is drawn in part.
+FeedDraw FeedPool::Draw(double product_assay, double product_qty,
+			double tails_assay, double skip) const {
+  FeedDraw draw = {0, 0, false};
+  double u = 0;
+  double u235 = 0;
+  double left = product_qty;
+  std::map<long, Bin_>::const_reverse_iterator it;
+  for (it = bins_.rbegin(); (it != bins_.rend()) && (left > 0); ++it) {
+    const Bin_& bin = it->second;
+    double frac = 1;
+    if (skip > 0) {
+      if (skip >= bin.qty) {
+	skip -= bin.qty;
+	continue;
+      }
+      frac = 1 - skip / bin.qty;
+      skip = 0;
+    }
+    if ((bin.u <= 0) || (bin.u235 / bin.u <= tails_assay)) {
+      break;
+    }
+    double makes = frac * bin.u / FeedPerProduct(bin.u235 / bin.u,
+						 product_assay, tails_assay);
+    if (makes > left) {
+      frac *= left / makes;
+      makes = left;
+    }
+    draw.qty += frac * bin.qty;
+    u += frac * bin.u;
+    u235 += frac * bin.u235;
+    left -= makes;
+  }
+  draw.assay = (u > 0) ? u235 / u : 0;
+  draw.enough = (left <= product_qty * 1e-12);
+  return draw;
+}
+
+} // namespace mbmore
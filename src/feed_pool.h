@@ -0,0 +1,72 @@
+#ifndef MBMORE_SRC_FEED_POOL_H_
+#define MBMORE_SRC_FEED_POOL_H_
+
+#include <map>
+
+namespace mbmore {
+
+// Feed that would be drawn for an enrichment: kg of material, and the U-235
+// fraction of its uranium once merged. enough is false if the pool cannot
+// make the product (without using feed at or below the tails assay).
+struct FeedDraw {
+  double qty;
+  double assay;
+  bool enough;
+};
+
+// Index of the feed inventory of an enrichment facility by U-235 assay.
+// Feed is grouped into bins of U-235 fraction bin_width wide, and each bin
+// keeps its kg of material, uranium and U-235. Bins are ordered by assay, so
+// feed can be drawn richest first, and the totals are kept as feed is added
+// and taken, so the assay of the pool or of a withdrawal is known without
+// touching the materials.
+class FeedPool {
+ public:
+  explicit FeedPool(double bin_width = 1e-4);
+
+  // Bin of a U-235 fraction
+  long Bin(double assay) const;
+
+  // Adds qty kg of material whose uranium has the given U-235 fraction and
+  // is u_frac of its mass. O(log bins).
+  void Add(double assay, double u_frac, double qty);
+
+  // Removes qty kg of material, richest bins first
+  void Take(double qty);
+
+  void Clear();
+
+  // Feed drawn richest first to make product_qty kg of product at
+  // product_assay with tails at tails_assay, after the richest skip kg
+  // (ie. feed already drawn for other products)
+  FeedDraw Draw(double product_assay, double product_qty, double tails_assay,
+		double skip = 0) const;
+
+  // kg of material and the U-235 fraction of all its uranium
+  double quantity() const { return qty_; }
+  double assay() const;
+  // kg of uranium
+  double uranium() const { return u_; }
+
+  int n_bins() const { return bins_.size(); }
+  // lowest and highest bin holding feed (pool must not be empty)
+  long lowest_bin() const { return bins_.begin()->first; }
+  long highest_bin() const { return bins_.rbegin()->first; }
+
+ private:
+  struct Bin_ {
+    double qty;
+    double u;
+    double u235;
+  };
+
+  double bin_width_;
+  std::map<long, Bin_> bins_;
+  double qty_;
+  double u_;
+  double u235_;
+};
+
+} // namespace mbmore
+
+#endif  //  MBMORE_SRC_FEED_POOL_H_
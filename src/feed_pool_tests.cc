@@ -0,0 +1,74 @@
+#include <gtest/gtest.h>
+
+#include "feed_blend.h"
+#include "feed_pool.h"
+
+namespace mbmore {
+
+namespace FeedPoolTests {
+
+// natural uranium, and less of a richer recycled feed
+FeedPool TwoAssays() {
+  FeedPool pool(1e-4);
+  pool.Add(0.00711, 1.0, 1000);
+  pool.Add(0.01, 1.0, 10);
+  return pool;
+}
+
+} // namespace FeedPoolTests
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Feed is kept in bins ordered by assay, with the totals of the pool
+TEST(Feed_Pool_Test, Bins) {
+  FeedPool pool = FeedPoolTests::TwoAssays();
+  pool.Add(0.01001, 1.0, 10);
+  EXPECT_EQ(2, pool.n_bins());
+  EXPECT_EQ(pool.Bin(0.00711), pool.lowest_bin());
+  EXPECT_EQ(pool.Bin(0.01), pool.highest_bin());
+  EXPECT_DOUBLE_EQ(1020, pool.quantity());
+  EXPECT_NEAR((7.11 + 0.2001) / 1020, pool.assay(), 1e-12);
+  EXPECT_THROW(FeedPool(0), const char*);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Taking feed empties the richest bin first
+TEST(Feed_Pool_Test, Take) {
+  FeedPool pool = FeedPoolTests::TwoAssays();
+  pool.Take(4);
+  EXPECT_EQ(2, pool.n_bins());
+  EXPECT_NEAR((7.11 + 0.06) / 1006, pool.assay(), 1e-12);
+  pool.Take(6);
+  EXPECT_EQ(1, pool.n_bins());
+  EXPECT_NEAR(0.00711, pool.assay(), 1e-12);
+  pool.Take(2000);
+  EXPECT_EQ(0, pool.n_bins());
+  EXPECT_EQ(0, pool.quantity());
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// A product is drawn from the rich feed while it lasts, then from natural
+// uranium, after any feed already drawn for other products
+TEST(Feed_Pool_Test, Draw) {
+  FeedPool pool = FeedPoolTests::TwoAssays();
+  double per_rich = FeedPerProduct(0.01, 0.04, 0.003);
+
+  FeedDraw small = pool.Draw(0.04, 1, 0.003);
+  EXPECT_TRUE(small.enough);
+  EXPECT_NEAR(per_rich, small.qty, 1e-9);
+  EXPECT_NEAR(0.01, small.assay, 1e-12);
+
+  // all of the rich feed and some natural uranium, balancing the U-235
+  FeedDraw large = pool.Draw(0.04, 5, 0.003);
+  EXPECT_TRUE(large.enough);
+  EXPECT_GT(large.qty, 10);
+  EXPECT_NEAR(5 * FeedPerProduct(large.assay, 0.04, 0.003), large.qty, 1e-9);
+
+  FeedDraw skipped = pool.Draw(0.04, 1, 0.003, 10);
+  EXPECT_NEAR(0.00711, skipped.assay, 1e-12);
+  EXPECT_NEAR(FeedPerProduct(0.00711, 0.04, 0.003), skipped.qty, 1e-9);
+
+  EXPECT_FALSE(pool.Draw(0.04, 1000, 0.003).enough);
+  EXPECT_FALSE(pool.Draw(0.04, 1, 0.008, 10).enough);
+}
+
+} // namespace mbmore
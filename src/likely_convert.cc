@@ -0,0 +1,135 @@
+#include "likely_convert.h"
+#include "behavior_functions.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace mbmore {
+
+const double LikelyConverter::kMaxEqnVal = 10.0;
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+LikelyConverter::LikelyConverter()
+  : hist_duration_(1),
+    step_duration_(1),
+    tabulated_(false),
+    n_intervals_(0),
+    inv_step_(0),
+    table_max_(0),
+    error_bound_(0) {}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void LikelyConverter::Init(std::string phase, std::string function,
+			   std::vector<double> constants,
+			   double hist_duration, double step_duration) {
+  phase_ = phase;
+  function_ = function;
+  constants_ = constants;
+  hist_duration_ = hist_duration;
+  step_duration_ = step_duration;
+  tabulated_ = false;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Determine the likelihood value for the equation at the current time,
+// (where the current value of the equation is normalized to be between 0-1)
+double LikelyConverter::Exact(double eqn_val) const {
+  double phase_likely;
+  if (phase_ == "Pursuit"){
+    double integ_likely;
+    // historical data defines the likelihood integrated over 70yrs, which is
+    // spread over the number of timesteps in that period
+    if ((function_ == "Power") || (function_ == "power")){
+      integ_likely = CalcYVal(function_, constants_, eqn_val/10.0);
+    }
+    else {
+      integ_likely = CalcYVal(function_, constants_, eqn_val);
+    }
+    phase_likely = ProbPerTime(integ_likely, hist_duration_/step_duration_);
+  }
+  else {
+    // for acquire, determine the avg time (N_years) to weapon based on score,
+    // which is a likelihood per year of 1/(N_years), then convert to the
+    // likelihood over one timestep
+    double avg_time = CalcYVal(function_, constants_, eqn_val);
+    phase_likely = ProbOverTime(1.0/avg_time, step_duration_);
+  }
+  return phase_likely;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Sample the exact equation on a uniform grid, doubling the number of grid
+// points until linear interpolation is within tol at the quarter points of
+// every interval. The table covers the part of 0-10 (in steps of the coarsest
+// grid) over which the equation is a valid likelihood, so that ie. a Power
+// equation that reaches an integrated likelihood of 1 at 10 is still
+// tabulated below that point.
+bool LikelyConverter::BuildTable(double tol, int max_points) {
+  tabulated_ = false;
+  error_bound_ = 0;
+  offset_.clear();
+  slope_.clear();
+  if (tol <= 0) {
+    return false;
+  }
+
+  int n_coarse = 64;
+  int n_valid = 0;
+  for (int i = 0; i <= n_coarse; i++) {
+    if (!Valid_(i * kMaxEqnVal / n_coarse)) {
+      break;
+    }
+    n_valid = i;
+  }
+  if (n_valid == 0) {
+    return false;
+  }
+  double table_max = n_valid * kMaxEqnVal / n_coarse;
+
+  for (int n = n_valid; n + 1 <= max_points; n *= 2) {
+    double step = table_max / n;
+    std::vector<double> y(n + 1);
+    for (int i = 0; i <= n; i++) {
+      y[i] = Exact(i * step);
+    }
+
+    offset_.resize(n);
+    slope_.resize(n);
+    double max_err = 0;
+    for (int i = 0; i < n; i++) {
+      slope_[i] = y[i + 1] - y[i];
+      offset_[i] = y[i] - i * slope_[i];
+      for (int q = 1; q < 4; q++) {
+	double u = i + 0.25 * q;
+	double err = std::fabs(offset_[i] + u * slope_[i] - Exact(u * step));
+	max_err = std::max(max_err, err);
+      }
+    }
+
+    if (max_err <= tol) {
+      n_intervals_ = n;
+      inv_step_ = 1.0 / step;
+      table_max_ = table_max;
+      error_bound_ = max_err;
+      tabulated_ = true;
+      return true;
+    }
+  }
+  offset_.clear();
+  slope_.clear();
+  return false;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+bool LikelyConverter::Valid_(double eqn_val) const {
+  double likely;
+  try {
+    likely = Exact(eqn_val);
+  }
+  catch (const char* e) {
+    return false;
+  }
+  return std::isfinite(likely) && (likely >= 0) && (likely <= 1);
+}
+
+} // namespace mbmore
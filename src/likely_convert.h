@@ -0,0 +1,91 @@
+#ifndef MBMORE_SRC_LIKELY_CONVERT_H_
+#define MBMORE_SRC_LIKELY_CONVERT_H_
+
+#include <string>
+#include <vector>
+
+namespace mbmore {
+
+// Converts the value of a Pursuit or Acquire equation (0-10) into a
+// likelihood of taking action at a single timestep, as defined by the
+// InteractRegion likely_converter.
+//
+// Exact evaluates the conversion equation directly. BuildTable samples it on
+// a uniform grid over [0, 10] so that Likely only needs a linear
+// interpolation (two multiply-adds). The grid is refined until the
+// interpolation error, measured between the grid points, is below the
+// requested tolerance. If that is not possible the converter keeps using
+// the exact equation. Values above the range where the equation is a valid
+// likelihood (ie. where ProbPerTime would throw) are not tabulated.
+class LikelyConverter {
+ public:
+  LikelyConverter();
+
+  // phase is Pursuit or Acquire, function and constants are as for CalcYVal.
+  // For Pursuit, hist_duration is the number of years over which the
+  // historical likelihood is integrated. For Acquire the equation gives the
+  // average time to a weapon in years. step_duration is the length of a
+  // timestep in years, so that the likelihood per timestep gives the same
+  // cumulative likelihood for any timestep duration.
+  void Init(std::string phase, std::string function,
+	    std::vector<double> constants, double hist_duration,
+	    double step_duration = 1.0);
+
+  // Likelihood from the conversion equation (no table)
+  double Exact(double eqn_val) const;
+
+  // Tries to tabulate the conversion with a maximum error of tol, using at
+  // most max_points grid points. Returns true if the table is used. A tol of
+  // zero (or less) always uses the exact equation.
+  bool BuildTable(double tol, int max_points = 1 << 16);
+
+  // Likelihood using the table when available and eqn_val is within the
+  // table, otherwise the exact equation.
+  inline double Likely(double eqn_val) const {
+    if (tabulated_ && (eqn_val >= 0) && (eqn_val <= table_max_)) {
+      double u = eqn_val * inv_step_;
+      int i = static_cast<int>(u);
+      if (i > n_intervals_ - 1) {
+	i = n_intervals_ - 1;
+      }
+      return offset_[i] + u * slope_[i];
+    }
+    return Exact(eqn_val);
+  }
+
+  bool tabulated() const { return tabulated_; }
+
+  // Largest interpolation error found while building the table
+  double error_bound() const { return error_bound_; }
+
+  int n_points() const { return tabulated_ ? n_intervals_ + 1 : 0; }
+
+  // Upper end of the tabulated range (at most kMaxEqnVal)
+  double table_max() const { return table_max_; }
+
+  static const double kMaxEqnVal;
+
+ private:
+  // Exact is defined and between 0-1
+  bool Valid_(double eqn_val) const;
+
+  std::string phase_;
+  std::string function_;
+  std::vector<double> constants_;
+  double hist_duration_;
+  double step_duration_;
+
+  bool tabulated_;
+  int n_intervals_;
+  double inv_step_;
+  double table_max_;
+  double error_bound_;
+  // each interval i is evaluated as offset_[i] + u * slope_[i], where u is
+  // eqn_val in units of the grid step
+  std::vector<double> offset_;
+  std::vector<double> slope_;
+};
+
+} // namespace mbmore
+
+#endif  //  MBMORE_SRC_LIKELY_CONVERT_H_
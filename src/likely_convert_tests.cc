@@ -0,0 +1,107 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+#include "behavior_functions.h"
+#include "likely_convert.h"
+
+namespace mbmore {
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Exact conversion matches the original GetLikely equations
+TEST(Likely_Convert_Test, Exact) {
+  std::vector<double> constants;
+  constants.push_back(2.0);
+  LikelyConverter pursuit;
+  pursuit.Init("Pursuit", "Power", constants, 75);
+  double integ = pow(0.5, 2.0);
+  EXPECT_DOUBLE_EQ(1 - pow(1 - integ, 1.0/75), pursuit.Exact(5.0));
+
+  std::vector<double> lin;
+  lin.push_back(20.0);
+  lin.push_back(-1.0);
+  LikelyConverter acquire;
+  acquire.Init("Acquire", "Linear", lin, 75);
+  EXPECT_DOUBLE_EQ(1.0/16.0, acquire.Exact(4.0));
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Table is within its error bound everywhere on 0-10
+TEST(Likely_Convert_Test, TableAccuracy) {
+  std::vector<double> constants;
+  constants.push_back(3.0);
+  LikelyConverter pursuit;
+  pursuit.Init("Pursuit", "Power", constants, 75);
+  double tol = 1e-7;
+  ASSERT_TRUE(pursuit.BuildTable(tol));
+  EXPECT_LE(pursuit.error_bound(), tol);
+  EXPECT_GT(pursuit.n_points(), 0);
+
+  // x^3 reaches 1 at 10, so the table stops one coarse step below
+  EXPECT_LT(pursuit.table_max(), 10.0);
+  EXPECT_GT(pursuit.table_max(), 9.8);
+  for (int i = 0; i < 1000; i++) {
+    double x = i * 0.01 + 0.0003;
+    EXPECT_NEAR(pursuit.Exact(x), pursuit.Likely(x), 2 * tol);
+  }
+  // above the table the exact equation is used
+  double x_high = 0.5 * (pursuit.table_max() + 10.0);
+  EXPECT_DOUBLE_EQ(pursuit.Exact(x_high), pursuit.Likely(x_high));
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Equations that are not valid likelihoods at 0 are not tabulated
+TEST(Likely_Convert_Test, ExactFallback) {
+  // Constant integrated likelihood of 1 (ProbPerTime throws)
+  std::vector<double> constants;
+  constants.push_back(1.0);
+  LikelyConverter pursuit;
+  pursuit.Init("Pursuit", "Constant", constants, 75);
+  EXPECT_FALSE(pursuit.BuildTable(1e-6));
+  EXPECT_FALSE(pursuit.tabulated());
+  EXPECT_EQ(0, pursuit.n_points());
+
+  // tolerance of zero always uses the exact equation
+  std::vector<double> lin;
+  lin.push_back(20.0);
+  lin.push_back(-1.0);
+  LikelyConverter acquire;
+  acquire.Init("Acquire", "Linear", lin, 75);
+  EXPECT_FALSE(acquire.BuildTable(0));
+  EXPECT_DOUBLE_EQ(acquire.Exact(3.3), acquire.Likely(3.3));
+  EXPECT_TRUE(acquire.BuildTable(1e-6));
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Monthly and yearly timesteps give the same cumulative likelihood
+TEST(Likely_Convert_Test, StepDuration) {
+  double tol = 1e-12;
+  std::vector<double> constants;
+  constants.push_back(2.0);
+  LikelyConverter p_year;
+  p_year.Init("Pursuit", "Power", constants, 75, 1.0);
+  LikelyConverter p_month;
+  p_month.Init("Pursuit", "Power", constants, 75, 1.0/12);
+  double year = p_year.Exact(6.0);
+  double month = p_month.Exact(6.0);
+  EXPECT_NEAR(year, 1 - pow(1 - month, 12), tol);
+  // over the full historical period both give the integrated likelihood
+  EXPECT_NEAR(0.36, 1 - pow(1 - month, 75 * 12), tol);
+
+  std::vector<double> lin;
+  lin.push_back(20.0);
+  lin.push_back(-1.0);
+  LikelyConverter a_year;
+  a_year.Init("Acquire", "Linear", lin, 75, 1.0);
+  LikelyConverter a_month;
+  a_month.Init("Acquire", "Linear", lin, 75, 1.0/12);
+  LikelyConverter a_decade;
+  a_decade.Init("Acquire", "Linear", lin, 75, 10.0);
+  year = a_year.Exact(4.0);
+  month = a_month.Exact(4.0);
+  EXPECT_DOUBLE_EQ(1.0/16.0, year);
+  EXPECT_NEAR(year, 1 - pow(1 - month, 12), tol);
+  EXPECT_NEAR(1 - pow(1 - year, 10), a_decade.Exact(4.0), tol);
+}
+
+} // namespace mbmore
@@ -0,0 +1,315 @@
+// Google Benchmark suite for the hot paths of the mbmore archetypes.
+//
+//   mbmore_bench [--benchmark_filter=regex]
+//                [--benchmark_out=results.json --benchmark_out_format=json]
+//
+// Microbenchmarks time a single call of CalcYVal, RNG_NormalDist, SortBids,
+// the SWU and NatU converters, the conflict score update behind
+// InteractRegion::GetConflictScore, and one StateInst weapon decision (played
+// with the decision model, which makes the same calculation).
+// Macrobenchmarks time whole runs as the number of states, enrichers and
+// sinks grows:
+//   BM_DecisionScenario/<states>   one replica of the weapon decisions
+//   BM_EnrichScenario/<sinks>      a RandomEnrich supplying <sinks> sinks
+//   BM_SinkScenario/<enrichers>    a RandomSink fed by <enrichers> suppliers
+//
+// The scenario benchmarks run cyclus::MockSim, which loads the archetypes
+// from CYCLUS_PATH (as the unit tests do). Use bench_compare.py in the top
+// level directory to compare the JSON output of two builds.
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "cyclus.h"
+
+#include "RandomEnrich.h"
+#include "behavior_functions.h"
+#include "conflict_network.h"
+#include "conflict_scores.h"
+#include "decision_model.h"
+#include "likely_convert.h"
+#include "rng_stream.h"
+
+using cyclus::Bid;
+using cyclus::Composition;
+using cyclus::Material;
+
+namespace {
+
+Composition::Ptr Uranium(double u235) {
+  cyclus::CompMap m;
+  m[922350000] = u235;
+  m[922380000] = 1 - u235;
+  return Composition::CreateFromMass(m);
+}
+
+// N states whose relations are a fixed mix of ally, neutral and enemy, with
+// every third state starting out pursuing and every fifth holding a weapon.
+mbmore::DecisionConfig ManyStates(int n_states, int duration) {
+  mbmore::DecisionConfig config;
+  config.duration = duration;
+  config.wts["Auth"] = 0.5;
+  config.wts["Conflict"] = 0.5;
+  std::vector<double> pursuit;
+  pursuit.push_back(0);
+  pursuit.push_back(0.01);
+  config.likely_rescale["Pursuit"] = mbmore::FactorEqn("Linear", pursuit);
+  std::vector<double> acquire(1, 20);
+  config.likely_rescale["Acquire"] = mbmore::FactorEqn("Constant", acquire);
+
+  for (int i = 0; i < n_states; i++) {
+    std::stringstream name;
+    name << "State" << i;
+    mbmore::StateConfig state;
+    state.name = name.str();
+    state.weapon_status = (i % 5 == 0) ? 3 : ((i % 3 == 0) ? 2 : 0);
+    std::vector<double> auth;
+    auth.push_back(2);
+    auth.push_back(0.05);
+    state.P_f["Auth"] = mbmore::FactorEqn("Linear", auth);
+    config.states.push_back(state);
+  }
+  for (int i = 0; i < n_states; i++) {
+    for (int j = 0; j < n_states; j++) {
+      if (i == j) {
+	continue;
+      }
+      config.p_conflict_map[std::make_pair(config.states[i].name,
+					   config.states[j].name)] =
+	((i + j) % 3) - 1;
+    }
+  }
+  return config;
+}
+
+} // namespace
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Microbenchmarks
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+
+void BM_CalcYVal(benchmark::State& state, std::string function,
+		 std::vector<double> constants) {
+  double x = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(mbmore::CalcYVal(function, constants, x));
+    x = (x < 10) ? x + 0.5 : 0;
+  }
+}
+BENCHMARK_CAPTURE(BM_CalcYVal, Constant, std::string("Constant"),
+		  std::vector<double>(1, 5.0));
+BENCHMARK_CAPTURE(BM_CalcYVal, Linear, std::string("Linear"),
+		  std::vector<double>(2, 0.5));
+BENCHMARK_CAPTURE(BM_CalcYVal, Power, std::string("Power"),
+		  std::vector<double>(2, 1.5));
+BENCHMARK_CAPTURE(BM_CalcYVal, Step, std::string("Step"),
+		  std::vector<double>(3, 4.0));
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void BM_RNG_NormalDist_Seed(benchmark::State& state) {
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(mbmore::RNG_NormalDist(5.0, 1.0, 12345));
+  }
+}
+BENCHMARK(BM_RNG_NormalDist_Seed);
+
+void BM_RNG_NormalDist_Stream(benchmark::State& state) {
+  mbmore::RngStream stream(12345, "bench", "normal");
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(mbmore::RNG_NormalDist(5.0, 1.0, stream));
+  }
+}
+BENCHMARK(BM_RNG_NormalDist_Stream);
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Sorting the feed bids of RandomEnrich::AdjustMatlPrefs
+void BM_SortBids(benchmark::State& state) {
+  int n_bids = state.range(0);
+  std::vector<Bid<Material>*> bids;
+  for (int i = 0; i < n_bids; i++) {
+    double u235 = 0.002 + 0.01 * ((i * 7919) % n_bids) / n_bids;
+    Material::Ptr offer = Material::CreateUntracked(10, Uranium(u235));
+    bids.push_back(Bid<Material>::Create(NULL, offer, NULL));
+  }
+  std::vector<Bid<Material>*> sorted;
+  for (auto _ : state) {
+    sorted = bids;
+    std::sort(sorted.begin(), sorted.end(), mbmore::SortBids);
+    benchmark::DoNotOptimize(sorted.data());
+  }
+  state.SetItemsProcessed(state.iterations() * n_bids);
+  for (int i = 0; i < n_bids; i++) {
+    delete bids[i];
+  }
+}
+BENCHMARK(BM_SortBids)->RangeMultiplier(4)->Range(4, 256);
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void BM_SWUConverter(benchmark::State& state) {
+  mbmore::SWUConverter converter(0.0072, 0.003);
+  Material::Ptr product = Material::CreateUntracked(10, Uranium(0.2));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(converter.convert(product));
+  }
+}
+BENCHMARK(BM_SWUConverter);
+
+void BM_NatUConverter(benchmark::State& state) {
+  mbmore::NatUConverter converter(0.0072, 0.003);
+  Material::Ptr product = Material::CreateUntracked(10, Uranium(0.2));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(converter.convert(product));
+  }
+}
+BENCHMARK(BM_NatUConverter);
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Conversion of the combined factor equation to a likelihood, exactly and
+// from the interpolation table
+void BM_LikelyConverter(benchmark::State& state) {
+  std::vector<double> pursuit(1, 0.1);
+  mbmore::LikelyConverter converter;
+  converter.Init("Pursuit", "Constant", pursuit, 75, 1.0 / 12);
+  if (state.range(0) == 1) {
+    converter.BuildTable(1e-9);
+  }
+  double eqn_val = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(converter.Likely(eqn_val));
+    eqn_val = (eqn_val < 10) ? eqn_val + 0.37 : 0;
+  }
+}
+BENCHMARK(BM_LikelyConverter)->Arg(0)->Arg(1);
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// InteractRegion::GetConflictScore for every state after a weapon status
+// change, which recomputes the scores of all states. The second variant has
+// no change between calls (the cached case).
+void BM_GetConflictScore(benchmark::State& state, bool changed) {
+  int n_states = state.range(0);
+  mbmore::RelationLists relations(n_states);
+  for (int i = 0; i < n_states; i++) {
+    for (int j = 0; j < n_states; j++) {
+      if (i != j) {
+	relations[i].push_back(std::make_pair(j, ((i + j) % 3) - 1));
+      }
+    }
+  }
+  std::vector<int> status(n_states, 0);
+  mbmore::ConflictScores scores;
+  mbmore::ConflictNetwork network;
+  network.Configure("Damped", 0, 0.5);
+  network.Update(relations, status, scores);
+
+  for (auto _ : state) {
+    if (changed) {
+      network.StatusChanged();
+    }
+    for (int i = 0; i < n_states; i++) {
+      network.Update(relations, status, scores);
+      benchmark::DoNotOptimize(network.Score(i));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * n_states);
+}
+BENCHMARK_CAPTURE(BM_GetConflictScore, Changed, true)
+->RangeMultiplier(4)->Range(4, 256);
+BENCHMARK_CAPTURE(BM_GetConflictScore, Cached, false)
+->RangeMultiplier(4)->Range(4, 256);
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// One StateInst::WeaponDecision: the factor equations, the conflict score,
+// the likelihood conversion and the draw
+void BM_WeaponDecision(benchmark::State& state) {
+  mbmore::DecisionConfig config = ManyStates(2, 1);
+  mbmore::DecisionModel model;
+  model.Init(config);
+  mbmore::ReplicaOutcome outcome;
+  uint64_t seed = 0;
+  for (auto _ : state) {
+    model.Run(seed++, &outcome);
+    benchmark::DoNotOptimize(outcome.weight);
+  }
+  state.SetItemsProcessed(state.iterations() * config.states.size());
+}
+BENCHMARK(BM_WeaponDecision);
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Macrobenchmarks
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+
+// Weapon decisions of every state over 10 years of monthly timesteps
+void BM_DecisionScenario(benchmark::State& state) {
+  mbmore::DecisionConfig config = ManyStates(state.range(0), 120);
+  mbmore::DecisionModel model;
+  model.Init(config);
+  mbmore::ReplicaOutcome outcome;
+  uint64_t seed = 0;
+  for (auto _ : state) {
+    model.Run(seed++, &outcome);
+    benchmark::DoNotOptimize(outcome.weight);
+  }
+  state.SetItemsProcessed(state.iterations() * config.duration);
+}
+BENCHMARK(BM_DecisionScenario)->RangeMultiplier(4)->Range(4, 256)
+->Unit(benchmark::kMicrosecond);
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// A RandomEnrich with a year of feed supplying HEU to n sinks each month
+void BM_EnrichScenario(benchmark::State& state) {
+  std::string config =
+    "   <feed_commod>natu</feed_commod> "
+    "   <feed_recipe>natu1</feed_recipe> "
+    "   <product_commod>enr_u</product_commod> "
+    "   <tails_commod>tails</tails_commod> "
+    "   <tails_assay>0.003</tails_assay> "
+    "   <initial_feed>100000</initial_feed> "
+    "   <swu_capacity>100000</swu_capacity> ";
+  int simdur = 12;
+  for (auto _ : state) {
+    state.PauseTiming();
+    cyclus::MockSim sim(cyclus::AgentSpec(":mbmore:RandomEnrich"), config,
+			simdur);
+    sim.AddRecipe("natu1", Uranium(0.0072));
+    sim.AddRecipe("heu", Uranium(0.2));
+    for (int i = 0; i < state.range(0); i++) {
+      sim.AddSink("enr_u").recipe("heu").capacity(1).Finalize();
+    }
+    state.ResumeTiming();
+    benchmark::DoNotOptimize(sim.Run());
+  }
+  state.SetItemsProcessed(state.iterations() * simdur);
+}
+BENCHMARK(BM_EnrichScenario)->RangeMultiplier(4)->Range(1, 64)
+->Unit(benchmark::kMillisecond);
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// A RandomSink buying LEU each month from n suppliers standing in for
+// enrichment facilities
+void BM_SinkScenario(benchmark::State& state) {
+  std::string config =
+    "   <in_commods><val>leu</val></in_commods> "
+    "   <recipe_name>leu</recipe_name> "
+    "   <max_inv_size>100000</max_inv_size> "
+    "   <capacity>10</capacity> ";
+  int simdur = 12;
+  for (auto _ : state) {
+    state.PauseTiming();
+    cyclus::MockSim sim(cyclus::AgentSpec(":mbmore:RandomSink"), config,
+			simdur);
+    sim.AddRecipe("leu", Uranium(0.04));
+    for (int i = 0; i < state.range(0); i++) {
+      sim.AddSource("leu").recipe("leu").capacity(1).Finalize();
+    }
+    state.ResumeTiming();
+    benchmark::DoNotOptimize(sim.Run());
+  }
+  state.SetItemsProcessed(state.iterations() * simdur);
+}
+BENCHMARK(BM_SinkScenario)->RangeMultiplier(4)->Range(1, 64)
+->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
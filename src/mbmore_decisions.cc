@@ -0,0 +1,272 @@
+// Monte Carlo driver for the StateInst/InteractRegion weapon decisions.
+// Reads a cyclus input file and plays many replicas of the pursuit and
+// acquire decisions, either in memory with the decision model or as full
+// cyclus simulations.
+//
+//   mbmore_decisions input.xml [-n replicas] [-s seed] [-j threads]
+//                    [-e] [-o histograms.csv] [-x command [-w dir]]
+//
+// Replicas are run on all cores unless -j is given.
+//
+// With -x, each replica is a cyclus simulation: the input file is written
+// to dir/replica_<i>.xml (dir is . unless -w is given) with rng_seed set to
+// seed + i on every StateInst, RandomEnrich and RandomSink, and
+// "command -o dir/replica_<i>.sqlite dir/replica_<i>.xml" is run (ie.
+// -x "cyclus -v 0"), -j simulations at a time. The decisions are read back
+// from each database as its simulation finishes, after which its files are
+// removed. The files of failed simulations are kept, and those replicas are
+// left out of the histograms.
+// The output has one row per state, event (Pursuit or Acquire) and timestep
+// with the number of replicas in which the event happened at that time.
+// Time -1 counts the replicas in which it never happened. Weight is the sum
+// of the likelihood ratio weights of those replicas, which is the same as
+// the count unless a StateInst sets pursuit_tilt or acquire_tilt.
+//
+// With -e, no replicas are played. The exact probability of each event at
+// each timestep is computed instead (see DecisionModel::Expected), and the
+// output has the columns State,Event,Time,Probability,Survival, where
+// Survival is the probability that the event has not happened by the end
+// of that timestep.
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "cyclus_run.h"
+#include "decision_input.h"
+#include "decision_model.h"
+#include "sweep_input.h"
+#include "work_pool.h"
+
+namespace {
+
+void Usage() {
+  std::cerr << "usage: mbmore_decisions input.xml [-n replicas] [-s seed] "
+	    << "[-j threads] [-e] [-o histograms.csv] [-x command [-w dir]]"
+	    << std::endl;
+}
+
+// Time of a state's event in a cyclus replica, -1 if it did not happen
+int EventTime(const std::map<std::string, int>& times,
+	      const std::string& state) {
+  std::map<std::string, int>::const_iterator it = times.find(state);
+  return (it == times.end()) ? -1 : it->second;
+}
+
+// Runs the replicas as cyclus simulations and adds their decisions to the
+// histograms of each state (in DecisionConfig order). Returns the number of
+// replicas that were added.
+long RunCyclusReplicas(const mbmore::SweepInput& base,
+		       const mbmore::DecisionConfig& config,
+		       const std::string& command, const std::string& dir,
+		       long n_replicas, unsigned long seed, int n_threads,
+		       std::vector<mbmore::TimeHistogram>* pursuit,
+		       std::vector<mbmore::TimeHistogram>* acquire) {
+  if (seed + n_replicas - 1 > INT_MAX) {
+    throw "seed + replicas must fit in rng_seed (an int) with -x";
+  }
+  std::mutex merge_mutex;
+  long n_done = 0;
+
+  // one replica per chunk, so that each worker keeps one simulation running
+  mbmore::WorkPool pool(n_threads);
+  pool.ParallelFor(n_replicas, 1, [&](long begin, long end, int worker) {
+    for (long i = begin; i < end; i++) {
+      mbmore::SweepInput replica = base;
+      replica.SetSeeds(int(seed + i));
+      std::stringstream file;
+      file << dir << "/replica_" << i << ".xml";
+      std::stringstream db;
+      db << dir << "/replica_" << i << ".sqlite";
+      {
+	std::ofstream replica_out(file.str().c_str());
+	if (!replica_out) {
+	  throw "could not write a replica input file";
+	}
+	replica.Write(replica_out);
+      }
+
+      int status = mbmore::RunCyclus(command, file.str(), db.str());
+      if ((status != 0) || !std::ifstream(db.str().c_str())) {
+	std::lock_guard<std::mutex> lock(merge_mutex);
+	std::cerr << "mbmore_decisions: " << file.str()
+		  << " failed with status " << status << std::endl;
+	continue;
+      }
+      mbmore::RunDecisions decisions = mbmore::ReadRunDecisions(db.str());
+      std::remove(db.str().c_str());
+      std::remove(file.str().c_str());
+
+      std::lock_guard<std::mutex> lock(merge_mutex);
+      for (int s = 0; s < config.states.size(); s++) {
+	const std::string& name = config.states[s].name;
+	(*pursuit)[s].Add(EventTime(decisions.pursuit_time, name),
+			  decisions.weight);
+	(*acquire)[s].Add(EventTime(decisions.acquire_time, name),
+			  decisions.weight);
+      }
+      n_done++;
+    }
+  });
+  return n_done;
+}
+
+void WriteHistogram(std::ostream& out, const std::string& state,
+		    const std::string& event,
+		    const mbmore::TimeHistogram& hist) {
+  out << state << "," << event << "," << -1 << "," << hist.never() << ","
+      << hist.never_weight() << "\n";
+  for (int t = 0; t < hist.counts().size(); t++) {
+    out << state << "," << event << "," << t << "," << hist.counts()[t]
+	<< "," << hist.weights()[t] << "\n";
+  }
+}
+
+void WriteExpected(std::ostream& out, const std::string& state,
+		   const std::string& event, const std::vector<double>& prob,
+		   const std::vector<double>& survival) {
+  double total = 0;
+  double time_sum = 0;
+  for (int t = 0; t < prob.size(); t++) {
+    out << state << "," << event << "," << t << "," << prob[t] << ","
+	<< survival[t] << "\n";
+    total += prob[t];
+    time_sum += t * prob[t];
+  }
+  std::cout << state << ": " << event << " probability " << total;
+  if (total > 0) {
+    std::cout << ", mean time " << time_sum / total;
+  }
+  std::cout << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+  std::string input_file;
+  std::string output_file = "decision_histograms.csv";
+  std::string command;
+  std::string write_dir = ".";
+  long n_replicas = 1000;
+  unsigned long seed = 0;
+  int n_threads = 0;
+  bool expected = false;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if ((arg == "-n") && (i + 1 < argc)) {
+      n_replicas = std::atol(argv[++i]);
+    }
+    else if ((arg == "-s") && (i + 1 < argc)) {
+      seed = std::strtoul(argv[++i], NULL, 10);
+    }
+    else if ((arg == "-j") && (i + 1 < argc)) {
+      n_threads = std::atoi(argv[++i]);
+    }
+    else if (arg == "-e") {
+      expected = true;
+    }
+    else if ((arg == "-o") && (i + 1 < argc)) {
+      output_file = argv[++i];
+    }
+    else if ((arg == "-x") && (i + 1 < argc)) {
+      command = argv[++i];
+    }
+    else if ((arg == "-w") && (i + 1 < argc)) {
+      write_dir = argv[++i];
+    }
+    else if ((arg[0] != '-') && input_file.empty()) {
+      input_file = arg;
+    }
+    else {
+      Usage();
+      return 1;
+    }
+  }
+  if (input_file.empty() || (n_replicas < 1) ||
+      (expected && !command.empty())) {
+    Usage();
+    return 1;
+  }
+
+  try {
+    mbmore::DecisionConfig config;
+    mbmore::ReadDecisionConfig(input_file, &config);
+
+    if (expected) {
+      mbmore::DecisionModel model;
+      model.Init(config);
+      mbmore::ExpectedOutcome outcome;
+      model.Expected(&outcome);
+
+      std::ofstream out(output_file.c_str());
+      out << "State,Event,Time,Probability,Survival\n";
+      for (int s = 0; s < model.n_states(); s++) {
+	WriteExpected(out, model.state_name(s), "Pursuit",
+		      outcome.pursuit_prob[s], outcome.pursuit_survival[s]);
+	WriteExpected(out, model.state_name(s), "Acquire",
+		      outcome.acquire_prob[s], outcome.acquire_survival[s]);
+      }
+      return 0;
+    }
+
+    std::vector<mbmore::TimeHistogram> pursuit;
+    std::vector<mbmore::TimeHistogram> acquire;
+    long n_done = n_replicas;
+    if (command.empty()) {
+      mbmore::DecisionEnsemble ensemble(config);
+      ensemble.Run(n_replicas, seed, n_threads);
+      for (int s = 0; s < config.states.size(); s++) {
+	pursuit.push_back(ensemble.pursuit(s));
+	acquire.push_back(ensemble.acquire(s));
+      }
+    }
+    else {
+      mbmore::SweepInput base;
+      std::ifstream input(input_file.c_str());
+      base.Read(input);
+      pursuit.resize(config.states.size());
+      acquire.resize(config.states.size());
+      for (int s = 0; s < config.states.size(); s++) {
+	pursuit[s].Init(config.duration);
+	acquire[s].Init(config.duration);
+      }
+      n_done = RunCyclusReplicas(base, config, command, write_dir,
+				 n_replicas, seed, n_threads, &pursuit,
+				 &acquire);
+      if (n_done == 0) {
+	throw "every cyclus replica failed";
+      }
+    }
+
+    std::ofstream out(output_file.c_str());
+    out << "State,Event,Time,Count,Weight\n";
+    for (int s = 0; s < config.states.size(); s++) {
+      const std::string& name = config.states[s].name;
+      WriteHistogram(out, name, "Pursuit", pursuit[s]);
+      WriteHistogram(out, name, "Acquire", acquire[s]);
+
+      // weighted, so that tilted runs report the untilted probabilities
+      double n_pursue = pursuit[s].event_weight();
+      double n_acquire = acquire[s].event_weight();
+      std::cout << name << ": pursued in " << n_pursue / n_done
+		<< ", acquired in " << n_acquire / n_done << " of " << n_done
+		<< " replicas" << std::endl;
+    }
+  }
+  catch (const char* e) {
+    std::cerr << "mbmore_decisions: " << e << std::endl;
+    return 1;
+  }
+  catch (const std::exception& e) {
+    std::cerr << "mbmore_decisions: " << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
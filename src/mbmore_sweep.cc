@@ -0,0 +1,244 @@
+// Parameter sweep driver for StateInst, InteractRegion, RandomEnrich and
+// RandomSink state variables. Generates a Latin hypercube or Sobol design
+// over the parameter ranges, and either plays each point in memory with the
+// decision model or writes one cyclus input file per point.
+//
+//   mbmore_sweep input.xml params.txt [-d lhs|sobol] [-p points]
+//                [-n replicas] [-s seed] [-j threads] [-o summary.csv]
+//                [-w dir [-x command]]
+//
+// params.txt has one swept state variable per line (see sweep_input.h):
+//   StateA pursuit_factors.item[factor=Auth].function.params.val[0] 0 10
+//   SuperRegion pursuit_weights.item[factor=Conflict].weight 0 0.3
+//
+// Without -w, every parameter must belong to a StateInst or InteractRegion.
+// Each point plays replicas of the weapon decisions from the same seed
+// (common random numbers across points), and one row per point is appended
+// to the summary as it finishes: the parameter values, followed by the
+// fraction of replicas in which each state pursued and acquired a weapon,
+// and its mean acquire time (blank if it never acquired).
+//
+// With -w, the input file of each point is written to dir/point_<i>.xml,
+// and the summary lists the parameter values and the file of each point. If
+// -x is given, "command -o dir/point_<i>.sqlite dir/point_<i>.xml" is run
+// for each point (ie. -x "cyclus -v 0"), and its output database and exit
+// status are added to the summary, followed by totals read back from the
+// database: the SWU and natural uranium of all RandomEnrich enrichments, and
+// the kg traded of each commodity (as commodity=kg pairs separated by ;).
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "cyclus_run.h"
+#include "decision_input.h"
+#include "decision_model.h"
+#include "rng_stream.h"
+#include "sweep_design.h"
+#include "sweep_input.h"
+
+namespace {
+
+void Usage() {
+  std::cerr << "usage: mbmore_sweep input.xml params.txt [-d lhs|sobol] "
+	    << "[-p points] [-n replicas] [-s seed] [-j threads] "
+	    << "[-o summary.csv] [-w dir [-x command]]" << std::endl;
+}
+
+// Weighted mean time of the replicas in which the event happened
+double MeanTime(const mbmore::TimeHistogram& hist) {
+  double sum = 0;
+  for (int t = 0; t < hist.weights().size(); t++) {
+    sum += t * hist.weights()[t];
+  }
+  return sum / hist.event_weight();
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+  std::vector<std::string> files;
+  std::string design_type = "lhs";
+  std::string output_file = "sweep_summary.csv";
+  std::string write_dir;
+  std::string command;
+  int n_points = 64;
+  long n_replicas = 1000;
+  unsigned long seed = 0;
+  int n_threads = 0;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if ((arg == "-d") && (i + 1 < argc)) {
+      design_type = argv[++i];
+    }
+    else if ((arg == "-p") && (i + 1 < argc)) {
+      n_points = std::atoi(argv[++i]);
+    }
+    else if ((arg == "-n") && (i + 1 < argc)) {
+      n_replicas = std::atol(argv[++i]);
+    }
+    else if ((arg == "-s") && (i + 1 < argc)) {
+      seed = std::strtoul(argv[++i], NULL, 10);
+    }
+    else if ((arg == "-j") && (i + 1 < argc)) {
+      n_threads = std::atoi(argv[++i]);
+    }
+    else if ((arg == "-o") && (i + 1 < argc)) {
+      output_file = argv[++i];
+    }
+    else if ((arg == "-w") && (i + 1 < argc)) {
+      write_dir = argv[++i];
+    }
+    else if ((arg == "-x") && (i + 1 < argc)) {
+      command = argv[++i];
+    }
+    else if ((arg[0] != '-') && (files.size() < 2)) {
+      files.push_back(arg);
+    }
+    else {
+      Usage();
+      return 1;
+    }
+  }
+  if ((files.size() != 2) || (n_points < 1) || (n_replicas < 1) ||
+      ((design_type != "lhs") && (design_type != "sobol")) ||
+      (!command.empty() && write_dir.empty())) {
+    Usage();
+    return 1;
+  }
+
+  try {
+    mbmore::SweepInput base;
+    std::ifstream input(files[0].c_str());
+    if (!input) {
+      throw "could not open the input file";
+    }
+    base.Read(input);
+
+    std::vector<mbmore::SweepParam> params;
+    std::ifstream param_input(files[1].c_str());
+    if (!param_input) {
+      throw "could not open the parameter file";
+    }
+    mbmore::ReadSweepParams(param_input, &params);
+    if (params.empty()) {
+      throw "no sweep parameters were given";
+    }
+    bool in_process = write_dir.empty();
+    for (int p = 0; p < params.size(); p++) {
+      std::string archetype = base.Archetype(params[p].agent);
+      if (in_process && (archetype != "StateInst") &&
+	  (archetype != "InteractRegion")) {
+	throw "RandomEnrich and RandomSink parameters need -w (the decision "
+	  "model does not simulate facilities)";
+      }
+    }
+
+    mbmore::Design design;
+    if (design_type == "sobol") {
+      mbmore::SobolSequence sobol(params.size());
+      design = sobol.Points(n_points);
+    }
+    else {
+      mbmore::RngStream rng(seed, "mbmore_sweep", "design");
+      design = mbmore::LatinHypercube(n_points, params.size(), rng);
+    }
+
+    mbmore::DecisionConfig base_config;
+    if (in_process) {
+      mbmore::ReadDecisionConfig(base.tree(), &base_config);
+    }
+
+    std::ofstream out(output_file.c_str());
+    out << "Point";
+    for (int p = 0; p < params.size(); p++) {
+      out << "," << params[p].name();
+    }
+    if (in_process) {
+      for (int s = 0; s < base_config.states.size(); s++) {
+	const std::string& name = base_config.states[s].name;
+	out << "," << name << ":Pursue," << name << ":Acquire,"
+	    << name << ":AcquireTime";
+      }
+    }
+    else {
+      out << ",InputFile";
+      if (!command.empty()) {
+	out << ",OutputFile,Status,SWU,NaturalU,Transactions";
+      }
+    }
+    out << std::endl;
+    out.precision(10);
+
+    for (int i = 0; i < n_points; i++) {
+      mbmore::SweepInput point = base;
+      out << i;
+      for (int p = 0; p < params.size(); p++) {
+	double val = params[p].Value(design[i][p]);
+	point.Set(params[p], val);
+	out << "," << val;
+      }
+
+      if (in_process) {
+	mbmore::DecisionConfig config;
+	mbmore::ReadDecisionConfig(point.tree(), &config);
+	mbmore::DecisionEnsemble ensemble(config);
+	ensemble.Run(n_replicas, seed, n_threads);
+	for (int s = 0; s < ensemble.model().n_states(); s++) {
+	  const mbmore::TimeHistogram& pursuit = ensemble.pursuit(s);
+	  const mbmore::TimeHistogram& acquire = ensemble.acquire(s);
+	  out << "," << pursuit.event_weight() / n_replicas
+	      << "," << acquire.event_weight() / n_replicas << ",";
+	  if (acquire.never() < n_replicas) {
+	    out << MeanTime(acquire);
+	  }
+	}
+      }
+      else {
+	std::stringstream file;
+	file << write_dir << "/point_" << i << ".xml";
+	std::ofstream point_out(file.str().c_str());
+	if (!point_out) {
+	  throw "could not write a point input file";
+	}
+	point.Write(point_out);
+	point_out.close();
+	out << "," << file.str();
+	if (!command.empty()) {
+	  // each point gets its own database rather than the default one
+	  std::stringstream db;
+	  db << write_dir << "/point_" << i << ".sqlite";
+	  int status = mbmore::RunCyclus(command, file.str(), db.str());
+	  out << "," << db.str() << "," << status << ",";
+	  // a failed run leaves the totals blank
+	  if ((status == 0) && std::ifstream(db.str().c_str())) {
+	    mbmore::RunTotals stats = mbmore::ReadRunTotals(db.str());
+	    out << stats.swu << "," << stats.natural_u << ",";
+	    std::map<std::string, double>::const_iterator it;
+	    for (it = stats.traded.begin(); it != stats.traded.end(); ++it) {
+	      out << ((it == stats.traded.begin()) ? "" : ";")
+		  << it->first << "=" << it->second;
+	    }
+	  }
+	  else {
+	    out << ",";
+	  }
+	}
+      }
+      out << std::endl;
+    }
+  }
+  catch (const char* e) {
+    std::cerr << "mbmore_sweep: " << e << std::endl;
+    return 1;
+  }
+  catch (const std::exception& e) {
+    std::cerr << "mbmore_sweep: " << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
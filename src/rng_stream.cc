@@ -0,0 +1,103 @@
+#include "rng_stream.h"
+
+#include <ctime>
+#include <sstream>
+
+namespace mbmore {
+
+namespace {
+
+uint64_t SplitMix64(uint64_t* x) {
+  uint64_t z = (*x += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+inline uint64_t Rotl(uint64_t x, int k) {
+  return (x << k) | (x >> (64 - k));
+}
+
+} // namespace
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+RngStream::RngStream() {
+  Seed(0, 0, 0);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+RngStream::RngStream(uint64_t seed, const std::string& owner,
+		     const std::string& purpose) {
+  Seed(seed, owner, purpose);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void RngStream::Seed(uint64_t seed, const std::string& owner,
+		     const std::string& purpose) {
+  Seed(seed, Hash(owner), Hash(purpose));
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Each part of the key is mixed in turn so that (seed, owner, purpose)
+// triples that differ in any part give unrelated streams
+void RngStream::Seed(uint64_t seed, uint64_t owner_hash,
+		     uint64_t purpose_hash) {
+  uint64_t x = seed;
+  uint64_t key = SplitMix64(&x);
+  x = key ^ owner_hash;
+  key = SplitMix64(&x);
+  x = key ^ purpose_hash;
+  for (int i = 0; i < 4; i++) {
+    s_[i] = SplitMix64(&x);
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+RngStream::result_type RngStream::operator()() {
+  uint64_t result = Rotl(s_[1] * 5, 7) * 9;
+  uint64_t t = s_[1] << 17;
+  s_[2] ^= s_[0];
+  s_[3] ^= s_[1];
+  s_[1] ^= s_[2];
+  s_[0] ^= s_[3];
+  s_[2] ^= t;
+  s_[3] = Rotl(s_[3], 45);
+  return result;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+double RngStream::Uniform() {
+  // top 53 bits give every representable double in [0, 1) with a step of
+  // 2^-53
+  return ((*this)() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+uint64_t RngStream::BaseSeed(int rng_seed) {
+  if (rng_seed == -1) {
+    return time(0);
+  }
+  return rng_seed;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+uint64_t RngStream::Hash(const std::string& name) {
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  for (int i = 0; i < name.size(); i++) {
+    hash ^= static_cast<unsigned char>(name[i]);
+    hash *= 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+std::string RngStream::Owner(const std::string& base, int n) {
+  if (n == 0) {
+    return base;
+  }
+  std::stringstream ss;
+  ss << base << "#" << n;
+  return ss.str();
+}
+
+} // namespace mbmore
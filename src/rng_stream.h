@@ -0,0 +1,79 @@
+#ifndef MBMORE_SRC_RNG_STREAM_H_
+#define MBMORE_SRC_RNG_STREAM_H_
+
+#include <cstdint>
+#include <string>
+
+namespace mbmore {
+
+// A random number stream that belongs to one owner (ie. an agent or a state)
+// and is used for one purpose (ie. tails sampling or the pursuit decision).
+//
+// The stream is seeded from a hash of (seed, owner, purpose), so its draws
+// do not depend on how many other streams exist or how often they are used.
+// Two runs with the same seed that differ only in policy inputs then use the
+// same random numbers for the same decisions (common random numbers), and
+// adding an agent does not shift the draws of any other agent.
+//
+// The generator is xoshiro256** (seeded with SplitMix64). It satisfies the
+// standard UniformRandomBitGenerator requirements, so it can be used with
+// the <random> distributions and with the behavior functions.
+class RngStream {
+ public:
+  typedef uint64_t result_type;
+
+  RngStream();
+  RngStream(uint64_t seed, const std::string& owner,
+	    const std::string& purpose);
+
+  void Seed(uint64_t seed, const std::string& owner,
+	    const std::string& purpose);
+
+  // Same as Seed with precomputed Hash values of the owner and purpose
+  void Seed(uint64_t seed, uint64_t owner_hash, uint64_t purpose_hash);
+
+  result_type operator()();
+
+  static constexpr result_type min() { return 0; }
+  static constexpr result_type max() { return UINT64_MAX; }
+
+  // Uniform random number in [0, 1)
+  double Uniform();
+
+  // Base seed for an agent's streams from its rng_seed state variable
+  // (the system time if rng_seed is -1)
+  static uint64_t BaseSeed(int rng_seed);
+
+  // Stable 64-bit hash of a name (FNV-1a), the same on every platform
+  static uint64_t Hash(const std::string& name);
+
+  // Returns base, followed by #n if n > 0
+  static std::string Owner(const std::string& base, int n);
+
+  // Stream owner of a cyclus agent: the prototypes of its parent and of the
+  // agent, numbered (see Owner) by how many of its siblings with the same
+  // prototype were created before it (have a lower id). The numbering only
+  // depends on the agents of the agent's own simulation.
+  template <class A>
+  static std::string AgentOwner(const A* agent);
+
+ private:
+  uint64_t s_[4];
+};
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+template <class A>
+std::string RngStream::AgentOwner(const A* agent) {
+  int n = 0;
+  for (const auto* sibling : agent->parent()->children()) {
+    if ((sibling->id() < agent->id()) &&
+	(sibling->prototype() == agent->prototype())) {
+      n++;
+    }
+  }
+  return Owner(agent->parent()->prototype() + "/" + agent->prototype(), n);
+}
+
+} // namespace mbmore
+
+#endif  //  MBMORE_SRC_RNG_STREAM_H_
@@ -0,0 +1,123 @@
+#include <gtest/gtest.h>
+
+#include <random>
+#include <set>
+#include <string>
+
+#include "behavior_functions.h"
+#include "rng_stream.h"
+
+namespace mbmore {
+
+namespace RngStreamTests {
+
+// the parts of a cyclus agent that RngStream::AgentOwner uses
+struct FakeAgent {
+  FakeAgent(int id, const std::string& proto, FakeAgent* parent)
+    : id_(id), proto_(proto), parent_(parent) {
+    if (parent != NULL) {
+      parent->children_.insert(this);
+    }
+  }
+  int id() const { return id_; }
+  std::string prototype() const { return proto_; }
+  FakeAgent* parent() const { return parent_; }
+  const std::set<FakeAgent*>& children() const { return children_; }
+
+  int id_;
+  std::string proto_;
+  FakeAgent* parent_;
+  std::set<FakeAgent*> children_;
+};
+
+} // namespace RngStreamTests
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// A stream only depends on its (seed, owner, purpose)
+TEST(Rng_Stream_Test, Reproducible) {
+  RngStream a(7, "StateA", "pursuit");
+  RngStream other(7, "StateB", "pursuit");
+  for (int i = 0; i < 50; i++) {
+    other();
+  }
+  RngStream b(7, "StateA", "pursuit");
+  for (int i = 0; i < 100; i++) {
+    EXPECT_EQ(a(), b());
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST(Rng_Stream_Test, DistinctStreams) {
+  RngStream base(7, "StateA", "pursuit");
+  RngStream seed(8, "StateA", "pursuit");
+  RngStream owner(7, "StateB", "pursuit");
+  RngStream purpose(7, "StateA", "acquire");
+  uint64_t x = base();
+  EXPECT_NE(x, seed());
+  EXPECT_NE(x, owner());
+  EXPECT_NE(x, purpose());
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST(Rng_Stream_Test, Uniform) {
+  RngStream rng(1, "owner", "purpose");
+  double sum = 0;
+  int n = 100000;
+  for (int i = 0; i < n; i++) {
+    double u = rng.Uniform();
+    ASSERT_GE(u, 0.0);
+    ASSERT_LT(u, 1.0);
+    sum += u;
+  }
+  EXPECT_NEAR(0.5, sum / n, 0.01);
+
+  // usable with the standard distributions
+  std::normal_distribution<double> normal(5.0, 1.0);
+  sum = 0;
+  for (int i = 0; i < n; i++) {
+    sum += normal(rng);
+  }
+  EXPECT_NEAR(5.0, sum / n, 0.02);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Behavior functions on a stream follow the stream, not the shared RNG
+TEST(Rng_Stream_Test, BehaviorFunctions) {
+  RngStream first(3, "RandomSink", "quantity");
+  RngStream second(3, "RandomSink", "quantity");
+  for (int i = 0; i < 20; i++) {
+    XLikely(0.5, 3);
+    EXPECT_DOUBLE_EQ(RNG_NormalDist(10, 2, first),
+		     RNG_NormalDist(10, 2, second));
+    EXPECT_EQ(XLikely(0.3, first), XLikely(0.3, second));
+    EXPECT_EQ(RNG_Integer(0, 5, first), RNG_Integer(0, 5, second));
+    EXPECT_EQ(EveryRandomXTimestep(4, first),
+	      EveryRandomXTimestep(4, second));
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST(Rng_Stream_Test, Owner) {
+  EXPECT_EQ("Test_Owner", RngStream::Owner("Test_Owner", 0));
+  EXPECT_EQ("Test_Owner#2", RngStream::Owner("Test_Owner", 2));
+  EXPECT_EQ(RngStream::Hash("abc"), RngStream::Hash("abc"));
+  EXPECT_NE(RngStream::Hash("abc"), RngStream::Hash("abd"));
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Agents with the same prototype and parent are numbered by creation order
+// within their own simulation, so a second simulation numbers them the same
+TEST(Rng_Stream_Test, AgentOwner) {
+  using RngStreamTests::FakeAgent;
+  for (int sim = 0; sim < 2; sim++) {
+    FakeAgent inst(1, "Inst", NULL);
+    FakeAgent other(2, "Other", &inst);
+    FakeAgent second(4, "Fac", &inst);
+    FakeAgent first(3, "Fac", &inst);
+    EXPECT_EQ("Inst/Fac", RngStream::AgentOwner(&first));
+    EXPECT_EQ("Inst/Fac#1", RngStream::AgentOwner(&second));
+    EXPECT_EQ("Inst/Other", RngStream::AgentOwner(&other));
+  }
+}
+
+} // namespace mbmore
@@ -0,0 +1,135 @@
+#include "sweep_design.h"
+
+#include <cmath>
+#include <utility>
+
+namespace mbmore {
+
+namespace {
+
+// Joe and Kuo (2008) direction numbers for dimensions 2-21 (new-joe-kuo-6):
+// degree s of the primitive polynomial, its coefficients a, and the initial
+// direction numbers m_1 .. m_s.
+struct SobolPoly {
+  int s;
+  int a;
+  uint32_t m[7];
+};
+
+const SobolPoly kSobolPolys[] = {
+  {1, 0, {1}},
+  {2, 1, {1, 3}},
+  {3, 1, {1, 3, 1}},
+  {3, 2, {1, 1, 1}},
+  {4, 1, {1, 1, 3, 3}},
+  {4, 4, {1, 3, 5, 13}},
+  {5, 2, {1, 1, 5, 5, 17}},
+  {5, 4, {1, 1, 5, 5, 5}},
+  {5, 7, {1, 1, 7, 11, 19}},
+  {5, 11, {1, 1, 5, 1, 1}},
+  {5, 13, {1, 1, 1, 3, 11}},
+  {5, 14, {1, 3, 5, 5, 31}},
+  {6, 1, {1, 3, 3, 9, 7, 49}},
+  {6, 13, {1, 1, 1, 15, 21, 21}},
+  {6, 16, {1, 3, 1, 13, 27, 49}},
+  {6, 19, {1, 1, 1, 15, 7, 5}},
+  {6, 22, {1, 3, 1, 15, 13, 25}},
+  {6, 25, {1, 1, 5, 5, 19, 61}},
+  {7, 1, {1, 3, 7, 11, 23, 15, 103}},
+  {7, 4, {1, 3, 7, 13, 13, 15, 69}},
+};
+
+} // namespace
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Points are placed in stratum perm[d][i] of dimension d, with a Fisher-Yates
+// shuffle drawn from the stream so that the design is the same on every
+// platform for a given seed.
+Design LatinHypercube(int n_points, int n_dims, RngStream& rng) {
+  Design points(n_points, std::vector<double>(n_dims));
+  std::vector<int> perm(n_points);
+  for (int d = 0; d < n_dims; d++) {
+    for (int i = 0; i < n_points; i++) {
+      perm[i] = i;
+    }
+    for (int i = n_points - 1; i > 0; i--) {
+      int j = std::floor(rng.Uniform() * (i + 1));
+      std::swap(perm[i], perm[j]);
+    }
+    for (int i = 0; i < n_points; i++) {
+      points[i][d] = (perm[i] + rng.Uniform()) / n_points;
+    }
+  }
+  return points;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+const int SobolSequence::kMaxDims =
+  1 + sizeof(kSobolPolys) / sizeof(kSobolPolys[0]);
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+SobolSequence::SobolSequence(int n_dims)
+  : n_dims_(n_dims),
+    index_(0),
+    v_(n_dims, std::vector<uint32_t>(kBits)),
+    x_(n_dims, 0) {
+  if (n_dims > kMaxDims) {
+    throw "Sobol designs support at most 21 parameters";
+  }
+  if (n_dims < 1) {
+    return;
+  }
+  // first dimension is the van der Corput sequence in base 2
+  for (int i = 0; i < kBits; i++) {
+    v_[0][i] = uint32_t(1) << (kBits - 1 - i);
+  }
+  for (int d = 1; d < n_dims; d++) {
+    const SobolPoly& poly = kSobolPolys[d - 1];
+    std::vector<uint32_t>& v = v_[d];
+    for (int i = 0; i < poly.s; i++) {
+      v[i] = poly.m[i] << (kBits - 1 - i);
+    }
+    for (int i = poly.s; i < kBits; i++) {
+      v[i] = v[i - poly.s] ^ (v[i - poly.s] >> poly.s);
+      for (int k = 1; k < poly.s; k++) {
+	if ((poly.a >> (poly.s - 1 - k)) & 1) {
+	  v[i] ^= v[i - k];
+	}
+      }
+    }
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Gray code update: point n+1 differs from point n by the direction number
+// of the lowest zero bit of n
+std::vector<double> SobolSequence::Next() {
+  std::vector<double> point(n_dims_);
+  for (int d = 0; d < n_dims_; d++) {
+    point[d] = std::ldexp(double(x_[d]), -kBits);
+  }
+  int c = 0;
+  while ((index_ >> c) & 1) {
+    c++;
+  }
+  if (c >= kBits) {
+    throw "Sobol sequence is exhausted";
+  }
+  for (int d = 0; d < n_dims_; d++) {
+    x_[d] ^= v_[d][c];
+  }
+  index_++;
+  return point;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+Design SobolSequence::Points(int n_points) {
+  Design points;
+  points.reserve(n_points);
+  for (int i = 0; i < n_points; i++) {
+    points.push_back(Next());
+  }
+  return points;
+}
+
+} // namespace mbmore
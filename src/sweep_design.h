@@ -0,0 +1,51 @@
+#ifndef MBMORE_SRC_SWEEP_DESIGN_H_
+#define MBMORE_SRC_SWEEP_DESIGN_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "rng_stream.h"
+
+namespace mbmore {
+
+// Space-filling designs over the unit hypercube [0, 1)^n_dims for parameter
+// sweeps. Each design is a list of n_points points of n_dims coordinates.
+typedef std::vector<std::vector<double> > Design;
+
+// Latin hypercube: each dimension is cut into n_points equal strata, and
+// every stratum holds exactly one point (at a random place within it). The
+// strata are paired across dimensions by an independent random permutation
+// per dimension.
+Design LatinHypercube(int n_points, int n_dims, RngStream& rng);
+
+// Sobol low-discrepancy sequence with the Joe and Kuo (2008) direction
+// numbers, generated in Gray code order. The first point is the origin.
+// The first 2^k points of every dimension are stratified like a Latin
+// hypercube, so n_points should be a power of two.
+class SobolSequence {
+ public:
+  // Largest number of dimensions with tabulated direction numbers
+  static const int kMaxDims;
+
+  // Throws if n_dims is larger than kMaxDims
+  explicit SobolSequence(int n_dims);
+
+  // Returns the next point of the sequence
+  std::vector<double> Next();
+
+  // Returns the next n_points points
+  Design Points(int n_points);
+
+ private:
+  static const int kBits = 32;
+
+  int n_dims_;
+  uint32_t index_;
+  // direction numbers [dim][bit], scaled to kBits bits
+  std::vector<std::vector<uint32_t> > v_;
+  std::vector<uint32_t> x_;
+};
+
+} // namespace mbmore
+
+#endif  //  MBMORE_SRC_SWEEP_DESIGN_H_
@@ -0,0 +1,62 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "sweep_design.h"
+
+namespace mbmore {
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Every stratum of every dimension holds exactly one point
+TEST(Sweep_Design_Test, LatinHypercube) {
+  int n_points = 50;
+  RngStream rng(1, "test", "design");
+  Design points = LatinHypercube(n_points, 3, rng);
+  ASSERT_EQ(n_points, points.size());
+  for (int d = 0; d < 3; d++) {
+    std::vector<int> count(n_points, 0);
+    for (int i = 0; i < n_points; i++) {
+      ASSERT_GE(points[i][d], 0.0);
+      ASSERT_LT(points[i][d], 1.0);
+      count[int(points[i][d] * n_points)]++;
+    }
+    for (int i = 0; i < n_points; i++) {
+      EXPECT_EQ(1, count[i]);
+    }
+  }
+
+  RngStream same(1, "test", "design");
+  EXPECT_EQ(points, LatinHypercube(n_points, 3, same));
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// First points of the unscrambled Sobol sequence, and stratification of the
+// first 2^k points in every dimension
+TEST(Sweep_Design_Test, Sobol) {
+  SobolSequence sobol(3);
+  Design points = sobol.Points(4);
+  double expected[4][3] = {{0, 0, 0}, {0.5, 0.5, 0.5},
+			   {0.75, 0.25, 0.25}, {0.25, 0.75, 0.75}};
+  for (int i = 0; i < 4; i++) {
+    for (int d = 0; d < 3; d++) {
+      EXPECT_DOUBLE_EQ(expected[i][d], points[i][d]);
+    }
+  }
+
+  int n_points = 256;
+  SobolSequence full(SobolSequence::kMaxDims);
+  Design all = full.Points(n_points);
+  for (int d = 0; d < SobolSequence::kMaxDims; d++) {
+    std::vector<int> count(n_points, 0);
+    for (int i = 0; i < n_points; i++) {
+      count[int(all[i][d] * n_points)]++;
+    }
+    for (int i = 0; i < n_points; i++) {
+      EXPECT_EQ(1, count[i]);
+    }
+  }
+
+  EXPECT_THROW(SobolSequence(SobolSequence::kMaxDims + 1), const char*);
+}
+
+} // namespace mbmore
@@ -0,0 +1,215 @@
+#include "sweep_input.h"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+#include <boost/property_tree/xml_parser.hpp>
+
+namespace mbmore {
+
+using boost::property_tree::ptree;
+
+namespace {
+
+bool Sweepable(const std::string& archetype) {
+  return (archetype == "StateInst") || (archetype == "InteractRegion") ||
+    (archetype == "RandomEnrich") || (archetype == "RandomSink");
+}
+
+// Searches the regions, their institutions and the facilities below node for
+// the agent, and returns its archetype config (ie. config.StateInst)
+const ptree* FindAgent(const ptree& node, const std::string& agent,
+		       std::string* archetype) {
+  ptree::const_iterator it;
+  for (it = node.begin(); it != node.end(); ++it) {
+    const std::string& kind = it->first;
+    if ((kind != "region") && (kind != "institution") &&
+	(kind != "facility")) {
+      continue;
+    }
+    boost::optional<const ptree&> config =
+      it->second.get_child_optional("config");
+    if ((it->second.get<std::string>("name", "") == agent) && config &&
+	!config->empty()) {
+      *archetype = config->begin()->first;
+      return &config->begin()->second;
+    }
+    if (kind == "region") {
+      const ptree* found = FindAgent(it->second, agent, archetype);
+      if (found != NULL) {
+	return found;
+      }
+    }
+  }
+  return NULL;
+}
+
+// Sets rng_seed of the seeded agents below node
+int SeedAgents(ptree* node, int seed) {
+  int n_set = 0;
+  ptree::iterator it;
+  for (it = node->begin(); it != node->end(); ++it) {
+    const std::string& kind = it->first;
+    if ((kind != "region") && (kind != "institution") &&
+	(kind != "facility")) {
+      continue;
+    }
+    boost::optional<ptree&> config = it->second.get_child_optional("config");
+    if (config && !config->empty()) {
+      const std::string& archetype = config->begin()->first;
+      if ((archetype == "StateInst") || (archetype == "RandomEnrich") ||
+	  (archetype == "RandomSink")) {
+	config->begin()->second.put("rng_seed", seed);
+	n_set++;
+      }
+    }
+    if (kind == "region") {
+      n_set += SeedAgents(&it->second, seed);
+    }
+  }
+  return n_set;
+}
+
+// Finds the child named by one path segment: name, name[i] or
+// name[field=value]. Returns NULL if there is none.
+ptree* FindChild(ptree* node, const std::string& segment, std::string* name) {
+  size_t open = segment.find('[');
+  *name = segment.substr(0, open);
+  std::string select;
+  if (open != std::string::npos) {
+    size_t close = segment.find(']', open);
+    if (close != std::string::npos) {
+      select = segment.substr(open + 1, close - open - 1);
+    }
+  }
+  size_t equals = select.find('=');
+
+  int index = 0;
+  if (!select.empty() && (equals == std::string::npos)) {
+    std::istringstream ss(select);
+    if (!(ss >> index)) {
+      throw "sweep parameter path has an invalid index";
+    }
+  }
+
+  ptree::iterator it;
+  for (it = node->begin(); it != node->end(); ++it) {
+    if (it->first != *name) {
+      continue;
+    }
+    if (equals != std::string::npos) {
+      std::string field = select.substr(0, equals);
+      std::string value = select.substr(equals + 1);
+      if (it->second.get<std::string>(field, "") == value) {
+	return &it->second;
+      }
+    }
+    else if (index-- == 0) {
+      return &it->second;
+    }
+  }
+  return NULL;
+}
+
+} // namespace
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+double SweepParam::Value(double u) const {
+  if (integer) {
+    double val = low + std::floor(u * (high - low + 1));
+    return std::min(val, high);
+  }
+  return low + u * (high - low);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void ReadSweepParams(std::istream& input, std::vector<SweepParam>* params) {
+  std::string line;
+  while (std::getline(input, line)) {
+    std::istringstream ss(line);
+    SweepParam param;
+    if (!(ss >> param.agent) || (param.agent[0] == '#')) {
+      continue;
+    }
+    if (!(ss >> param.path >> param.low >> param.high)) {
+      throw "could not read a sweep parameter (agent path low high [int])";
+    }
+    std::string type;
+    if (ss >> type) {
+      if (type != "int") {
+	throw "sweep parameter type must be int or omitted";
+      }
+      param.integer = true;
+    }
+    params->push_back(param);
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void SweepInput::Read(std::istream& input) {
+  tree_.clear();
+  boost::property_tree::read_xml(
+    input, tree_, boost::property_tree::xml_parser::trim_whitespace);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void SweepInput::Write(std::ostream& output) const {
+  boost::property_tree::write_xml(
+    output, tree_,
+    boost::property_tree::xml_writer_make_settings<std::string>(' ', 2));
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+std::string SweepInput::Archetype(const std::string& agent) const {
+  std::string archetype;
+  boost::optional<const ptree&> sim = tree_.get_child_optional("simulation");
+  if (!sim || (FindAgent(*sim, agent, &archetype) == NULL)) {
+    throw "sweep parameter agent is not in the input file";
+  }
+  if (!Sweepable(archetype)) {
+    throw "only StateInst, InteractRegion, RandomEnrich and RandomSink "
+      "agents can be swept";
+  }
+  return archetype;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void SweepInput::Set(const SweepParam& param, double value) {
+  std::string archetype = Archetype(param.agent);
+  ptree* node = const_cast<ptree*>(
+    FindAgent(tree_.get_child("simulation"), param.agent, &archetype));
+
+  std::istringstream path(param.path);
+  std::string segment;
+  std::string name;
+  bool last = false;
+  while (!last && std::getline(path, segment, '.')) {
+    last = path.peek() == std::char_traits<char>::eof();
+    ptree* child = FindChild(node, segment, &name);
+    if ((child == NULL) && last && (name == segment)) {
+      child = &node->push_back(ptree::value_type(name, ptree()))->second;
+    }
+    if (child == NULL) {
+      throw "sweep parameter path is not in the input file";
+    }
+    node = child;
+  }
+  if (param.integer) {
+    node->put_value(int(std::floor(value + 0.5)));
+  }
+  else {
+    node->put_value(value);
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+int SweepInput::SetSeeds(int seed) {
+  boost::optional<ptree&> sim = tree_.get_child_optional("simulation");
+  if (!sim) {
+    return 0;
+  }
+  return SeedAgents(&*sim, seed);
+}
+
+} // namespace mbmore
@@ -0,0 +1,76 @@
+#ifndef MBMORE_SRC_SWEEP_INPUT_H_
+#define MBMORE_SRC_SWEEP_INPUT_H_
+
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <boost/property_tree/ptree.hpp>
+
+namespace mbmore {
+
+// One swept input: a state variable of a named agent and its range.
+//
+// agent is the name of a region, institution or facility prototype in the
+// input file. path is the location of the value within the agent's archetype
+// config, as '.' separated element names. An element name may be followed by
+// [i] to pick the ith (from 0) element of that name, or by [field=value] to
+// pick the element whose child field holds value, ie.
+//   pursuit_factors.item[factor=Auth].function.params.val[0]
+//   pursuit_weights.item[factor=Conflict].weight
+//   tails_assay
+// If the last element does not exist, it is added (for state variables that
+// are left at their default in the input file).
+struct SweepParam {
+  SweepParam() : low(0), high(0), integer(false) {}
+
+  std::string agent;
+  std::string path;
+  double low;
+  double high;
+  // round the value to the nearest integer (ie. weapon_status or n_swipes)
+  bool integer;
+
+  // Column name for the parameter (agent:path)
+  std::string name() const { return agent + ":" + path; }
+
+  // Value at the unit coordinate u (0 <= u < 1) of a design. Integer
+  // parameters give each integer from low to high an equal share of [0, 1).
+  double Value(double u) const;
+};
+
+// Reads one parameter per line: agent path low high [int]. Blank lines and
+// lines starting with # are skipped.
+void ReadSweepParams(std::istream& input, std::vector<SweepParam>* params);
+
+// A cyclus input file whose agent state variables can be changed. Only the
+// archetypes of this module (StateInst, InteractRegion, RandomEnrich and
+// RandomSink) can be swept.
+class SweepInput {
+ public:
+  void Read(std::istream& input);
+  void Write(std::ostream& output) const;
+
+  // Name of the agent's archetype, ie. StateInst. Throws if there is no
+  // region, institution or facility with that name, or if its archetype
+  // cannot be swept.
+  std::string Archetype(const std::string& agent) const;
+
+  // Sets the value of a parameter. Throws if the path does not exist.
+  void Set(const SweepParam& param, double value);
+
+  // Sets rng_seed of every StateInst, RandomEnrich and RandomSink agent (the
+  // archetypes that make random draws), so that each replica of a scenario
+  // can be run with its own seed. Returns the number of agents set.
+  int SetSeeds(int seed);
+
+  const boost::property_tree::ptree& tree() const { return tree_; }
+
+ private:
+  boost::property_tree::ptree tree_;
+};
+
+} // namespace mbmore
+
+#endif  //  MBMORE_SRC_SWEEP_INPUT_H_
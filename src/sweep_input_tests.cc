@@ -0,0 +1,140 @@
+#include <gtest/gtest.h>
+
+#include <sstream>
+
+#include "decision_input.h"
+#include "sweep_input.h"
+
+namespace mbmore {
+
+namespace {
+
+const char* kInput =
+  "<simulation>"
+  " <control><duration>12</duration></control>"
+  " <region><name>SuperRegion</name>"
+  "  <config><InteractRegion>"
+  "   <pursuit_weights>"
+  "    <item><factor>Auth</factor> <weight>0.5</weight></item>"
+  "    <item><factor>Conflict</factor> <weight>0.5</weight></item>"
+  "   </pursuit_weights>"
+  "  </InteractRegion></config>"
+  "  <institution><name>StateA</name>"
+  "   <config><StateInst>"
+  "    <pursuit_factors>"
+  "     <item><factor>Auth</factor>"
+  "      <function><name>Linear</name>"
+  "       <params><val>1</val><val>0.1</val></params></function>"
+  "     </item>"
+  "    </pursuit_factors>"
+  "   </StateInst></config>"
+  "  </institution>"
+  " </region>"
+  " <facility><name>Enrichment</name>"
+  "  <config><RandomEnrich><tails_assay>0.003</tails_assay></RandomEnrich>"
+  "  </config>"
+  " </facility>"
+  " <facility><name>Mine</name>"
+  "  <config><Source><outcommod>u</outcommod></Source></config>"
+  " </facility>"
+  "</simulation>";
+
+SweepParam Param(std::string agent, std::string path, bool integer = false) {
+  SweepParam param;
+  param.agent = agent;
+  param.path = path;
+  param.low = 0;
+  param.high = 10;
+  param.integer = integer;
+  return param;
+}
+
+} // namespace
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST(Sweep_Input_Test, ReadParams) {
+  std::stringstream text;
+  text << "# agent path low high\n"
+       << "\n"
+       << "StateA pursuit_factors.item[factor=Auth].function.params.val[1]"
+       << " 0 0.5\n"
+       << "Enrichment n_swipes 1 20 int\n";
+  std::vector<SweepParam> params;
+  ReadSweepParams(text, &params);
+  ASSERT_EQ(2, params.size());
+  EXPECT_EQ("StateA", params[0].agent);
+  EXPECT_DOUBLE_EQ(0.5, params[0].high);
+  EXPECT_FALSE(params[0].integer);
+  EXPECT_TRUE(params[1].integer);
+
+  // integers from low to high each get an equal share of [0, 1)
+  EXPECT_DOUBLE_EQ(1, params[1].Value(0.0));
+  EXPECT_DOUBLE_EQ(20, params[1].Value(0.999));
+  EXPECT_DOUBLE_EQ(11, params[1].Value(0.5));
+  EXPECT_DOUBLE_EQ(0.25, params[0].Value(0.5));
+
+  std::stringstream bad("StateA weapon_status 0");
+  EXPECT_THROW(ReadSweepParams(bad, &params), const char*);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST(Sweep_Input_Test, Set) {
+  std::stringstream xml(kInput);
+  SweepInput input;
+  input.Read(xml);
+  EXPECT_EQ("StateInst", input.Archetype("StateA"));
+  EXPECT_EQ("InteractRegion", input.Archetype("SuperRegion"));
+  EXPECT_EQ("RandomEnrich", input.Archetype("Enrichment"));
+  EXPECT_THROW(input.Archetype("Mine"), const char*);
+  EXPECT_THROW(input.Archetype("StateB"), const char*);
+
+  input.Set(Param("StateA",
+		  "pursuit_factors.item[factor=Auth].function.params.val[1]"),
+	    0.25);
+  input.Set(Param("SuperRegion", "pursuit_weights.item[1].weight"), 0.75);
+  // state variables at their default are added
+  input.Set(Param("StateA", "weapon_status", true), 1.6);
+  input.Set(Param("Enrichment", "tails_assay"), 0.002);
+  EXPECT_THROW(input.Set(Param("StateA", "pursuit_factors.item[3].factor"),
+			 1), const char*);
+
+  DecisionConfig config;
+  ReadDecisionConfig(input.tree(), &config);
+  EXPECT_DOUBLE_EQ(0.75, config.wts["Conflict"]);
+  EXPECT_DOUBLE_EQ(0.25, config.states[0].P_f["Auth"].second[1]);
+  EXPECT_EQ(2, config.states[0].weapon_status);
+  EXPECT_DOUBLE_EQ(0.002, input.tree().get<double>(
+    "simulation.facility.config.RandomEnrich.tails_assay"));
+
+  // written file reads back the same
+  std::stringstream written;
+  input.Write(written);
+  DecisionConfig reread;
+  ReadDecisionConfig(written, &reread);
+  EXPECT_DOUBLE_EQ(0.25, reread.states[0].P_f["Auth"].second[1]);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST(Sweep_Input_Test, SetSeeds) {
+  std::stringstream xml(kInput);
+  SweepInput input;
+  input.Read(xml);
+
+  // the StateInst and RandomEnrich, not the InteractRegion or Source
+  EXPECT_EQ(2, input.SetSeeds(7));
+  EXPECT_EQ(7, input.tree().get<int>(
+    "simulation.region.institution.config.StateInst.rng_seed"));
+  EXPECT_EQ(7, input.tree().get<int>(
+    "simulation.facility.config.RandomEnrich.rng_seed"));
+  EXPECT_FALSE(input.tree().get_optional<int>(
+    "simulation.region.config.InteractRegion.rng_seed"));
+
+  // a second call replaces the seeds
+  input.SetSeeds(8);
+  EXPECT_EQ(8, input.tree().get<int>(
+    "simulation.facility.config.RandomEnrich.rng_seed"));
+  EXPECT_EQ(1, input.tree().get_child(
+    "simulation.facility.config.RandomEnrich").count("rng_seed"));
+}
+
+} // namespace mbmore
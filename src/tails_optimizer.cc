@@ -0,0 +1,119 @@
+#include "tails_optimizer.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "feed_blend.h"
+
+namespace mbmore {
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TailsOptimizer::TailsOptimizer(double min_tails, double max_tails,
+			       double tol, int max_entries)
+  : min_tails_(min_tails),
+    max_tails_(max_tails),
+    tol_(tol),
+    max_entries_(max_entries),
+    n_searches_(0),
+    n_cached_(0) {
+  if ((min_tails <= 0) || (max_tails < min_tails)) {
+    throw "tails assay band must be positive and not empty";
+  }
+  if ((tol <= 0) || (max_entries < 1)) {
+    throw "tol and max_entries must be positive";
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+double TailsOptimizer::Deliverable(double feed_assay, double product_assay,
+				   double tails_assay, double swu,
+				   double feed_u) {
+  if ((tails_assay >= feed_assay) || (feed_assay >= product_assay)) {
+    return 0;
+  }
+  double by_swu = swu / SwuPerProduct(feed_assay, product_assay,
+				      tails_assay);
+  double by_feed = feed_u / FeedPerProduct(feed_assay, product_assay,
+					   tails_assay);
+  return std::max(0.0, std::min(by_swu, by_feed));
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TailsOptimizer::Entry_& TailsOptimizer::Lookup_(double feed_assay,
+						double product_assay) {
+  std::pair<long, long> key(std::lround(feed_assay / tol_),
+			    std::lround(product_assay / tol_));
+  std::map<std::pair<long, long>, Entry_>::iterator it = cache_.find(key);
+  if (it != cache_.end()) {
+    return it->second;
+  }
+  if (cache_.size() >= max_entries_) {
+    cache_.clear();
+  }
+  Entry_ e;
+  e.hi = std::max(min_tails_, std::min(max_tails_, feed_assay - tol_));
+  e.lo_ratio = SwuPerProduct(feed_assay, product_assay, min_tails_) /
+    FeedPerProduct(feed_assay, product_assay, min_tails_);
+  e.hi_ratio = SwuPerProduct(feed_assay, product_assay, e.hi) /
+    FeedPerProduct(feed_assay, product_assay, e.hi);
+  e.ratio = -1;
+  e.best = min_tails_;
+  return cache_[key] = e;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+double TailsOptimizer::Best(double feed_assay, double product_assay,
+			    double swu, double feed_u) {
+  if ((feed_assay <= min_tails_ + tol_) || (feed_assay >= product_assay) ||
+      (swu <= 0) || (feed_u <= 0)) {
+    return min_tails_;
+  }
+  Entry_& e = Lookup_(feed_assay, product_assay);
+  double ratio = swu / feed_u;
+
+  // SWU per kg of feed falls as the tails assay rises. If there is more SWU
+  // per kg of feed than needed at the bottom of the band, feed binds
+  // throughout and the lowest tails assay is best; if less than needed at
+  // the top, SWU binds throughout and the highest is best.
+  if (ratio >= e.lo_ratio) {
+    n_cached_++;
+    return min_tails_;
+  }
+  if (ratio <= e.hi_ratio) {
+    n_cached_++;
+    return e.hi;
+  }
+  if (ratio == e.ratio) {
+    n_cached_++;
+    return e.best;
+  }
+
+  n_searches_++;
+  const double inv_phi = (std::sqrt(5.0) - 1) / 2;
+  double a = min_tails_;
+  double b = e.hi;
+  double c = b - inv_phi * (b - a);
+  double d = a + inv_phi * (b - a);
+  double pc = Deliverable(feed_assay, product_assay, c, swu, feed_u);
+  double pd = Deliverable(feed_assay, product_assay, d, swu, feed_u);
+  while (b - a > tol_) {
+    if (pc >= pd) {
+      b = d;
+      d = c;
+      pd = pc;
+      c = b - inv_phi * (b - a);
+      pc = Deliverable(feed_assay, product_assay, c, swu, feed_u);
+    } else {
+      a = c;
+      c = d;
+      pc = pd;
+      d = a + inv_phi * (b - a);
+      pd = Deliverable(feed_assay, product_assay, d, swu, feed_u);
+    }
+  }
+  e.ratio = ratio;
+  e.best = (a + b) / 2;
+  return e.best;
+}
+
+} // namespace mbmore
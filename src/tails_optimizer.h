@@ -0,0 +1,71 @@
+#ifndef MBMORE_SRC_TAILS_OPTIMIZER_H_
+#define MBMORE_SRC_TAILS_OPTIMIZER_H_
+
+#include <map>
+#include <utility>
+
+namespace mbmore {
+
+// Chooses the tails assay, within a band [min_tails, max_tails], that lets an
+// enrichment facility deliver the most product in a timestep. With swu SWU
+// and feed_u kg of uranium feed on hand, the product that can be made at
+// tails assay xt is
+//
+//   P(xt) = min(swu / SwuPerProduct(xf, xp, xt),
+//               feed_u / FeedPerProduct(xf, xp, xt))
+//
+// The first term grows with xt (less SWU per kg of product) and the second
+// falls (more feed per kg), so P is unimodal and is maximised by a
+// golden-section search over the band.
+//
+// The search depends on the ratio of SWU to feed only through where the two
+// terms cross, at the tails assay whose SWU per kg of feed equals
+// swu / feed_u. For each (feed assay, product assay) pair the SWU per kg of
+// feed at both ends of the band, and the last search, are cached, so steps
+// where one constraint binds across the whole band, or the ratio is
+// unchanged, need no search. Assays are rounded to tol for the cache key, and
+// the cache is cleared when it holds max_entries pairs, so that feed whose
+// assay drifts from step to step does not grow it without bound.
+class TailsOptimizer {
+ public:
+  // tol is the width of the final bracket of the search
+  explicit TailsOptimizer(double min_tails = 0.003, double max_tails = 0.003,
+			  double tol = 1e-7, int max_entries = 1024);
+
+  // Best tails assay for feed at feed_assay and product at product_assay
+  double Best(double feed_assay, double product_assay, double swu,
+	      double feed_u);
+
+  // kg of product deliverable at a tails assay (0 if it cannot be made)
+  static double Deliverable(double feed_assay, double product_assay,
+			    double tails_assay, double swu, double feed_u);
+
+  int n_searches() const { return n_searches_; }
+  int n_cached() const { return n_cached_; }
+  int n_entries() const { return cache_.size(); }
+
+ private:
+  struct Entry_ {
+    // SWU per kg of feed at min_tails_ and at the top of the usable band
+    double lo_ratio;
+    double hi_ratio;
+    double hi;
+    // last search: swu / feed_u and the tails assay found
+    double ratio;
+    double best;
+  };
+
+  Entry_& Lookup_(double feed_assay, double product_assay);
+
+  double min_tails_;
+  double max_tails_;
+  double tol_;
+  int max_entries_;
+  std::map<std::pair<long, long>, Entry_> cache_;
+  int n_searches_;
+  int n_cached_;
+};
+
+} // namespace mbmore
+
+#endif  //  MBMORE_SRC_TAILS_OPTIMIZER_H_
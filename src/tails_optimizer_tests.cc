@@ -0,0 +1,67 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+
+#include "feed_blend.h"
+#include "tails_optimizer.h"
+
+namespace mbmore {
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Deliverable product is limited by whichever of SWU and feed runs out first
+TEST(Tails_Optimizer_Test, Deliverable) {
+  double by_swu = 100 / SwuPerProduct(0.00711, 0.04, 0.003);
+  double by_feed = 1000 / FeedPerProduct(0.00711, 0.04, 0.003);
+  EXPECT_NEAR(std::min(by_swu, by_feed),
+	      TailsOptimizer::Deliverable(0.00711, 0.04, 0.003, 100, 1000),
+	      1e-9);
+  EXPECT_EQ(0, TailsOptimizer::Deliverable(0.00711, 0.04, 0.008, 100, 1000));
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// When one constraint binds across the band, the best tails assay is at the
+// end of the band that eases it
+TEST(Tails_Optimizer_Test, Corners) {
+  TailsOptimizer opt(0.002, 0.004);
+  // plenty of SWU: save feed with the lowest tails assay
+  EXPECT_DOUBLE_EQ(0.002, opt.Best(0.00711, 0.04, 1e6, 1000));
+  // plenty of feed: save SWU with the highest tails assay
+  EXPECT_DOUBLE_EQ(0.004, opt.Best(0.00711, 0.04, 1, 1e6));
+  EXPECT_EQ(0, opt.n_searches());
+  EXPECT_THROW(TailsOptimizer(0.004, 0.002), const char*);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Otherwise the search finds where both run out together, and repeats of the
+// same step are taken from the cache
+TEST(Tails_Optimizer_Test, Balanced) {
+  TailsOptimizer opt(0.002, 0.004);
+  double feed_u = 1000;
+  double swu = feed_u * SwuPerProduct(0.00711, 0.04, 0.003) /
+    FeedPerProduct(0.00711, 0.04, 0.003);
+  double best = opt.Best(0.00711, 0.04, swu, feed_u);
+  EXPECT_NEAR(0.003, best, 1e-6);
+  EXPECT_EQ(1, opt.n_searches());
+  EXPECT_DOUBLE_EQ(best, opt.Best(0.00711, 0.04, swu, feed_u));
+  EXPECT_EQ(1, opt.n_searches());
+  EXPECT_EQ(1, opt.n_cached());
+  EXPECT_GT(TailsOptimizer::Deliverable(0.00711, 0.04, best, swu, feed_u),
+	    TailsOptimizer::Deliverable(0.00711, 0.04, 0.0025, swu, feed_u));
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Assays within tol share a cache entry, and the cache does not grow past
+// max_entries as the feed assay drifts
+TEST(Tails_Optimizer_Test, CacheBound) {
+  TailsOptimizer opt(0.002, 0.004, 1e-7, 4);
+  opt.Best(0.00711, 0.04, 1e6, 1000);
+  opt.Best(0.00711 + 1e-9, 0.04, 1e6, 1000);
+  EXPECT_EQ(1, opt.n_entries());
+  for (int i = 0; i < 10; i++) {
+    opt.Best(0.00711 + i * 1e-5, 0.04, 1e6, 1000);
+    EXPECT_LE(opt.n_entries(), 4);
+  }
+  EXPECT_THROW(TailsOptimizer(0.002, 0.004, 1e-7, 0), const char*);
+}
+
+} // namespace mbmore
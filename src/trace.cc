@@ -0,0 +1,155 @@
+#include "trace.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+
+namespace mbmore {
+
+namespace {
+
+// Each tracer has its own id, so that a thread's cached buffer is never used
+// with a different tracer (even one created at the same address)
+std::atomic<int> next_tracer_id(0);
+
+thread_local int cached_tracer_id = -1;
+thread_local TraceBuffer* cached_buffer = NULL;
+
+void WriteString(std::ostream& out, const std::string& s) {
+  out << '"';
+  for (int i = 0; i < s.size(); i++) {
+    if ((s[i] == '"') || (s[i] == '\\')) {
+      out << '\\';
+    }
+    out << s[i];
+  }
+  out << '"';
+}
+
+} // namespace
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+Tracer::Tracer()
+  : id_(next_tracer_id++),
+    start_(std::chrono::steady_clock::now()) {}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+Tracer::~Tracer() {
+  if (n_events() == 0) {
+    return;
+  }
+  const char* path = std::getenv("MBMORE_TRACE");
+  std::ofstream out((path != NULL) ? path : "mbmore_trace.json");
+  WriteJson(out);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+Tracer& Tracer::Instance() {
+  static Tracer tracer;
+  return tracer;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TraceBuffer& Tracer::buffer() {
+  if (cached_tracer_id == id_) {
+    return *cached_buffer;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  buffers_.push_back(std::unique_ptr<TraceBuffer>(new TraceBuffer));
+  cached_buffer = buffers_.back().get();
+  cached_buffer->thread = buffers_.size() - 1;
+  cached_tracer_id = id_;
+  return *cached_buffer;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+bool Tracer::Seen_(TraceBuffer* buffer, int agent_id) {
+  if (agent_id >= buffer->seen.size()) {
+    buffer->seen.resize(agent_id + 1, false);
+  }
+  if (buffer->seen[agent_id]) {
+    return true;
+  }
+  buffer->seen[agent_id] = true;
+  return false;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void Tracer::Add(const char* name, cyclus::Agent* agent, int time,
+		 int64_t begin, int64_t end) {
+  TraceBuffer& buf = buffer();
+  int agent_id = agent->id();
+  if (!Seen_(&buf, agent_id)) {
+    buf.agents.push_back(std::make_pair(agent_id, agent->prototype()));
+  }
+  TraceEvent event = {name, agent_id, time, begin, end};
+  buf.events.push_back(event);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void Tracer::Add(const char* name, int agent_id,
+		 const std::string& agent_name, int time, int64_t begin,
+		 int64_t end) {
+  TraceBuffer& buf = buffer();
+  if (!Seen_(&buf, agent_id)) {
+    buf.agents.push_back(std::make_pair(agent_id, agent_name));
+  }
+  TraceEvent event = {name, agent_id, time, begin, end};
+  buf.events.push_back(event);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+size_t Tracer::n_events() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  size_t n = 0;
+  for (int b = 0; b < buffers_.size(); b++) {
+    n += buffers_[b]->events.size();
+  }
+  return n;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Agents are the tracks (tid) of a single process, and the slices are
+// complete ("X") events with times in microseconds
+void Tracer::WriteJson(std::ostream& out) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+  out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,"
+      << "\"args\":{\"name\":\"mbmore\"}}";
+
+  std::vector<bool> named;
+  for (int b = 0; b < buffers_.size(); b++) {
+    const TraceBuffer& buf = *buffers_[b];
+    for (int a = 0; a < buf.agents.size(); a++) {
+      int agent_id = buf.agents[a].first;
+      if (agent_id >= named.size()) {
+	named.resize(agent_id + 1, false);
+      }
+      if (named[agent_id]) {
+	continue;
+      }
+      named[agent_id] = true;
+      out << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":"
+	  << agent_id << ",\"args\":{\"name\":";
+      WriteString(out, buf.agents[a].second);
+      out << "}}";
+    }
+  }
+
+  out.precision(15);
+  for (int b = 0; b < buffers_.size(); b++) {
+    const TraceBuffer& buf = *buffers_[b];
+    for (int e = 0; e < buf.events.size(); e++) {
+      const TraceEvent& event = buf.events[e];
+      out << ",\n{\"name\":\"" << event.name
+	  << "\",\"cat\":\"mbmore\",\"ph\":\"X\",\"pid\":0,\"tid\":"
+	  << event.agent_id << ",\"ts\":" << event.begin * 1e-3
+	  << ",\"dur\":" << (event.end - event.begin) * 1e-3
+	  << ",\"args\":{\"time\":" << event.time << ",\"thread\":"
+	  << buf.thread << "}}";
+    }
+  }
+  out << "\n]}\n";
+}
+
+} // namespace mbmore
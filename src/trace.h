@@ -0,0 +1,123 @@
+#ifndef MBMORE_SRC_TRACE_H_
+#define MBMORE_SRC_TRACE_H_
+
+#include <cstdint>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "cyclus.h"
+
+namespace mbmore {
+
+// One completed span: what an agent was doing from begin to end (ns since
+// the tracer was created) during a timestep
+struct TraceEvent {
+  const char* name;
+  int agent_id;
+  int time;
+  int64_t begin;
+  int64_t end;
+};
+
+// Events recorded by one thread. Only that thread appends to it, so no lock
+// is taken when recording.
+struct TraceBuffer {
+  int thread;
+  std::vector<TraceEvent> events;
+  // agent ids in the order they were first seen, and their prototype names
+  std::vector<std::pair<int, std::string> > agents;
+  std::vector<bool> seen;
+};
+
+// Collects spans of mbmore agent activity and writes them as Chrome trace
+// JSON (loads in Perfetto or chrome://tracing). Each agent is shown as its
+// own track, named after its prototype, with one slice per span; the
+// timestep is in the slice arguments.
+//
+// The agents only record spans when the module is built with
+// MBMORE_TRACING defined (cmake -DMBMORE_TRACING=ON). The trace is then
+// written when the simulation exits, to the file named by the MBMORE_TRACE
+// environment variable (mbmore_trace.json by default).
+class Tracer {
+ public:
+  Tracer();
+
+  // Writes the trace to the file named by MBMORE_TRACE, if anything was
+  // recorded
+  ~Tracer();
+
+  // The tracer used by the agents
+  static Tracer& Instance();
+
+  // Nanoseconds since the tracer was created
+  inline int64_t Now() const {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now() - start_).count();
+  }
+
+  // The calling thread's buffer (created on the thread's first call)
+  TraceBuffer& buffer();
+
+  // Records a span of an agent in the calling thread's buffer. The agent's
+  // prototype is only looked up the first time the agent is seen.
+  void Add(const char* name, cyclus::Agent* agent, int time, int64_t begin,
+	   int64_t end);
+
+  // Same for an agent given by id and name
+  void Add(const char* name, int agent_id, const std::string& agent_name,
+	   int time, int64_t begin, int64_t end);
+
+  // Number of spans recorded by all threads
+  size_t n_events() const;
+
+  // Writes all spans as a Chrome trace (JSON object format). Should only be
+  // called once the recording threads are done.
+  void WriteJson(std::ostream& out) const;
+
+ private:
+  // True if the agent was already seen by this buffer, otherwise marks it
+  // as seen
+  static bool Seen_(TraceBuffer* buffer, int agent_id);
+
+  int id_;
+  std::chrono::steady_clock::time_point start_;
+  mutable std::mutex mutex_;
+  std::vector<std::unique_ptr<TraceBuffer> > buffers_;
+};
+
+// Records a span for an agent from its construction to its destruction
+class TraceSpan {
+ public:
+  TraceSpan(const char* name, cyclus::Agent* agent)
+    : name_(name),
+      agent_(agent),
+      time_(agent->context()->time()),
+      begin_(Tracer::Instance().Now()) {}
+
+  ~TraceSpan() {
+    Tracer& tracer = Tracer::Instance();
+    tracer.Add(name_, agent_, time_, begin_, tracer.Now());
+  }
+
+ private:
+  const char* name_;
+  cyclus::Agent* agent_;
+  int time_;
+  int64_t begin_;
+};
+
+} // namespace mbmore
+
+// Traces the rest of the enclosing agent member function as a span
+#ifdef MBMORE_TRACING
+#define MBMORE_TRACE(name) mbmore::TraceSpan mbmore_trace_span_(name, this)
+#else
+#define MBMORE_TRACE(name)
+#endif
+
+#endif  //  MBMORE_SRC_TRACE_H_
@@ -0,0 +1,61 @@
+#include <gtest/gtest.h>
+
+#include <sstream>
+#include <thread>
+
+#include <boost/property_tree/json_parser.hpp>
+
+#include "trace.h"
+
+namespace mbmore {
+
+namespace TraceTests {
+
+// Records n spans of one agent from the calling thread
+void RecordSpans(Tracer* tracer, int agent_id, int n) {
+  for (int t = 0; t < n; t++) {
+    int64_t begin = tracer->Now();
+    tracer->Add("Tick", agent_id, "Enrich \"A\"", t, begin, begin + 1500);
+  }
+}
+
+} // namespace TraceTests
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Spans from several threads are all written, and the output is valid JSON
+// with one track name per agent
+TEST(Trace_Test, WriteJson) {
+  Tracer tracer;
+  std::thread first(TraceTests::RecordSpans, &tracer, 3, 10);
+  std::thread second(TraceTests::RecordSpans, &tracer, 4, 5);
+  first.join();
+  second.join();
+  TraceTests::RecordSpans(&tracer, 3, 2);
+  EXPECT_EQ(17, tracer.n_events());
+
+  std::stringstream json;
+  tracer.WriteJson(json);
+  boost::property_tree::ptree tree;
+  boost::property_tree::read_json(json, tree);
+
+  int n_spans = 0;
+  int n_names = 0;
+  boost::property_tree::ptree::const_iterator it;
+  const boost::property_tree::ptree& events = tree.get_child("traceEvents");
+  for (it = events.begin(); it != events.end(); ++it) {
+    const boost::property_tree::ptree& event = it->second;
+    if (event.get<std::string>("ph") == "X") {
+      n_spans++;
+      EXPECT_EQ("Tick", event.get<std::string>("name"));
+      EXPECT_DOUBLE_EQ(1.5, event.get<double>("dur"));
+    }
+    else if (event.get<std::string>("name") == "thread_name") {
+      n_names++;
+      EXPECT_EQ("Enrich \"A\"", event.get<std::string>("args.name"));
+    }
+  }
+  EXPECT_EQ(17, n_spans);
+  EXPECT_EQ(2, n_names);
+}
+
+} // namespace mbmore
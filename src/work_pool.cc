@@ -0,0 +1,110 @@
+#include "work_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace mbmore {
+
+namespace {
+
+typedef std::pair<long, long> Chunk;
+
+// Chunks owned by one worker
+struct WorkQueue {
+  std::mutex mutex;
+  std::deque<Chunk> chunks;
+};
+
+// Takes a chunk from the back of the worker's own queue, otherwise steals
+// from the front of the other queues. Returns false when all are empty.
+bool NextChunk(std::vector<WorkQueue>& queues, int worker, Chunk* chunk) {
+  int n = queues.size();
+  for (int i = 0; i < n; i++) {
+    int victim = (worker + i) % n;
+    std::lock_guard<std::mutex> lock(queues[victim].mutex);
+    std::deque<Chunk>& chunks = queues[victim].chunks;
+    if (chunks.empty()) {
+      continue;
+    }
+    if (victim == worker) {
+      *chunk = chunks.back();
+      chunks.pop_back();
+    }
+    else {
+      *chunk = chunks.front();
+      chunks.pop_front();
+    }
+    return true;
+  }
+  return false;
+}
+
+} // namespace
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+WorkPool::WorkPool(int n_threads) : n_threads_(n_threads) {
+  if (n_threads_ < 1) {
+    n_threads_ = std::thread::hardware_concurrency();
+  }
+  if (n_threads_ < 1) {
+    n_threads_ = 1;
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void WorkPool::ParallelFor(long n_items, long chunk_size,
+			   const std::function<void(long, long, int)>& func) {
+  if (n_items <= 0) {
+    return;
+  }
+  if (chunk_size < 1) {
+    chunk_size = 1;
+  }
+
+  // Deal out contiguous blocks of chunks, so that each worker starts on its
+  // own part of the range
+  long n_chunks = (n_items + chunk_size - 1) / chunk_size;
+  std::vector<WorkQueue> queues(n_threads_);
+  for (long c = 0; c < n_chunks; c++) {
+    long begin = c * chunk_size;
+    long end = std::min(begin + chunk_size, n_items);
+    queues[c * n_threads_ / n_chunks].chunks.push_back(Chunk(begin, end));
+  }
+
+  std::atomic<bool> failed(false);
+  std::exception_ptr error;
+  std::mutex error_mutex;
+
+  std::vector<std::thread> threads;
+  for (int w = 0; w < n_threads_; w++) {
+    threads.push_back(std::thread([&, w]() {
+      Chunk chunk;
+      while (!failed && NextChunk(queues, w, &chunk)) {
+	try {
+	  func(chunk.first, chunk.second, w);
+	}
+	catch (...) {
+	  std::lock_guard<std::mutex> lock(error_mutex);
+	  if (!failed) {
+	    error = std::current_exception();
+	    failed = true;
+	  }
+	}
+      }
+    }));
+  }
+  for (int w = 0; w < n_threads_; w++) {
+    threads[w].join();
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+} // namespace mbmore
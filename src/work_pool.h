@@ -0,0 +1,36 @@
+#ifndef MBMORE_SRC_WORK_POOL_H_
+#define MBMORE_SRC_WORK_POOL_H_
+
+#include <functional>
+
+namespace mbmore {
+
+// Runs a loop over independent items (ie. replicas) on several threads.
+//
+// The items are split into chunks that are dealt out evenly to the workers'
+// queues. Each worker takes chunks from the back of its own queue, and when
+// it runs out it steals from the front of the queue of another worker, so
+// threads that finish early keep busy when chunks take uneven amounts of
+// time.
+class WorkPool {
+ public:
+  // n_threads of 0 uses one thread per hardware core
+  explicit WorkPool(int n_threads = 0);
+
+  int n_threads() const { return n_threads_; }
+
+  // Calls func(begin, end, worker) for chunks of at most chunk_size items
+  // that together cover [0, n_items) exactly once. worker is the index
+  // (0 to n_threads - 1) of the thread running the chunk, so func can keep
+  // per-thread state. Returns when all chunks are done. If func throws, the
+  // remaining chunks are skipped and the first exception is rethrown.
+  void ParallelFor(long n_items, long chunk_size,
+		   const std::function<void(long, long, int)>& func);
+
+ private:
+  int n_threads_;
+};
+
+} // namespace mbmore
+
+#endif  //  MBMORE_SRC_WORK_POOL_H_
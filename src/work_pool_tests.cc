@@ -0,0 +1,64 @@
+#include <gtest/gtest.h>
+
+#include <mutex>
+#include <vector>
+
+#include "work_pool.h"
+
+namespace mbmore {
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Every item is run exactly once, on a valid worker
+TEST(Work_Pool_Test, CoversRange) {
+  WorkPool pool(4);
+  EXPECT_EQ(4, pool.n_threads());
+
+  long n = 10007;
+  std::vector<int> runs(n, 0);
+  std::vector<int> workers(n, -1);
+  pool.ParallelFor(n, 100, [&](long begin, long end, int worker) {
+    for (long i = begin; i < end; i++) {
+      runs[i]++;
+      workers[i] = worker;
+    }
+  });
+  for (long i = 0; i < n; i++) {
+    EXPECT_EQ(1, runs[i]);
+    EXPECT_GE(workers[i], 0);
+    EXPECT_LT(workers[i], 4);
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Chunks are stolen when one worker's chunks are slow
+TEST(Work_Pool_Test, Stealing) {
+  WorkPool pool(2);
+  std::vector<int> chunk_workers(8, -1);
+  pool.ParallelFor(8, 1, [&](long begin, long end, int worker) {
+    chunk_workers[begin] = worker;
+    if (worker == 0) {
+      // worker 0 is slow and should not run all of its own chunks
+      volatile double x = 0;
+      for (int i = 0; i < 20000000; i++) {
+	x = x + 1;
+      }
+    }
+  });
+  int n_worker1 = 0;
+  for (int c = 0; c < 8; c++) {
+    n_worker1 += (chunk_workers[c] == 1);
+  }
+  EXPECT_GT(n_worker1, 4);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST(Work_Pool_Test, Exception) {
+  WorkPool pool(3);
+  EXPECT_ANY_THROW(pool.ParallelFor(100, 1, [](long begin, long, int) {
+    if (begin == 50) {
+      throw "fail";
+    }
+  }));
+}
+
+} // namespace mbmore
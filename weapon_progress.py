@@ -0,0 +1,111 @@
+#! /usr/bin/env python
+"""Writes the WeaponProgress table of a cyclus SQLite output file as a CSV
+with one row per state and timestep, as written by InteractRegion's Dense
+progress_record mode.
+
+    python weapon_progress.py output.sqlite -o weapon_progress.csv
+
+In Delta mode a state only writes its row when it differs from its previous
+decision (or at a keyframe). Each row is therefore carried forward until the
+next row of the same state. After its last row, a state keeps deciding until
+it decides yes, leaves the simulation or the simulation ends. A Dense table
+is written out unchanged.
+"""
+from __future__ import print_function
+import csv
+import sqlite3
+import sys
+
+try:
+    import argparse as ap
+except ImportError:
+    import pyne._argparse as ap
+
+
+def table_exists(conn, name):
+    cur = conn.execute("SELECT name FROM sqlite_master WHERE type='table' "
+                       "AND name=?", (name,))
+    return cur.fetchone() is not None
+
+
+def last_times(conn):
+    """Last timestep at which each agent can decide."""
+    duration = conn.execute("SELECT Duration FROM Info").fetchone()[0]
+    last = {}
+    if table_exists(conn, 'AgentExit'):
+        for agent, exit_time in conn.execute(
+                "SELECT AgentId, ExitTime FROM AgentExit"):
+            last[agent] = min(exit_time, duration - 1)
+    return last, duration - 1
+
+
+def dense_rows(conn):
+    """Yields the column names, then the rows of the dense table."""
+    cur = conn.execute("SELECT * FROM WeaponProgress ORDER BY AgentId, Time")
+    columns = [c[0] for c in cur.description]
+    yield [c for c in columns if c != 'SimId']
+    keep = [i for i, c in enumerate(columns) if c != 'SimId']
+    i_time = columns.index('Time')
+    i_agent = columns.index('AgentId')
+    i_decision = columns.index('Decision')
+    last, sim_last = last_times(conn)
+
+    prev = None
+    for row in cur:
+        if prev is not None:
+            if prev[i_agent] == row[i_agent]:
+                end = row[i_time] - 1
+            else:
+                end = final_time(prev, i_agent, i_decision, last, sim_last)
+            for out in fill(prev, end, i_time, keep):
+                yield out
+        prev = row
+    if prev is not None:
+        end = final_time(prev, i_agent, i_decision, last, sim_last)
+        for out in fill(prev, end, i_time, keep):
+            yield out
+
+
+def final_time(row, i_agent, i_decision, last, sim_last):
+    """Time up to which the last row of a state is carried forward (None if
+    the state stopped deciding with it)."""
+    if row[i_decision]:
+        return None
+    return last.get(row[i_agent], sim_last)
+
+
+def fill(row, end, i_time, keep):
+    """The row at its own time, then copies of it up to time end."""
+    out = [row[i] for i in keep]
+    yield out
+    if end is None:
+        return
+    k_time = keep.index(i_time)
+    for t in range(row[i_time] + 1, end + 1):
+        copy = list(out)
+        copy[k_time] = t
+        yield copy
+
+
+def main():
+    description = 'Rebuild the dense WeaponProgress table of a cyclus run.'
+    parser = ap.ArgumentParser(description=description)
+    parser.add_argument('db', help='cyclus SQLite output file')
+    parser.add_argument('-o', '--output', default=None,
+                        help='CSV file to write (default: standard output)')
+    args = parser.parse_args()
+
+    conn = sqlite3.connect(args.db)
+    if args.output is None:
+        out = sys.stdout
+    else:
+        out = open(args.output, 'w')
+    writer = csv.writer(out)
+    for row in dense_rows(conn):
+        writer.writerow(row)
+    if args.output is not None:
+        out.close()
+
+
+if __name__ == '__main__':
+    main()